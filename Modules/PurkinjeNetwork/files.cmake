@@ -33,12 +33,38 @@ set(H_FILES
     sv4gui_PurkinjeNetworkUtils.h
     sv4gui_PurkinjeNetworkFolder.h
     sv4gui_PurkinjeNetwork.h
+    sv4gui_PurkinjeNetworkActivation.h
+    sv4gui_PurkinjeNetworkCable.h
+    sv4gui_PurkinjeNetworkColonization.h
+    sv4gui_PurkinjeNetworkCoupling.h
+    sv4gui_PurkinjeNetworkCoverage.h
+    sv4gui_PurkinjeNetworkGraph.h
+    sv4gui_PurkinjeNetworkOperation.h
+    sv4gui_PurkinjeNetworkPartition.h
+    sv4gui_PurkinjeNetworkReorder.h
+    sv4gui_PurkinjeNetworkResample.h
+    sv4gui_PurkinjeNetworkSegmentTree.h
+    sv4gui_PurkinjeNetworkSurfaceActivation.h
+    sv4gui_PurkinjeNetworkVolumeActivation.h
 )
 
 set(CPP_FILES
     sv4gui_PurkinjeNetworkIO.cxx
     sv4gui_PurkinjeNetworkUtils.cxx
     sv4gui_PurkinjeNetwork.cxx
+    sv4gui_PurkinjeNetworkActivation.cxx
+    sv4gui_PurkinjeNetworkCable.cxx
+    sv4gui_PurkinjeNetworkColonization.cxx
+    sv4gui_PurkinjeNetworkCoupling.cxx
+    sv4gui_PurkinjeNetworkCoverage.cxx
+    sv4gui_PurkinjeNetworkGraph.cxx
+    sv4gui_PurkinjeNetworkOperation.cxx
+    sv4gui_PurkinjeNetworkPartition.cxx
+    sv4gui_PurkinjeNetworkReorder.cxx
+    sv4gui_PurkinjeNetworkResample.cxx
+    sv4gui_PurkinjeNetworkSegmentTree.cxx
+    sv4gui_PurkinjeNetworkSurfaceActivation.cxx
+    sv4gui_PurkinjeNetworkVolumeActivation.cxx
 )
 
 set(RESOURCE_FILES
@@ -51,7 +51,7 @@ class Branch:
         self._logger = logging.getLogger('fractal-tree')
         #
         shared_node=-1
-        init_normal=mesh.normals[init_tri]
+        init_normal=mesh.get_normal(init_tri)
         nodes.update_collision_tree(brother_nodes)
 #        global_nnodes=len(nodes.nodes)
         
@@ -82,7 +82,7 @@ class Branch:
                 shared_node=collision[0]
                 break
             grad=nodes.gradient(self.queue[i])
-            normal=mesh.normals[self.triangles[i],:]
+            normal=mesh.get_normal(self.triangles[i])
             #Project the gradient to the surface
             grad=grad-(np.dot(grad,normal))*normal
             dir=(dir+w*grad)/np.linalg.norm(dir+w*grad)
@@ -110,7 +110,7 @@ class Branch:
         
         """
        # print 'node trying to project', init_node+dir
-        point, triangle=mesh.project_new_point(init_node+dir)
+        point, triangle=mesh.move_point(init_node,self.triangles[-1],dir)
        # print 'Projected point', point, 'dist', np.linalg.norm(point-init_node)
         if triangle>=0:
             self.queue.append(point)
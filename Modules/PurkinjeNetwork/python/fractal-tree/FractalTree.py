@@ -4,29 +4,87 @@ This module contains the function that creates the fractal tree.
 """
 import logging 
 import sys
+import time
 import numpy as np
  #   from PlaneParameters import * #Network properties.
 from Branch3D import *
 from random import shuffle
+from ImplicitSurface import ImplicitSurface
 from Mesh import Mesh
+from ParameterizedMesh import ParameterizedMesh
 import logging
 
-def Fractal_Tree_3D(param):
+class Tree:
+    """ This class stores the state of a growing fractal tree so growth can be 
+        stopped after any branch generation and resumed later.
+
+    Attributes:
+        param (Parameters object): the parameters that define the tree.
+        mesh (Mesh object): the surface mesh the tree is grown on.
+        branches (dict): A dictionary that contains all the branches objects.
+        nodes (nodes object): the object that contains all the nodes of the tree.
+        ien (list): the node indices of each segment.
+        last_branch (int): the index of the last branch added.
+        branches_to_grow (list): the branches growing children in the next generation.
+        generation (int): the number of complete branch generations.
+    """
+    def __init__(self, param, mesh):
+        self.param = param
+        self.mesh = mesh
+        self.branches = {}
+        self.nodes = None
+        self.ien = []
+        self.last_branch = 0
+        self.branches_to_grow = []
+        self.generation = 0
+
+    def is_complete(self):
+        """ Return True if all branch generations have been grown.
+        """
+        return self.generation >= self.param.N_it or len(self.branches_to_grow) == 0
+
+def Fractal_Tree_3D(param, mesh=None):
     """ This fuction creates the fractal tree.
 
     Args:
         param (Parameters object): this object contains all the parameters that 
             define the tree. See the parameters module documentation for details:
+        mesh (Mesh object): the surface mesh to grow the tree on. If None the mesh is 
+            read from param.input_file_name. Passing a mesh avoids reading and 
+            preprocessing it again when growing several trees on the same surface.
         
     Returns:
         branches (dict): A dictionary that contains all the branches objects.
         nodes (nodes object): the object that contains all the nodes of the tree.
 
     """
+    tree = create_tree(param, mesh)
+    if tree is None:
+        return None, None
+
+    grow_tree(tree, param.time_budget)
+
+    if param.save:
+        write_tree(tree)
+
+    return tree.branches, tree.nodes, tree.ien
+
+def create_tree(param, mesh=None):
+    """ This function creates the initial branch and fascicles of the fractal tree.
+
+    Returns:
+        tree (Tree object): the tree with no branch generations grown.
+    """
     logger = logging.getLogger('fractal-tree')
 
     # Read mesh
-    mesh = Mesh(param.input_file_name)
+    if mesh is None:
+        if param.surface_mapping == "harmonic":
+            mesh = ParameterizedMesh(param.input_file_name)
+        elif param.surface_mapping == "implicit":
+            mesh = ImplicitSurface(param.sdf_file_name)
+        else:
+            mesh = Mesh(param.input_file_name)
 
     # Define the initial direction
     init_dir = (param.second_node-param.init_node)/np.linalg.norm(param.second_node-param.init_node)
@@ -41,7 +99,7 @@ def Fractal_Tree_3D(param):
         init_tri=tri
     else:
         logger.error('initial point not in mesh')
-        return None, None
+        return None
 
     #Initialize the dictionary that stores the branches objects
     branches={}
@@ -69,9 +127,41 @@ def Fractal_Tree_3D(param):
                 ien.append([branches[last_branch].nodes[i_n],branches[last_branch].nodes[i_n+1]])                 
         branches_to_grow=range(1,len(param.fascicles_angles)+1)
 
-        
-    ## [DaveP] Fix xrange for python 3.5.
-    for i in range(param.N_it):
+    tree = Tree(param, mesh)
+    tree.branches = branches
+    tree.nodes = nodes
+    tree.ien = ien
+    tree.last_branch = last_branch
+    tree.branches_to_grow = list(branches_to_grow)
+    return tree
+
+def grow_tree(tree, time_budget=0.0):
+    """ This function grows the remaining branch generations of a tree.
+
+    Generations are grown one at a time. If 'time_budget' is greater than 0 and 
+    growing takes longer than 'time_budget' seconds then the branches of the 
+    generation being grown are removed so the tree ends with its last complete 
+    generation. Growth can be resumed by calling grow_tree() again.
+
+    Returns:
+        complete (bool): True if all branch generations have been grown.
+    """
+    logger = logging.getLogger('fractal-tree')
+    param = tree.param
+    mesh = tree.mesh
+    branches = tree.branches
+    nodes = tree.nodes
+    ien = tree.ien
+    start_time = time.time()
+
+    while not tree.is_complete():
+        branches_to_grow = tree.branches_to_grow
+        last_branch = tree.last_branch
+        num_nodes = len(nodes.nodes)
+        num_end_nodes = len(nodes.end_nodes)
+        num_segments = len(ien)
+        expired = False
+
         ## [DaveP] Fix for python 3.5.
         shuffle(list(branches_to_grow))
         #shuffle(branches_to_grow)  
@@ -101,20 +191,56 @@ def Fractal_Tree_3D(param):
                 
                 branches[g].child[j]=last_branch
                 angle=-angle                
-        branches_to_grow=new_branches_to_grow
-        
-    if param.save:
-        if param.save_paraview:
-            from ParaviewWriter import write_line_VTU
-            logger.info('Finished growing, writing paraview file')
-            xyz=np.zeros((len(nodes.nodes),3))
-            for i in range(len(nodes.nodes)):
-                xyz[i,:]=nodes.nodes[i]                    
-            write_line_VTU(xyz, ien, param.output_file_name + '.vtu')                
-        
-        np.savetxt(param.output_file_name +'_ien.txt',ien,fmt='%d')
-        np.savetxt(param.output_file_name +'_xyz.txt',xyz)
-        np.savetxt(param.output_file_name +'_endnodes.txt',nodes.end_nodes,fmt='%d')
 
-    return branches, nodes, ien
+            if time_budget > 0.0 and time.time() - start_time > time_budget:
+                expired = True
+                break
+
+        if expired:
+            # Remove the branches of the incomplete generation.
+            for b in range(tree.last_branch+1, last_branch+1):
+                del branches[b]
+            for g in branches_to_grow:
+                branches[g].child = [0,0]
+            del nodes.nodes[num_nodes:]
+            del nodes.end_nodes[num_end_nodes:]
+            del ien[num_segments:]
+            nodes.last_node = num_nodes - 1
+            nodes.add_nodes([])
+            logger.info("Time budget of %g s expired after %d of %d generations" % \
+                (time_budget, tree.generation, param.N_it))
+            return False
 
+        tree.branches_to_grow = new_branches_to_grow
+        tree.last_branch = last_branch
+        tree.generation += 1
+
+    return True
+
+def write_tree(tree):
+    """ This function writes the tree node coordinates, connectivity and end nodes.
+
+    The end nodes of an incomplete tree include the ends of the branches that 
+    have not grown their children yet.
+    """
+    logger = logging.getLogger('fractal-tree')
+    param = tree.param
+    nodes = tree.nodes
+    ien = tree.ien
+
+    end_nodes = list(nodes.end_nodes)
+    if not tree.is_complete():
+        end_nodes += [tree.branches[b].nodes[-1] for b in tree.branches_to_grow]
+
+    xyz=np.zeros((len(nodes.nodes),3))
+    for i in range(len(nodes.nodes)):
+        xyz[i,:]=nodes.nodes[i]                    
+
+    if param.save_paraview:
+        from ParaviewWriter import write_line_VTU
+        logger.info('Finished growing, writing paraview file')
+        write_line_VTU(xyz, ien, param.output_file_name + '.vtu')                
+    
+    np.savetxt(param.output_file_name +'_ien.txt',ien,fmt='%d')
+    np.savetxt(param.output_file_name +'_xyz.txt',xyz)
+    np.savetxt(param.output_file_name +'_endnodes.txt',end_nodes,fmt='%d')
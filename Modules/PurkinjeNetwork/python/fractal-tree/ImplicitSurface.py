@@ -0,0 +1,117 @@
+# -*- coding: utf-8 -*-
+"""
+This module contains the ImplicitSurface class. This class is the zero level set of a
+signed distance field sampled on a voxel grid where the fractal tree is grown.
+"""
+import logging
+import numpy as np
+import vtk
+from vtk.util import numpy_support
+
+class ImplicitSurface:
+    """Class that contains a surface defined implicitly by a signed distance field.
+
+    The distance field is negative inside the surface and is read from a VTK image file
+    (.mha or .vti). Points are projected onto the surface by moving them along the
+    interpolated distance gradient by the interpolated distance, which costs a fixed
+    number of trilinear interpolations and needs no triangle mesh.
+
+    The projected points play the role of mesh triangles: project_new_point() returns the
+    index of the surface normal stored for the projected point, which is used to keep
+    branch directions in the tangent plane.
+
+    Args:
+        filename (str): the path and filename of the distance field image.
+
+    Attributes:
+        sdf (array): the distance field values. sdf[i,j,k], where i,j,k are the x,y,z voxel indices.
+        gradient (list): the x, y and z components of the distance field gradient.
+        origin (array): the coordinates of voxel (0,0,0).
+        spacing (array): the voxel spacing.
+        normals (list): the surface normals at the projected points.
+    """
+    def __init__(self, filename):
+        self._logger = logging.getLogger('fractal-tree')
+        self._logger.info("Distance field file name %s" % filename)
+
+        if filename.endswith(".vti"):
+            reader = vtk.vtkXMLImageDataReader()
+        else:
+            reader = vtk.vtkMetaImageReader()
+        reader.SetFileName(filename)
+        reader.Update()
+        image = reader.GetOutput()
+
+        dims = image.GetDimensions()
+        values = numpy_support.vtk_to_numpy(image.GetPointData().GetScalars())
+        self.sdf = values.astype(float).reshape(dims[2], dims[1], dims[0]).transpose(2, 1, 0)
+        self.origin = np.array(image.GetOrigin())
+        self.spacing = np.array(image.GetSpacing())
+        self.gradient = np.gradient(self.sdf, *self.spacing)
+        self.tolerance = 0.5 * np.max(self.spacing)
+        self.normals = []
+
+    def interpolate(self, point):
+        """This function interpolates the distance and its gradient at a point.
+
+        Returns:
+            d (float): the distance, None if the point is outside the grid.
+            grad (array): the gradient of the distance.
+        """
+        x = (point - self.origin) / self.spacing
+        i = np.floor(x).astype(int)
+        if np.any(i < 0) or np.any(i >= np.array(self.sdf.shape) - 1):
+            return None, None
+        f = x - i
+
+        # Trilinear weights of the 8 voxel corners.
+        wx = np.array([1.0-f[0], f[0]])
+        wy = np.array([1.0-f[1], f[1]])
+        wz = np.array([1.0-f[2], f[2]])
+        w = wx[:,None,None] * wy[None,:,None] * wz[None,None,:]
+
+        cell = np.s_[i[0]:i[0]+2, i[1]:i[1]+2, i[2]:i[2]+2]
+        d = np.sum(w * self.sdf[cell])
+        grad = np.array([np.sum(w * g[cell]) for g in self.gradient])
+        return d, grad
+
+    def project_new_point(self, point, max_iterations=3):
+        """This function projects any point to the zero level set of the distance field.
+
+        Args:
+            point (array): coordinates of the point to project.
+
+        Returns:
+             projected_point (array): the coordinates of the projected point that lies in the surface.
+             intriangle (int): the index of the normal of the projected point. If the point is outside
+                the grid or could not be projected, intriangle=-1.
+        """
+        projected_point = np.array(point, dtype=float)
+        for i in range(max_iterations):
+            d, grad = self.interpolate(projected_point)
+            if d is None:
+                return projected_point, -1
+            norm = np.linalg.norm(grad)
+            if norm == 0.0:
+                return projected_point, -1
+            normal = grad / norm
+            projected_point = projected_point - d * normal
+            if abs(d) < 1e-3 * self.tolerance:
+                break
+
+        d, grad = self.interpolate(projected_point)
+        if d is None or abs(d) > self.tolerance or np.linalg.norm(grad) == 0.0:
+            return projected_point, -1
+
+        self.normals.append(grad / np.linalg.norm(grad))
+        return projected_point, len(self.normals)-1
+
+    def move_point(self, point, triangle, displacement):
+        """This function moves a point and projects it to the surface.
+        """
+        return self.project_new_point(point+displacement)
+
+    def get_normal(self, triangle):
+        """This function returns the surface normal of a projected point.
+        """
+        return self.normals[triangle]
@@ -162,6 +162,25 @@ class Mesh:
     
 
         
+    def get_normal(self,triangle):
+        """This function returns the normal of a triangle of the mesh.
+        """
+        return self.normals[triangle,:]
+
+    def move_point(self,point,triangle,displacement):
+        """This function moves a point lying in a triangle and projects it to the surface defined by the mesh.
+        
+        Args:
+            point (array): coordinates of a point lying in the triangle.
+            triangle (int): the index of the triangle containing the point. It is not used by the projection.
+            displacement (array): the displacement to apply to the point.
+            
+        Returns:
+             projected_point (array): the coordinates of the projected point that lies in the surface.
+             intriangle (int): the index of the triangle where the projected point lies. If the point is outside surface, intriangle=-1.
+        """
+        return self.project_new_point(point+displacement)
+
     def project_new_point(self,point):
         """This function projects any point to the surface defined by the mesh.
         
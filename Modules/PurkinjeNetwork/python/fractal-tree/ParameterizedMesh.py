@@ -0,0 +1,287 @@
+# -*- coding: utf-8 -*-
+"""
+This module contains the ParameterizedMesh class. This class is a triangular surface
+with a 2D harmonic parameterization used to grow the fractal tree in the plane.
+"""
+import logging
+import numpy as np
+
+from Mesh import Mesh
+
+class ParameterizedMesh(Mesh):
+    """Class that contains a disc-like mesh mapped to the unit disc by a harmonic map.
+
+    The boundary of the mesh is mapped to the unit circle by arc length and interior
+    vertices are placed by solving the Laplace equation with clamped cotangent weights,
+    which gives a one-to-one map (Tutte embedding).
+
+    Branch nodes are moved in the plane using the inverse of the linear map of the
+    triangle they lie in, so a 3D step keeps its length to first order, and then mapped
+    back to 3D using the barycentric coordinates of the triangle containing them.
+    Triangles are located using a uniform 2D grid index. This avoids projecting each
+    new node onto the surface.
+
+    If the mesh is not a topological disc then 'parameterized' is False and nodes are
+    moved by projecting them onto the surface.
+
+    Args:
+        filename (str): the path and filename of the .vtp file with the mesh.
+
+    Attributes:
+        parameterized (bool): True if the parameterization was computed.
+        uv (array): 2D coordinates of the mesh nodes. uv[i,j], where i is the node index and j=[0,1] is the coordinate (u,v).
+        tri_to_uv (array): for each triangle the 2x3 matrix mapping a displacement in the triangle plane to a 2D displacement.
+        uv_to_bary (array): for each triangle the 2x2 matrix mapping a 2D offset from its first node to barycentric coordinates.
+        degenerate (array): True for triangles with a degenerate 2D image, these are never located.
+        grid_start (array): the index into grid_tris of the first triangle of each grid cell.
+        grid_tris (array): the triangles overlapping each grid cell.
+    """
+    def __init__(self, filename):
+        Mesh.__init__(self, filename)
+        self._logger = logging.getLogger('fractal-tree')
+        self.parameterized = False
+
+        boundary = self.find_boundary()
+        if boundary is None:
+            self._logger.warning("The mesh is not a topological disc, nodes are projected onto the surface.")
+            return
+
+        self.uv = self.compute_harmonic_map(boundary)
+        self.compute_triangle_maps()
+        self.build_grid()
+        self.parameterized = True
+
+    def find_boundary(self):
+        """This function finds the boundary loop of the mesh.
+
+        Returns:
+            boundary (array): the boundary node indices ordered consistently with the triangle
+                orientation, None if the mesh is not a topological disc.
+        """
+        conn = self.connectivity
+        edges = np.concatenate((conn[:,[0,1]], conn[:,[1,2]], conn[:,[2,0]]))
+        keys = np.sort(edges, axis=1)
+        unique_keys, inverse, counts = np.unique(keys, axis=0, return_inverse=True, return_counts=True)
+        inverse = inverse.reshape(-1)
+        boundary_edges = edges[counts[inverse] == 1]
+
+        num_nodes = len(np.unique(conn))
+        if len(boundary_edges) == 0 or num_nodes - len(unique_keys) + len(conn) != 1:
+            return None
+
+        next_node = dict(zip(boundary_edges[:,0], boundary_edges[:,1]))
+        if len(next_node) != len(boundary_edges):
+            return None
+
+        start = boundary_edges[0,0]
+        boundary = [start]
+        node = next_node[start]
+        while node != start:
+            if node not in next_node or len(boundary) > len(boundary_edges):
+                return None
+            boundary.append(node)
+            node = next_node[node]
+
+        if len(boundary) != len(boundary_edges):
+            return None
+        return np.array(boundary)
+
+    def compute_harmonic_map(self, boundary):
+        """This function maps the mesh to the unit disc.
+
+        Args:
+            boundary (array): the ordered boundary node indices.
+
+        Returns:
+            uv (array): 2D coordinates of the mesh nodes.
+        """
+        verts = self.verts
+        conn = self.connectivity
+        num_verts = len(verts)
+
+        # Map the boundary to the unit circle by arc length.
+        lengths = np.linalg.norm(verts[np.roll(boundary,-1)] - verts[boundary], axis=1)
+        angles = 2.0 * np.pi * np.concatenate(([0.0], np.cumsum(lengths)[:-1])) / np.sum(lengths)
+        uv = np.zeros((num_verts,2))
+        uv[boundary,0] = np.cos(angles)
+        uv[boundary,1] = np.sin(angles)
+
+        # Cotangent weights, the weight of edge (i,j) is set by the angle opposite to it
+        # in each of its triangles. Weights are clamped to be positive.
+        rows, cols, weights = [], [], []
+        for k in range(3):
+            i, j, o = conn[:,k], conn[:,(k+1)%3], conn[:,(k+2)%3]
+            a = verts[i] - verts[o]
+            b = verts[j] - verts[o]
+            cot = np.sum(a*b, axis=1) / np.maximum(np.linalg.norm(np.cross(a,b), axis=1), 1e-300)
+            rows += [i, j]
+            cols += [j, i]
+            weights += [0.5*cot, 0.5*cot]
+        rows = np.concatenate(rows)
+        cols = np.concatenate(cols)
+        weights = np.concatenate(weights)
+        weights = np.maximum(weights, 1e-3 * np.mean(np.abs(weights)))
+
+        fixed = np.zeros(num_verts, dtype=bool)
+        fixed[boundary] = True
+        fixed[np.setdiff1d(np.arange(num_verts), conn.reshape(-1))] = True
+        diag = np.bincount(rows, weights=weights, minlength=num_verts)
+        diag[fixed] = 1.0
+
+        def matvec(x):
+            y = diag * x - np.bincount(rows, weights=weights*x[cols], minlength=num_verts)
+            y[fixed] = 0.0
+            return y
+
+        for c in range(2):
+            b = np.bincount(rows, weights=weights*uv[cols,c]*fixed[cols], minlength=num_verts)
+            b[fixed] = 0.0
+            x, num_iters = self.solve(matvec, b, diag)
+            uv[~fixed,c] = x[~fixed]
+            self._logger.info("Harmonic map coordinate %d: %d iterations" % (c, num_iters))
+
+        return uv
+
+    def solve(self, matvec, b, diag, tol=1e-10):
+        """This function solves a symmetric positive definite system using the Jacobi
+           preconditioned conjugate gradient method.
+
+        Returns:
+            x (array): the solution.
+            num_iters (int): the number of iterations.
+        """
+        x = np.zeros(len(b))
+        r = b.copy()
+        z = r / diag
+        p = z.copy()
+        rz = np.dot(r, z)
+        b_norm = max(np.linalg.norm(b), 1e-300)
+        for num_iters in range(1, 10*len(b)+1):
+            if np.linalg.norm(r) <= tol * b_norm:
+                break
+            Ap = matvec(p)
+            alpha = rz / np.dot(p, Ap)
+            x += alpha * p
+            r -= alpha * Ap
+            z = r / diag
+            rz_new = np.dot(r, z)
+            p = z + (rz_new / rz) * p
+            rz = rz_new
+        return x, num_iters
+
+    def compute_triangle_maps(self):
+        """This function computes the linear maps between each triangle and its 2D image.
+        """
+        conn = self.connectivity
+        p0 = self.verts[conn[:,0]]
+        q0 = self.uv[conn[:,0]]
+        P = np.stack((self.verts[conn[:,1]]-p0, self.verts[conn[:,2]]-p0), axis=2)   # 3x2 edge matrices
+        Q = np.stack((self.uv[conn[:,1]]-q0, self.uv[conn[:,2]]-q0), axis=2)         # 2x2 edge matrices
+
+        det = Q[:,0,0]*Q[:,1,1] - Q[:,0,1]*Q[:,1,0]
+        degenerate = np.abs(det) < 1e-14
+        det[degenerate] = 1.0
+        Q_inv = np.empty(Q.shape)
+        Q_inv[:,0,0] =  Q[:,1,1] / det
+        Q_inv[:,0,1] = -Q[:,0,1] / det
+        Q_inv[:,1,0] = -Q[:,1,0] / det
+        Q_inv[:,1,1] =  Q[:,0,0] / det
+        Q_inv[degenerate] = 0.0
+        self.degenerate = degenerate
+        if np.any(degenerate):
+            self._logger.warning("Harmonic map has %d degenerate triangles" % np.count_nonzero(degenerate))
+
+        # The 3D to 2D map of a triangle is Q (P^T P)^-1 P^T.
+        PtP = np.einsum('nki,nkj->nij', P, P)
+        self.tri_to_uv = np.einsum('nij,njk,nlk->nil', Q, np.linalg.pinv(PtP), P)
+        self.uv_to_bary = Q_inv
+
+    def build_grid(self):
+        """This function builds a uniform grid index of the 2D triangles.
+        """
+        conn = self.connectivity
+        tri_uv = self.uv[conn]
+        lo = tri_uv.min(axis=1)
+        hi = tri_uv.max(axis=1)
+        self.grid_origin = lo.min(axis=0)
+        self.grid_size = max(int(np.sqrt(len(conn))), 1)
+        self.grid_spacing = max(np.max(hi.max(axis=0) - self.grid_origin) / self.grid_size, 1e-300)
+
+        cell_lo = self.grid_cell(lo)
+        cell_hi = self.grid_cell(hi)
+        span = cell_hi - cell_lo
+        cells, tris = [], []
+        for di in range(np.max(span[:,0])+1):
+            for dj in range(np.max(span[:,1])+1):
+                mask = (span[:,0] >= di) & (span[:,1] >= dj)
+                index = np.nonzero(mask)[0]
+                cells.append((cell_lo[index,0]+di) * self.grid_size + cell_lo[index,1]+dj)
+                tris.append(index)
+        cells = np.concatenate(cells)
+        tris = np.concatenate(tris)
+        order = np.argsort(cells, kind='stable')
+        self.grid_tris = tris[order]
+        self.grid_start = np.searchsorted(cells[order], np.arange(self.grid_size*self.grid_size+1))
+
+    def grid_cell(self, uv):
+        """This function returns the grid cell (i,j) of 2D points.
+        """
+        cell = np.floor((uv - self.grid_origin) / self.grid_spacing).astype(int)
+        return np.clip(cell, 0, self.grid_size-1)
+
+    def barycentric(self, uv, triangle):
+        """This function returns the barycentric coordinates of a 2D point in a triangle.
+        """
+        b = np.dot(self.uv_to_bary[triangle], uv - self.uv[self.connectivity[triangle,0]])
+        return np.array([1.0-b[0]-b[1], b[0], b[1]])
+
+    def locate(self, uv, hint):
+        """This function finds the triangle containing a 2D point.
+
+        Args:
+            uv (array): the 2D point.
+            hint (int): a triangle that is likely to contain the point, or be near it.
+
+        Returns:
+            triangle (int): the index of the triangle containing the point, -1 if the point
+                is outside the mesh.
+            bary (array): the barycentric coordinates of the point in the triangle.
+        """
+        tol = -1e-10
+        candidates = [hint]
+        for node in self.connectivity[hint]:
+            candidates += self.node_to_tri[node]
+        i, j = self.grid_cell(uv)
+        cell = i * self.grid_size + j
+        candidates += list(self.grid_tris[self.grid_start[cell]:self.grid_start[cell+1]])
+
+        for triangle in candidates:
+            if self.degenerate[triangle]:
+                continue
+            bary = self.barycentric(uv, triangle)
+            if np.all(bary >= tol):
+                return triangle, bary
+        return -1, None
+
+    def move_point(self, point, triangle, displacement):
+        """This function moves a point in the 2D parameterization and maps it back to the surface.
+
+        Args:
+            point (array): coordinates of a point lying in the triangle.
+            triangle (int): the index of the triangle containing the point.
+            displacement (array): the 3D displacement to apply to the point.
+
+        Returns:
+             moved_point (array): the coordinates of the moved point that lies in the surface.
+             intriangle (int): the index of the triangle where the moved point lies. If the point is outside surface, intriangle=-1.
+        """
+        if not self.parameterized:
+            return Mesh.move_point(self, point, triangle, displacement)
+
+        node0 = self.connectivity[triangle,0]
+        uv = self.uv[node0] + np.dot(self.tri_to_uv[triangle], point + displacement - self.verts[node0])
+
+        new_triangle, bary = self.locate(uv, triangle)
+        if new_triangle < 0:
+            return point + displacement, -1
+        return np.dot(bary, self.verts[self.connectivity[new_triangle]]), new_triangle
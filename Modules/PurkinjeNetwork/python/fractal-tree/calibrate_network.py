@@ -0,0 +1,311 @@
+#!/usr/bin/env python
+"""
+This module searches for fractal tree parameters that produce a network with a
+target number of end nodes or a target surface coverage.
+
+The average branch length, the number of branch generations and the repulsive
+parameter are adjusted using the Nelder-Mead simplex method. Each evaluation
+grows a complete tree, so evaluations are made cheaper by
+
+    - Reading and preprocessing the surface mesh once and sharing it between
+      all of the generated trees.
+    - Growing trees with branch segments 'coarsen' times longer than the
+      requested segment length, networks are not written.
+
+Two metrics are supported
+
+    end_nodes - The number of network end nodes.
+    coverage  - The percentage of surface area within 'coverage_distance'
+                of a network segment.
+
+Coverage is measured the same way as the coverage analysis of the Purkinje
+network plugin: the distance from each surface vertex to the nearest network
+segment is computed and each vertex represents a third of the area of its
+triangles. Measuring distances to segments rather than to nodes makes the
+metric insensitive to the coarser segments used during the search.
+
+The search stops when the metric is within 'tolerance' (relative) of the target
+or after 'max_evaluations' trees have been grown. The best parameters found are
+written to PREFIX_calibrated_parameters.txt using the same format as the
+parameter files read by the Purkinje network plugin (e.g. lv-parameters.txt).
+
+The random number generators are reset before growing each tree so parameters
+are compared using the same sequence of random branch lengths and angles.
+
+Example:
+
+    python calibrate_network.py --infile=lv.vtp --outfile=lv --init_node="[28.9 47.9 70]" \\
+        --second_node="[28.9 47.9 69]" --metric=end_nodes --target=1000
+"""
+import argparse
+import ast
+import logging
+import random
+import sys
+
+import numpy as np
+import vtk
+
+from FractalTree import Fractal_Tree_3D
+from Mesh import Mesh
+from parameters import Parameters
+
+def parse_args():
+    """ Parse command-line arguments."""
+    parser = argparse.ArgumentParser()
+    parser.add_argument("-i",   "--infile",              help="input surface mesh file")
+    parser.add_argument("-o",   "--outfile",             help="output file prefix")
+    parser.add_argument("-in",  "--init_node",           help="initial node")
+    parser.add_argument("-sn",  "--second_node",         help="second node")
+    parser.add_argument("-ng",  "--num_branch_gen",      help="initial number of branch generations", default=10)
+    parser.add_argument("-ab",  "--avg_branch_length",   help="initial average branch length", default=0.3)
+    parser.add_argument("-ba",  "--branch_angle",        help="branch angle", default=0.15)
+    parser.add_argument("-r",   "--repulsive_parameter", help="initial repulsive parameter", default=0.1)
+    parser.add_argument("-bl",  "--branch_seg_length",   help="branch segment length", default=0.01)
+    parser.add_argument("-m",   "--metric",              help="metric: end_nodes or coverage", default="end_nodes")
+    parser.add_argument("-t",   "--target",              help="target metric value")
+    parser.add_argument("-cd",  "--coverage_distance",   help="coverage distance", default=0.0)
+    parser.add_argument("-tol", "--tolerance",           help="relative metric tolerance", default=0.02)
+    parser.add_argument("-me",  "--max_evaluations",     help="maximum number of trees grown", default=40)
+    parser.add_argument("-c",   "--coarsen",             help="branch segment length factor", default=2.0)
+    return parser.parse_args(), parser.print_help
+
+def parse_point(value):
+    """ Convert a '[x y z]' or '[x,y,z]' string to a numpy array.
+    """
+    return np.array(ast.literal_eval(" ".join(value.split()).replace(" ", ",")))
+
+def compute_vertex_areas(mesh):
+    """ Compute the area represented by each mesh vertex, a third of the area of its triangles.
+    """
+    conn = mesh.connectivity
+    u = mesh.verts[conn[:,1],:] - mesh.verts[conn[:,0],:]
+    v = mesh.verts[conn[:,2],:] - mesh.verts[conn[:,0],:]
+    tri_areas = 0.5 * np.linalg.norm(np.cross(u, v), axis=1)
+    vertex_areas = np.zeros(len(mesh.verts))
+    for j in range(3):
+        np.add.at(vertex_areas, conn[:,j], tri_areas / 3.0)
+    return vertex_areas
+
+def compute_coverage(mesh, vertex_areas, nodes, ien, coverage_distance):
+    """ Compute the percentage of mesh area within 'coverage_distance' of a network segment.
+    """
+    points = vtk.vtkPoints()
+    for node in nodes:
+        points.InsertNextPoint(node[0], node[1], node[2])
+    lines = vtk.vtkCellArray()
+    for segment in ien:
+        lines.InsertNextCell(2)
+        lines.InsertCellPoint(segment[0])
+        lines.InsertCellPoint(segment[1])
+    poly_data = vtk.vtkPolyData()
+    poly_data.SetPoints(points)
+    poly_data.SetLines(lines)
+    locator = vtk.vtkCellLocator()
+    locator.SetDataSet(poly_data)
+    locator.BuildLocator()
+
+    dist2 = coverage_distance * coverage_distance
+    closest_point = [0.0, 0.0, 0.0]
+    cell_id = vtk.reference(0)
+    sub_id = vtk.reference(0)
+    d2 = vtk.reference(0.0)
+    covered_area = 0.0
+    for vertex, area in zip(mesh.verts, vertex_areas):
+        locator.FindClosestPoint(vertex, closest_point, cell_id, sub_id, d2)
+        if d2 <= dist2:
+            covered_area += area
+    return 100.0 * covered_area / np.sum(vertex_areas)
+
+class Calibration:
+    """ Grow trees on a shared mesh and measure them.
+    """
+    def __init__(self, mesh, param, metric, target, coverage_distance):
+        self.mesh = mesh
+        self.param = param
+        self.metric = metric
+        self.target = target
+        self.coverage_distance = coverage_distance
+        self.vertex_areas = compute_vertex_areas(mesh) if metric == "coverage" else None
+        self.evaluations = {}
+        self.best = None
+        self.logger = logging.getLogger('fractal-tree')
+
+    def get_parameters(self, x):
+        """ Convert a search point to valid (length, generations, repulsive) parameters.
+        """
+        length = max(x[0], 2.0 * self.param.l_segment)
+        num_gen = max(int(round(x[1])), 1)
+        w = max(x[2], 0.0)
+        return (round(length, 6), num_gen, round(w, 6))
+
+    def evaluate(self, x):
+        """ Grow a tree and return the relative error of its metric.
+
+        Trees are cached by parameter values, generation counts are rounded to
+        integers so nearby search points often grow the same tree.
+        """
+        key = self.get_parameters(x)
+        if key in self.evaluations:
+            return self.evaluations[key][1]
+
+        param = self.param
+        param.length, param.N_it, param.w = key
+        param.std_length = np.sqrt(0.2) * param.length
+        param.min_length = param.length / 10.0
+
+        random.seed(0)
+        np.random.seed(0)
+        result = Fractal_Tree_3D(param, self.mesh)
+        if result[0] is None:
+            return float('inf')
+        branches, nodes, ien = result
+
+        if self.metric == "end_nodes":
+            value = len(nodes.end_nodes)
+        else:
+            value = compute_coverage(self.mesh, self.vertex_areas, nodes.nodes, ien, self.coverage_distance)
+
+        error = abs(value - self.target) / self.target
+        self.evaluations[key] = (value, error)
+        self.logger.info("Calibration %d: avg_branch_length=%g num_branch_gen=%d repulsive_parameter=%g %s=%g" % \
+            (len(self.evaluations), key[0], key[1], key[2], self.metric, value))
+
+        if self.best is None or error < self.best[2]:
+            self.best = (key, value, error)
+        return error
+
+def nelder_mead(func, x0, steps, max_evaluations, tolerance, num_evaluations):
+    """ Minimize func using the Nelder-Mead simplex method.
+
+    The search stops when func is below 'tolerance' or num_evaluations()
+    reaches 'max_evaluations'. func may cache its values so the number of
+    simplex iterations is also limited.
+    """
+    n = len(x0)
+    simplex = [np.array(x0, dtype=float)]
+    for i in range(n):
+        x = np.array(x0, dtype=float)
+        x[i] += steps[i]
+        simplex.append(x)
+    values = [func(x) for x in simplex]
+
+    def done():
+        return min(values) <= tolerance or num_evaluations() >= max_evaluations
+
+    for iteration in range(10 * max_evaluations):
+        if done():
+            break
+        order = np.argsort(values)
+        simplex = [simplex[i] for i in order]
+        values = [values[i] for i in order]
+        centroid = np.mean(simplex[:-1], axis=0)
+
+        # Reflect the worst point through the centroid of the others.
+        reflected = centroid + (centroid - simplex[-1])
+        value = func(reflected)
+
+        if value < values[0]:
+            expanded = centroid + 2.0 * (centroid - simplex[-1])
+            expanded_value = func(expanded)
+            if expanded_value < value:
+                simplex[-1], values[-1] = expanded, expanded_value
+            else:
+                simplex[-1], values[-1] = reflected, value
+        elif value < values[-2]:
+            simplex[-1], values[-1] = reflected, value
+        else:
+            contracted = centroid + 0.5 * (simplex[-1] - centroid)
+            contracted_value = func(contracted)
+            if contracted_value < values[-1]:
+                simplex[-1], values[-1] = contracted, contracted_value
+            else:
+                # Shrink towards the best point.
+                for i in range(1, n+1):
+                    if done():
+                        break
+                    simplex[i] = simplex[0] + 0.5 * (simplex[i] - simplex[0])
+                    values[i] = func(simplex[i])
+
+    best = int(np.argmin(values))
+    return simplex[best], values[best]
+
+def write_parameters(file_name, param, best, branch_seg_length):
+    """ Write parameters using the Purkinje network plugin parameter file format.
+    """
+    length, num_gen, w = best
+    with open(file_name, "w") as out_file:
+        out_file.write("avgBranchLength %g\n" % length)
+        out_file.write("branchAngle %g\n" % param.branch_angle)
+        out_file.write("branchSegLength %g\n" % branch_seg_length)
+        out_file.write("firstPoint %s\n" % " ".join([repr(float(v)) for v in param.init_node]))
+        out_file.write("numBranchGenerations %d\n" % num_gen)
+        out_file.write("repulsiveParameter %f\n" % w)
+        out_file.write("secondPoint %s\n" % " ".join([repr(float(v)) for v in param.second_node]))
+
+def calibrate(infile=None, outfile=None, init_node=None, second_node=None, num_branch_gen=10,
+        avg_branch_length=0.3, branch_angle=0.15, repulsive_parameter=0.1, branch_seg_length=0.01,
+        metric="end_nodes", target=None, coverage_distance=0.0, tolerance=0.02, max_evaluations=40,
+        coarsen=2.0):
+    """ Search for parameters producing a network with the target metric value and write
+        them to 'outfile'_calibrated_parameters.txt.
+    """
+    logger = logging.getLogger('fractal-tree')
+
+    if None in [infile, outfile, init_node, second_node, target]:
+        logger.error("The infile, outfile, init_node, second_node and target parameters must be given.")
+        return None
+
+    if metric not in ["end_nodes", "coverage"]:
+        logger.error("Unknown calibration metric %s" % metric)
+        return None
+
+    target = float(target)
+    coverage_distance = float(coverage_distance)
+    if target <= 0.0 or (metric == "coverage" and coverage_distance <= 0.0):
+        logger.error("The target and the coverage distance for the coverage metric must be positive.")
+        return None
+
+    branch_seg_length = float(branch_seg_length)
+    param = Parameters()
+    param.input_file_name = infile
+    param.output_file_name = outfile
+    param.init_node = parse_point(init_node)
+    param.second_node = parse_point(second_node)
+    param.branch_angle = float(branch_angle)
+    param.l_segment = float(coarsen) * branch_seg_length
+    param.save = False
+    param.save_paraview = False
+
+    mesh = Mesh(infile)
+    calibration = Calibration(mesh, param, metric, target, coverage_distance)
+
+    x0 = [float(avg_branch_length), float(num_branch_gen), float(repulsive_parameter)]
+    steps = [0.25 * x0[0], 2.0, max(0.5 * x0[2], 0.05)]
+    nelder_mead(calibration.evaluate, x0, steps, int(max_evaluations), float(tolerance),
+        lambda: len(calibration.evaluations))
+
+    if calibration.best is None:
+        logger.error("No network could be grown.")
+        return None
+
+    best, value, error = calibration.best
+    logger.info("Calibration: avg_branch_length=%g num_branch_gen=%d repulsive_parameter=%g %s=%g error=%g" % \
+        (best[0], best[1], best[2], metric, value, error))
+
+    write_parameters(outfile + '_calibrated_parameters.txt', param, best, branch_seg_length)
+
+    return "Calibration: %s=%g evaluations=%d\n" % (metric, value, len(calibration.evaluations))
+
+if __name__ == '__main__':
+    logging.basicConfig(format='[%(name)s] %(levelname)s - %(message)s')
+    logging.getLogger('fractal-tree').setLevel(logging.INFO)
+    args, print_help = parse_args()
+    if args.infile == None or args.outfile == None or args.target == None:
+        print_help()
+        sys.exit(1)
+    result = calibrate(**vars(args))
+    status = 0
+    if not result:
+        status = 1
+    sys.exit(status)
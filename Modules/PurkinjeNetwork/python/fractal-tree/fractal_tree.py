@@ -19,6 +19,10 @@ def parse_args():
     parser.add_argument("-ba",  "--branch_angle",        help="branch angle")
     parser.add_argument("-r",   "--repulsive_parameter", help="repulsive parameter")
     parser.add_argument("-bl",  "--branch_seg_length",   help="branch segment length")
+    parser.add_argument("-no",  "--node_ordering",       help="node ordering: none, bfs or rcm")
+    parser.add_argument("-tb",  "--time_budget",         help="growth time budget in seconds, 0 grows all generations")
+    parser.add_argument("-sm",  "--surface_mapping",     help="surface mapping: none, harmonic or implicit")
+    parser.add_argument("-sdf", "--sdf_file",            help="signed distance field image file used by implicit surface mapping")
     return parser.parse_args(), parser.print_help
 
 def init_logging():
@@ -30,9 +34,19 @@ def init_logging():
     console_handler.setFormatter(formatter)
     logger.addHandler(console_handler)
 
+## The last tree grown by run(), its growth can be completed by resume().
+tree = None
+tree_complete = True
+tree_node_ordering = None
+
 def run(**kwargs):
     """ Execute the fractal tree generation using passed parameters.
+
+    If a time budget is given then the tree may not have all of its branch 
+    generations, 'tree_complete' is then False and the remaining generations 
+    can be grown by calling resume().
     """
+    global tree, tree_complete, tree_node_ordering
     init_logging()
     logger = logging.getLogger('fractal-tree')
 
@@ -44,6 +58,7 @@ def run(**kwargs):
     outfile = None
     init_node = None
     second_node = None
+    node_ordering = None
     for key, value in kwargs.items():
         if value == None:
             continue
@@ -73,6 +88,17 @@ def run(**kwargs):
             param.w = float(value)
         elif key == "branch_seg_length":
             param.l_segment = float(value)
+        elif key == "node_ordering":
+            node_ordering = value
+        elif key == "time_budget":
+            param.time_budget = float(value)
+        elif key == "surface_mapping":
+            if value not in ["none", "harmonic", "implicit"]:
+                logger.error("Unknown surface mapping %s" % value)
+                return None
+            param.surface_mapping = value
+        elif key == "sdf_file":
+            param.sdf_file_name = value
         else:
             logger.error("Unknown parameter name %s" % key)
             return None
@@ -86,6 +112,10 @@ def run(**kwargs):
         logger.error("No output file name given.")
         return None
 
+    if param.surface_mapping == "implicit" and param.sdf_file_name == None:
+        logger.error("No signed distance field file given.")
+        return None
+
     if init_node == None:
         logger.error("No initial node given.")
         return None
@@ -95,10 +125,42 @@ def run(**kwargs):
         return None
 
     ## Calculate the fractal tree.
-    branches, nodes, ien = Fractal_Tree_3D(param)
+    tree = create_tree(param)
+    if tree is None:
+        return None
+    tree_node_ordering = node_ordering
+    return grow_and_write(param.time_budget)
+
+def resume(time_budget=0.0):
+    """ Grow the remaining branch generations of the last tree grown by run().
+    """
+    logger = logging.getLogger('fractal-tree')
+    if tree is None:
+        logger.error("No tree has been grown.")
+        return None
+    if tree_complete:
+        logger.info("All branch generations have been grown.")
+    return grow_and_write(float(time_budget))
+
+def grow_and_write(time_budget):
+    """ Grow the last tree for at most 'time_budget' seconds and write it.
+    """
+    global tree_complete
+    logger = logging.getLogger('fractal-tree')
+    tree_complete = grow_tree(tree, time_budget)
+    write_tree(tree)
+    nodes, ien = tree.nodes, tree.ien
     logger.info("Number of nodes generated: %d" % len(nodes.nodes))
     logger.info("Number of segments generated: %d" % len(ien))
-    result = "Network: num_nodes=%d num_segs=%d\n" % (len(nodes.nodes), len(ien))
+    logger.info("Number of generations: %d of %d" % (tree.generation, tree.param.N_it))
+    result = "Network: num_nodes=%d num_segs=%d num_gens=%d\n" % (len(nodes.nodes), len(ien), tree.generation)
+
+    ## Renumber nodes to improve memory locality.
+    if tree_node_ordering not in [None, "none"]:
+        from reorder_network import reorder
+        outfile = tree.param.output_file_name
+        if not reorder(outfile, outfile, tree_node_ordering):
+            return None
     return result 
 
 if __name__ == '__main__':
@@ -26,6 +26,9 @@ class Parameters():
         fascicles_length (list): length  of the fascicles. Include one per fascicle to include. The size must match the size of fascicles_angles.
         save (bool): save text files containing the nodes, the connectivity and end nodes of the tree.
         save_paraview (bool): save a .vtu paraview file. The tvtk module must be installed.
+        time_budget (float): stop growing after this many seconds keeping the last complete generation of branches. Set to zero to grow all generations.
+        surface_mapping (str): grow the tree by projecting nodes onto the surface ('none'), in a 2D harmonic parameterization of a disc-like surface ('harmonic') or on the zero level set of the signed distance field read from sdf_file_name ('implicit').
+        sdf_file_name (str): the signed distance field image file used by the 'implicit' surface mapping.
         
     """
     def __init__(self):
@@ -47,3 +50,6 @@ class Parameters():
         self.fascicles_length=[.5,.5]
         self.save=True
         self.save_paraview=True
+        self.time_budget=0.0
+        self.surface_mapping='none'
+        self.sdf_file_name=None
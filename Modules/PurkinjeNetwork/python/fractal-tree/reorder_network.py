@@ -0,0 +1,161 @@
+#!/usr/bin/env python
+"""
+This module renumbers the nodes of a network generated by the fractal tree
+code to improve memory locality.
+
+Nodes are numbered in branch creation order so nodes connected by a segment
+can be far apart in memory. Two orderings are supported
+
+    bfs - Breadth-first search from the root node, the root node remains node 0.
+    rcm - Cuthill-McKee starting from the root node, neighbors are numbered
+          in increasing degree.
+
+The root node (node 0) remains node 0 for both orderings because the network
+files do not store the root node, readers take node 0 as the root. For this
+reason the rcm ordering is not reversed: moving the root back to node 0 after
+the reversal would make the bandwidth the size of the network, and on a tree
+the reversal does not reduce the bandwidth. Other connected components start
+from a pseudo-peripheral node. An ordering that would increase the bandwidth
+is not applied.
+
+The PREFIX_xyz.txt, PREFIX_ien.txt and PREFIX_endnodes.txt files are rewritten
+consistently together with PREFIX.vtu and PREFIX_nodemap.txt listing the new index
+of each original node. Segments keep their original order.
+
+Example:
+
+    python reorder_network.py --infile=left-ventricle --outfile=left-ventricle-rcm --method=rcm
+"""
+import argparse
+import logging
+import sys
+from collections import deque
+
+import numpy as np
+
+def parse_args():
+    """ Parse command-line arguments."""
+    parser = argparse.ArgumentParser()
+    parser.add_argument("-i",   "--infile",   help="input network file prefix")
+    parser.add_argument("-o",   "--outfile",  help="output network file prefix")
+    parser.add_argument("-m",   "--method",   help="node ordering: bfs or rcm", default="rcm")
+    return parser.parse_args(), parser.print_help
+
+def compute_bandwidth(ien):
+    """ Compute the maximum difference between the node indices of a segment.
+    """
+    if len(ien) == 0:
+        return 0
+    return int(np.max(np.abs(ien[:,1] - ien[:,0])))
+
+def build_adjacency(num_nodes, ien):
+    """ Build the node adjacency lists.
+    """
+    adjacency = [[] for i in range(num_nodes)]
+    for n0, n1 in ien:
+        adjacency[n0].append(n1)
+        adjacency[n1].append(n0)
+    return adjacency
+
+def find_pseudo_peripheral_node(adjacency, start_node):
+    """ Find a node of near-maximal eccentricity using the George-Liu algorithm.
+    """
+    node = start_node
+    num_levels = -1
+    while True:
+        levels = {node:0}
+        queue = deque([node])
+        while queue:
+            n = queue.popleft()
+            for m in adjacency[n]:
+                if m not in levels:
+                    levels[m] = levels[n] + 1
+                    queue.append(m)
+        max_level = max(levels.values())
+        if max_level <= num_levels:
+            return node
+        num_levels = max_level
+        last_level = [n for n,l in levels.items() if l == max_level]
+        node = min(last_level, key=lambda n: len(adjacency[n]))
+
+def compute_ordering(num_nodes, ien, method):
+    """ Compute the new index of each node.
+    """
+    adjacency = build_adjacency(num_nodes, ien)
+    visited = np.zeros(num_nodes, dtype=bool)
+    order = []
+
+    for root in range(num_nodes):
+        if visited[root]:
+            continue
+        start_node = root
+        if method == "rcm" and root != 0:
+            start_node = find_pseudo_peripheral_node(adjacency, root)
+        visited[start_node] = True
+        queue = deque([start_node])
+        while queue:
+            n = queue.popleft()
+            order.append(n)
+            neighbors = [m for m in adjacency[n] if not visited[m]]
+            if method == "rcm":
+                neighbors.sort(key=lambda m: len(adjacency[m]))
+            for m in neighbors:
+                visited[m] = True
+                queue.append(m)
+
+    node_map = np.zeros(num_nodes, dtype=int)
+    node_map[np.array(order, dtype=int)] = np.arange(num_nodes)
+    return node_map
+
+def reorder(infile, outfile, method):
+    """ Reorder the network files with prefix 'infile' and write them using prefix 'outfile'.
+    """
+    logger = logging.getLogger('fractal-tree')
+
+    if method not in ["bfs", "rcm"]:
+        logger.error("Unknown node ordering %s" % method)
+        return None
+
+    xyz = np.loadtxt(infile + '_xyz.txt', ndmin=2)
+    ien = np.loadtxt(infile + '_ien.txt', dtype=int, ndmin=2)
+    end_nodes = np.loadtxt(infile + '_endnodes.txt', dtype=int, ndmin=1)
+
+    if len(xyz) == 0:
+        logger.error("The network has no nodes.")
+        return None
+
+    node_map = compute_ordering(len(xyz), ien, method)
+    if compute_bandwidth(node_map[ien]) > compute_bandwidth(ien):
+        logger.warning("Node ordering %s would increase the bandwidth, the nodes are not renumbered." % method)
+        node_map = np.arange(len(xyz))
+
+    new_xyz = np.zeros(xyz.shape)
+    new_xyz[node_map,:] = xyz
+    new_ien = node_map[ien]
+    new_end_nodes = node_map[end_nodes]
+
+    bandwidth = compute_bandwidth(ien)
+    new_bandwidth = compute_bandwidth(new_ien)
+    logger.info("Node ordering %s: bandwidth %d -> %d" % (method, bandwidth, new_bandwidth))
+
+    from ParaviewWriter import write_line_VTU
+    write_line_VTU(new_xyz, new_ien, outfile + '.vtu')
+    np.savetxt(outfile + '_ien.txt', new_ien, fmt='%d')
+    np.savetxt(outfile + '_xyz.txt', new_xyz)
+    np.savetxt(outfile + '_endnodes.txt', new_end_nodes, fmt='%d')
+    np.savetxt(outfile + '_nodemap.txt', node_map, fmt='%d')
+
+    return "Network: bandwidth=%d new_bandwidth=%d\n" % (bandwidth, new_bandwidth)
+
+if __name__ == '__main__':
+    logging.basicConfig(format='[%(name)s] %(levelname)s - %(message)s')
+    logging.getLogger('fractal-tree').setLevel(logging.INFO)
+    args, print_help = parse_args()
+    if args.infile == None or args.outfile == None:
+        print_help()
+        sys.exit(1)
+    result = reorder(args.infile, args.outfile, args.method)
+    status = 0
+    if not result:
+        status = 1
+    sys.exit(status)
@@ -31,6 +31,7 @@
 
 #include "sv4gui_PurkinjeNetwork.h"
 #include "sv4gui_Math3.h"
+#include "sv4gui_PurkinjeNetworkOperation.h"
 
 sv4guiPurkinjeNetwork::sv4guiPurkinjeNetwork()
     : m_CalculateBoundingBox(true)
@@ -180,125 +181,52 @@ int sv4guiPurkinjeNetwork::GetMaxPathID(mitk::DataStorage::SetOfObjects::ConstPo
     return maxID;
 }
 
+//------------------
+// ExecuteOperation
+//------------------
+// Set or undo a parameter edit, see sv4gui_PurkinjeNetworkOperation.h.
+//
+// Network edits are executed by the 1D network container that owns the 
+// edited network.
+
 void sv4guiPurkinjeNetwork::ExecuteOperation( mitk::Operation* operation )
 {
-/*
-    int timeStep = -1;
-
-    sv4guiPurkinjeNetworkOperation* pathOperation = dynamic_cast<sv4guiPurkinjeNetworkOperation*>(operation);
+    std::string msgPrefix = "[sv4guiPurkinjeNetwork::ExecuteOperation] ";
 
-    if ( pathOperation )
-    {
-        timeStep = pathOperation->GetTimeStep();
-
-    }else{
-        MITK_ERROR << "No valid Path Operation for sv4guiPurkinjeNetwork" << std::endl;
-        return;
-    }
+    auto networkOperation = dynamic_cast<sv4guiPurkinjeNetworkOperation*>(operation);
 
-    if ( timeStep < 0 )
-    {
-        MITK_ERROR << "Time step (" << timeStep << ") outside of sv4guiPurkinjeNetwork time bounds" << std::endl;
+    if (networkOperation == nullptr) {
+        MITK_ERROR << msgPrefix << "No valid network operation.";
         return;
     }
 
-    sv4guiPurkinjeNetworkElement* originalPathElement=m_PathElementSet[timeStep];
-
-    sv4guiPurkinjeNetworkElement* newPathElement=pathOperation->GetPathElement();
-    int index = pathOperation->GetIndex();
-    mitk::Point3D point=pathOperation->GetPoint();
-    bool selected=pathOperation->GetSelected();
+    auto type = operation->GetOperationType();
 
-    m_OperationType= (sv4guiPurkinjeNetworkOperation::PathOperationType) operation->GetOperationType();
-
-    switch (operation->GetOperationType())
+    switch (type)
     {
-
-    case sv4guiPurkinjeNetworkOperation::OpINSERTCONTROLPOINT:
+    case sv4guiPurkinjeNetworkOperation::OpSETPROPS:
+    case sv4guiPurkinjeNetworkOperation::OpUNDOPROPS:
     {
-        if(originalPathElement)
-        {
-            originalPathElement->InsertControlPoint(index,point);
-            originalPathElement->DeselectControlPoint();
-            originalPathElement->SetControlPointSelected(index,true);
-            m_CalculateBoundingBox = true;
-            m_NewControlPoint=point;
-            m_DataModified=true;
-            this->Modified();
-            this->InvokeEvent( sv4guiPurkinjeNetworkPointInsertEvent() );
-        }
-    }
-        break;
+        const auto& props = (type == sv4guiPurkinjeNetworkOperation::OpSETPROPS) ? 
+            networkOperation->GetNewProps() : networkOperation->GetOldProps();
 
-    case sv4guiPurkinjeNetworkOperation::OpMOVECONTROLPOINT:
-    {
-        if(originalPathElement)
-        {
-            originalPathElement->SetControlPoint(index,point);
-            m_CalculateBoundingBox = true;
-            m_NewControlPoint=point;
-            m_DataModified=true;
-            this->Modified();
-            this->InvokeEvent( sv4guiPurkinjeNetworkPointMoveEvent() );
+        for (const auto& prop : props) {
+            this->SetProp(prop.first, prop.second);
         }
-    }
-        break;
 
-    case sv4guiPurkinjeNetworkOperation::OpREMOVECONTROLPOINT:
-    {
-        if(originalPathElement)
-        {
-            originalPathElement->RemoveControlPoint(index);
-            m_CalculateBoundingBox = true;
-            m_DataModified=true;
-            this->Modified();
-            this->InvokeEvent( sv4guiPurkinjeNetworkPointRemoveEvent() );
-        }
-    }
-        break;
-
-    case sv4guiPurkinjeNetworkOperation::OpSELECTCONTROLPOINT:
-    {
-        if(originalPathElement)
-        {
-            originalPathElement->SetControlPointSelected(index,selected);
-            this->Modified();
-            this->InvokeEvent( sv4guiPurkinjeNetworkPointSelectEvent() );
-        }
-    }
-        break;
-
-    case sv4guiPurkinjeNetworkOperation::OpDESELECTALL:
-    {
-        if(originalPathElement)
-        {
-            originalPathElement->DeselectControlPoint();
-            this->Modified();
-            this->InvokeEvent( sv4guiPurkinjeNetworkPointSelectEvent() );
-        }
-    }
-        break;
-
-    case sv4guiPurkinjeNetworkOperation::OpSETPATHELEMENT:
-    {
-        m_PathElementSet[timeStep]=newPathElement;
-        m_CalculateBoundingBox = true;
-        m_DataModified=true;
+        m_DataModified = true;
         this->Modified();
-        this->InvokeEvent( sv4guiPurkinjeNetworkSetEvent() );
+        this->InvokeEvent( sv4guiPurkinjeNetworkPropsEvent() );
     }
         break;
 
     default:
-        itkWarningMacro("sv4guiPurkinjeNetwork could not understrand the operation. Please check!");
-        break;
+        MITK_WARN << msgPrefix << "Unknown operation type " << type;
+        return;
     }
 
     mitk::OperationEndEvent endevent(operation);
     ((const itk::Object*)this)->InvokeEvent(endevent);
-
-*/
-
 }
 
 void sv4guiPurkinjeNetwork::CalculateBoundingBox(double *bounds,unsigned int t)
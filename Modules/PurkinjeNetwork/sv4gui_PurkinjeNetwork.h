@@ -170,6 +170,7 @@ SV4GUIMODULEPURKINJENETWORK_EXPORT bool Equal( const sv4guiPurkinjeNetwork* left
 SV4GUIMODULEPURKINJENETWORK_EXPORT bool Equal( const sv4guiPurkinjeNetwork& leftHandSide, const sv4guiPurkinjeNetwork& rightHandSide, mitk::ScalarType eps, bool verbose );
 
 itkEventMacro( sv4guiPurkinjeNetworkEvent, itk::AnyEvent );
+itkEventMacro( sv4guiPurkinjeNetworkPropsEvent, sv4guiPurkinjeNetworkEvent );
 
 /* [davep] what is this for?
 
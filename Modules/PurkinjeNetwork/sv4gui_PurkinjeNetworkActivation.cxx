@@ -0,0 +1,218 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sv4gui_PurkinjeNetworkActivation.h"
+
+#include <mitkLogMacros.h>
+
+#include <vtkSMPTools.h>
+
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <sstream>
+#include <utility>
+
+//------------------------
+// ComputeActivationTimes
+//------------------------
+// Compute the activation time of each network node.
+//
+// Arguments:
+//   sourceNodes - The nodes where activation starts.
+//   sourceTimes - The activation time at each source node.
+//   segmentVelocities - The conduction velocity of each segment.
+//
+// Output:
+//   activationTimes - The activation time of each node, nodes that can't be 
+//     reached from a source are set to -1.
+
+bool sv4guiPurkinjeNetworkActivation::ComputeActivationTimes(sv4guiPurkinjeNetworkGraph& network, 
+    const std::vector<int>& sourceNodes, const std::vector<double>& sourceTimes, 
+    const std::vector<double>& segmentVelocities, std::vector<double>& activationTimes)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkActivation::ComputeActivationTimes] ";
+  MITK_INFO << msgPrefix << "Number of sources " << sourceNodes.size();
+
+  int numNodes = network.GetNumberOfNodes();
+  int numSegments = network.GetNumberOfSegments();
+
+  if (sourceNodes.size() != sourceTimes.size()) {
+    MITK_ERROR << msgPrefix << "The number of source nodes and source times differ.";
+    return false;
+  }
+
+  if (segmentVelocities.size() != numSegments) {
+    MITK_ERROR << msgPrefix << "The number of segment velocities " << segmentVelocities.size() << 
+        " does not equal the number of segments " << numSegments << ".";
+    return false;
+  }
+
+  for (auto node : sourceNodes) {
+    if ((node < 0) || (node >= numNodes)) {
+      MITK_ERROR << msgPrefix << "Source node " << node << " is out of range.";
+      return false;
+    }
+  }
+
+  if (!network.HaveAdjacency()) {
+    network.BuildAdjacency();
+  }
+
+  // Compute segment travel times.
+  //
+  for (auto velocity : segmentVelocities) {
+    if (velocity <= 0.0) {
+      MITK_ERROR << msgPrefix << "Segment velocities must be positive.";
+      return false;
+    }
+  }
+
+  std::vector<double> travelTimes(numSegments);
+
+  auto computeTravelTimes = [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; i++) {
+      travelTimes[i] = network.GetSegmentLength(i) / segmentVelocities[i];
+    }
+  };
+  vtkSMPTools::For(0, numSegments, computeTravelTimes);
+
+  // Propagate activation from the sources in order of increasing time.
+  //
+  const auto& offsets = network.GetAdjacencyOffsets();
+  const auto& adjNodes = network.GetAdjacentNodes();
+  const auto& adjSegments = network.GetAdjacentSegments();
+
+  const double infinity = std::numeric_limits<double>::max();
+  activationTimes.assign(numNodes, infinity);
+
+  typedef std::pair<double,int> QueueEntry;
+  std::vector<QueueEntry> storage;
+  storage.reserve(numNodes);
+  std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue(
+      std::greater<QueueEntry>(), std::move(storage));
+
+  for (int i = 0; i < sourceNodes.size(); i++) {
+    int node = sourceNodes[i];
+    if (sourceTimes[i] < activationTimes[node]) {
+      activationTimes[node] = sourceTimes[i];
+      queue.push(QueueEntry(sourceTimes[i], node));
+    }
+  }
+
+  while (!queue.empty()) {
+    auto entry = queue.top();
+    queue.pop();
+    double time = entry.first;
+    int node = entry.second;
+
+    // Skip entries superseded by an earlier activation.
+    if (time > activationTimes[node]) {
+      continue;
+    }
+
+    for (int j = offsets[node]; j < offsets[node+1]; j++) {
+      int next = adjNodes[j];
+      double nextTime = time + travelTimes[adjSegments[j]];
+      if (nextTime < activationTimes[next]) {
+        activationTimes[next] = nextTime;
+        queue.push(QueueEntry(nextTime, next));
+      }
+    }
+  }
+
+  int numUnreached = 0;
+  for (auto& time : activationTimes) {
+    if (time == infinity) {
+      time = -1.0;
+      numUnreached += 1;
+    }
+  }
+
+  if (numUnreached != 0) {
+    MITK_WARN << msgPrefix << numUnreached << " nodes were not reached from a source.";
+  }
+
+  return true;
+}
+
+//------------------------
+// ComputeActivationTimes
+//------------------------
+// Compute the activation time of each network node using a single
+// conduction velocity for all segments.
+
+bool sv4guiPurkinjeNetworkActivation::ComputeActivationTimes(sv4guiPurkinjeNetworkGraph& network, 
+    const std::vector<int>& sourceNodes, const std::vector<double>& sourceTimes, double velocity, 
+    std::vector<double>& activationTimes)
+{
+  std::vector<double> segmentVelocities(network.GetNumberOfSegments(), velocity);
+  return ComputeActivationTimes(network, sourceNodes, sourceTimes, segmentVelocities, activationTimes);
+}
+
+//-------------
+// ReadSources
+//-------------
+// Read activation sources from a file, one 'node time' pair per line.
+//
+// This is used to set retrograde activation at end nodes from myocardial 
+// activation times.
+
+bool sv4guiPurkinjeNetworkActivation::ReadSources(const std::string& fileName, std::vector<int>& sourceNodes, 
+    std::vector<double>& sourceTimes)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkActivation::ReadSources] ";
+
+  std::ifstream inFile(fileName);
+  if (!inFile.is_open()) {
+    MITK_ERROR << msgPrefix << "Can't open file " << fileName;
+    return false;
+  }
+
+  sourceNodes.clear();
+  sourceTimes.clear();
+  std::string line;
+
+  while (std::getline(inFile, line)) {
+    std::istringstream ss(line);
+    int node;
+    double time;
+    if (!(ss >> node >> time)) {
+      continue;
+    }
+    sourceNodes.push_back(node);
+    sourceTimes.push_back(time);
+  }
+
+  MITK_INFO << msgPrefix << "Number of sources " << sourceNodes.size();
+  return true;
+}
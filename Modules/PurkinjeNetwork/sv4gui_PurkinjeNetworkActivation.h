@@ -0,0 +1,69 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// This class is used to compute activation times on a Purkinje network.
+//
+// Activation times are the solution of the eikonal equation on the network 
+// graph: the activation time of a node is the minimum over all paths from 
+// a source node of the source time plus the path travel time. Travel times 
+// are computed from segment lengths and per-segment conduction velocities.
+// 
+// The equation is solved with a single multi-source Dijkstra pass over the 
+// network adjacency stored in compressed sparse row format.
+//
+// Retrograde activation (propagation from the myocardium back into the network 
+// through the Purkinje-muscle junctions) is modeled by adding end nodes as 
+// sources with their myocardial activation times. 
+
+#ifndef SV4GUI_PURKINJENETWORK_ACTIVATION_H
+#define SV4GUI_PURKINJENETWORK_ACTIVATION_H
+
+#include "sv4guiModulePurkinjeNetworkExports.h"
+#include "sv4gui_PurkinjeNetworkGraph.h"
+
+#include <string>
+#include <vector>
+
+class SV4GUIMODULEPURKINJENETWORK_EXPORT sv4guiPurkinjeNetworkActivation
+{
+  public:
+
+    static bool ComputeActivationTimes(sv4guiPurkinjeNetworkGraph& network, const std::vector<int>& sourceNodes, 
+        const std::vector<double>& sourceTimes, const std::vector<double>& segmentVelocities, 
+        std::vector<double>& activationTimes);
+
+    static bool ComputeActivationTimes(sv4guiPurkinjeNetworkGraph& network, const std::vector<int>& sourceNodes, 
+        const std::vector<double>& sourceTimes, double velocity, std::vector<double>& activationTimes);
+
+    static bool ReadSources(const std::string& fileName, std::vector<int>& sourceNodes, std::vector<double>& sourceTimes);
+};
+
+#endif //SV4GUI_PURKINJENETWORK_ACTIVATION_H
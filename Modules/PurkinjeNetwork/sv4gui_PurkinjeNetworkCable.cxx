@@ -0,0 +1,320 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sv4gui_PurkinjeNetworkCable.h"
+
+#include <mitkLogMacros.h>
+
+#include <vtkSMPTools.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+sv4guiPurkinjeNetworkCable::sv4guiPurkinjeNetworkCable(sv4guiPurkinjeNetworkGraph& network) : 
+    m_Network(network), m_TimeStep(0.0)
+{
+}
+
+sv4guiPurkinjeNetworkCable::~sv4guiPurkinjeNetworkCable()
+{
+}
+
+//------------
+// Initialize
+//------------
+// Compute diffusion coefficients, set the time step and initialize the 
+// state at rest.
+//
+// The potential at the 'sourceNodes' is held at 1 for the stimulus duration.
+//
+// The stable time step for the explicit diffusion update is bounded by 
+// the inverse of the largest row sum of the diffusion coefficients. A 
+// requested time step larger than this is reduced.
+//
+// The row sums grow with the inverse square of the segment length, so a 
+// single very short segment would make the time step tiny. Segments shorter 
+// than the minimum segment length conduct as if they had that length. The 
+// simulation is refused if it still needs more than the maximum number of 
+// time steps.
+
+bool sv4guiPurkinjeNetworkCable::Initialize(const Parameters& params, const std::vector<int>& sourceNodes)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkCable::Initialize] ";
+  m_Parameters = params;
+  int numNodes = m_Network.GetNumberOfNodes();
+
+  if (numNodes == 0) {
+    MITK_ERROR << msgPrefix << "The network has no nodes.";
+    return false;
+  }
+
+  if (params.diffusivity <= 0.0) {
+    MITK_ERROR << msgPrefix << "The diffusivity must be positive.";
+    return false;
+  }
+
+  if (!m_Network.HaveAdjacency()) {
+    m_Network.BuildAdjacency();
+  }
+
+  int numSegments = m_Network.GetNumberOfSegments();
+  double minLength = params.minSegmentLength;
+  if ((minLength <= 0.0) && (numSegments != 0)) {
+    double meanLength = 0.0;
+    for (int i = 0; i < numSegments; i++) {
+      meanLength += m_Network.GetSegmentLength(i);
+    }
+    minLength = 0.1 * meanLength / numSegments;
+  }
+
+  int numShortSegments = 0;
+  for (int i = 0; i < numSegments; i++) {
+    if (m_Network.GetSegmentLength(i) < minLength) {
+      numShortSegments += 1;
+    }
+  }
+  if (numShortSegments != 0) {
+    MITK_WARN << msgPrefix << numShortSegments << " segments shorter than " << minLength 
+        << " conduct as if they had that length.";
+  }
+
+  const auto& offsets = m_Network.GetAdjacencyOffsets();
+  const auto& adjSegments = m_Network.GetAdjacentSegments();
+  m_Coefficients.resize(offsets[numNodes]);
+  std::vector<double> rowSums(numNodes, 0.0);
+
+  // The coefficient for the segment of length L between nodes i and j 
+  // is D / (w_i L) where w_i is the control volume length of node i.
+  //
+  auto computeCoefficients = [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; i++) {
+      double volume = 0.0;
+      for (int j = offsets[i]; j < offsets[i+1]; j++) {
+        volume += 0.5 * std::max(m_Network.GetSegmentLength(adjSegments[j]), minLength);
+      }
+      for (int j = offsets[i]; j < offsets[i+1]; j++) {
+        double length = std::max(m_Network.GetSegmentLength(adjSegments[j]), minLength);
+        double coef = (length > 0.0) ? params.diffusivity / (volume * length) : 0.0;
+        m_Coefficients[j] = coef;
+        rowSums[i] += coef;
+      }
+    }
+  };
+  vtkSMPTools::For(0, numNodes, computeCoefficients);
+
+  double maxRowSum = *std::max_element(rowSums.begin(), rowSums.end());
+  double stableTimeStep = (maxRowSum > 0.0) ? 0.9 / maxRowSum : params.tauIn;
+  stableTimeStep = std::min(stableTimeStep, 0.1 * params.tauIn);
+
+  if (params.timeStep <= 0.0) {
+    m_TimeStep = stableTimeStep;
+  } else if (params.timeStep > stableTimeStep) {
+    MITK_WARN << msgPrefix << "The time step " << params.timeStep << " is reduced to the stable time step " << stableTimeStep;
+    m_TimeStep = stableTimeStep;
+  } else {
+    m_TimeStep = params.timeStep;
+  }
+  MITK_INFO << msgPrefix << "Time step " << m_TimeStep;
+
+  double numSteps = std::ceil(params.endTime / m_TimeStep);
+  if (numSteps > params.maxTimeSteps) {
+    MITK_ERROR << msgPrefix << "The simulation needs " << numSteps << " time steps of " << m_TimeStep 
+        << ", more than the maximum " << params.maxTimeSteps << ". Increase the minimum segment length or resample the network.";
+    m_TimeStep = 0.0;
+    return false;
+  }
+
+  m_V.assign(numNodes, 0.0);
+  m_H.assign(numNodes, 1.0);
+  m_VNew.assign(numNodes, 0.0);
+  m_ActivationTimes.assign(numNodes, -1.0);
+  m_SourceFlags.assign(numNodes, 0);
+
+  for (auto node : sourceNodes) {
+    if ((node < 0) || (node >= numNodes)) {
+      MITK_ERROR << msgPrefix << "Source node " << node << " is out of range.";
+      return false;
+    }
+    m_SourceFlags[node] = 1;
+  }
+
+  return true;
+}
+
+//------
+// Step
+//------
+// Advance the state from 'time' by one time step.
+//
+// The activation time of a node is the time its potential first crosses 
+// the activation threshold, interpolated within the time step.
+
+void sv4guiPurkinjeNetworkCable::Step(double time)
+{
+  int numNodes = m_V.size();
+  const auto& offsets = m_Network.GetAdjacencyOffsets();
+  const auto& adjNodes = m_Network.GetAdjacentNodes();
+  const double dt = m_TimeStep;
+  const auto& p = m_Parameters;
+  const bool stimulate = time < p.stimulusDuration;
+  const double openDecay = std::exp(-dt / p.tauOpen);
+  const double closeDecay = std::exp(-dt / p.tauClose);
+
+  const double* v = m_V.data();
+  const double* coefs = m_Coefficients.data();
+  double* h = m_H.data();
+  double* vNew = m_VNew.data();
+  double* activationTimes = m_ActivationTimes.data();
+
+  auto update = [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; i++) {
+      double vi = v[i];
+      double hi = h[i];
+
+      double diffusion = 0.0;
+      for (int j = offsets[i]; j < offsets[i+1]; j++) {
+        diffusion += coefs[j] * (v[adjNodes[j]] - vi);
+      }
+
+      double ionic = hi * vi * vi * (1.0 - vi) / p.tauIn - vi / p.tauOut;
+      double vn = vi + dt * (diffusion + ionic);
+
+      if (stimulate && m_SourceFlags[i]) {
+        vn = 1.0;
+      }
+
+      if (vi < p.gateVoltage) {
+        h[i] = 1.0 - (1.0 - hi) * openDecay;
+      } else {
+        h[i] = hi * closeDecay;
+      }
+
+      if ((activationTimes[i] < 0.0) && (vn >= p.activationThreshold)) {
+        double s = (vn > vi) ? (p.activationThreshold - vi) / (vn - vi) : 0.0;
+        activationTimes[i] = time + std::max(0.0, s) * dt;
+      }
+
+      vNew[i] = vn;
+    }
+  };
+  vtkSMPTools::For(0, numNodes, update);
+
+  m_V.swap(m_VNew);
+}
+
+//-------
+// Solve
+//-------
+// Advance the solution to the end time. 
+//
+// If 'snapshotPrefix' is not empty the membrane potential and the activation 
+// times computed so far are written as point data named 'Vm' and 
+// 'CableActivationTime' to the files 'snapshotPrefix'_NNNN.vtu every 
+// snapshot interval.
+
+bool sv4guiPurkinjeNetworkCable::Solve(const std::string& snapshotPrefix)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkCable::Solve] ";
+
+  if (m_TimeStep <= 0.0) {
+    MITK_ERROR << msgPrefix << "The solver has not been initialized.";
+    return false;
+  }
+
+  int numSteps = static_cast<int>(std::ceil(m_Parameters.endTime / m_TimeStep));
+  int snapshotSteps = 0;
+  if (m_Parameters.snapshotInterval > 0.0) {
+    snapshotSteps = std::max(1, static_cast<int>(std::round(m_Parameters.snapshotInterval / m_TimeStep)));
+  }
+  MITK_INFO << msgPrefix << "Number of time steps " << numSteps;
+
+  sv4guiPurkinjeNetworkGraph snapshot;
+  bool writeSnapshots = (snapshotPrefix != "") && (snapshotSteps > 0);
+  if (writeSnapshots) {
+    snapshot.SetNodes(m_Network.GetNodes());
+    snapshot.SetSegments(m_Network.GetSegments());
+    snapshot.SetEndNodes(m_Network.GetEndNodes());
+  }
+
+  int snapshotIndex = 0;
+  if (writeSnapshots && !WriteSnapshot(snapshot, snapshotPrefix, snapshotIndex++)) {
+    return false;
+  }
+
+  for (int n = 0; n < numSteps; n++) {
+    Step(n * m_TimeStep);
+
+    if (writeSnapshots && ((n+1) % snapshotSteps == 0)) {
+      if (!WriteSnapshot(snapshot, snapshotPrefix, snapshotIndex++)) {
+        return false;
+      }
+    }
+  }
+
+  int numActivated = std::count_if(m_ActivationTimes.begin(), m_ActivationTimes.end(), 
+      [](double t) { return t >= 0.0; });
+  MITK_INFO << msgPrefix << "Number of activated nodes " << numActivated << " of " << m_ActivationTimes.size();
+  return true;
+}
+
+//----------------------
+// GetMembranePotential
+//----------------------
+// Get the membrane potential in mV scaled from the dimensionless potential.
+
+void sv4guiPurkinjeNetworkCable::GetMembranePotential(std::vector<double>& potential) const
+{
+  double range = m_Parameters.peakPotential - m_Parameters.restingPotential;
+  potential.resize(m_V.size());
+  for (int i = 0; i < m_V.size(); i++) {
+    potential[i] = m_Parameters.restingPotential + range * m_V[i];
+  }
+}
+
+//---------------
+// WriteSnapshot
+//---------------
+
+bool sv4guiPurkinjeNetworkCable::WriteSnapshot(sv4guiPurkinjeNetworkGraph& snapshot, 
+    const std::string& snapshotPrefix, int index)
+{
+  char suffix[16];
+  std::snprintf(suffix, sizeof(suffix), "_%04d.vtu", index);
+
+  std::vector<double> potential;
+  GetMembranePotential(potential);
+  snapshot.SetPointData("Vm", potential);
+  snapshot.SetPointData("CableActivationTime", m_ActivationTimes);
+
+  return snapshot.WriteVtu(snapshotPrefix + suffix);
+}
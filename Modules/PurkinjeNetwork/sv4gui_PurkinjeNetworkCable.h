@@ -0,0 +1,119 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// This class is used to simulate electrical propagation on a Purkinje network.
+//
+// The monodomain cable equation 
+//
+//   dv/dt = D d2v/ds2 + I_ion(v,h)
+//
+// is solved on the network graph using a finite volume discretization: each 
+// node is a control volume of half the length of its adjacent segments and 
+// segments conduct current between their nodes. 
+//
+// The ionic current is given by the two-variable Mitchell-Schaeffer model 
+// with a dimensionless transmembrane potential v in [0,1] and gating 
+// variable h
+//
+//   I_ion = h v^2 (1-v) / tau_in - v / tau_out 
+//   dh/dt = (1-h) / tau_open  if v < v_gate
+//         = -h / tau_close    otherwise
+//
+// Time stepping is semi-implicit: v is advanced with forward Euler and h with 
+// the exact exponential (Rush-Larsen) update. State variables are stored as 
+// separate arrays (structure of arrays) and each time step is a single pass 
+// over the nodes executed in parallel.
+
+#ifndef SV4GUI_PURKINJENETWORK_CABLE_H
+#define SV4GUI_PURKINJENETWORK_CABLE_H
+
+#include "sv4guiModulePurkinjeNetworkExports.h"
+#include "sv4gui_PurkinjeNetworkGraph.h"
+
+#include <string>
+#include <vector>
+
+class SV4GUIMODULEPURKINJENETWORK_EXPORT sv4guiPurkinjeNetworkCable
+{
+  public:
+
+    // Parameter units are ms and network length units (mm).
+    struct Parameters {
+      double diffusivity = 10.0;
+      double timeStep = 0.0;                 // 0 selects the stable time step.
+      double endTime = 100.0;
+      int maxTimeSteps = 1000000;            // Larger step counts are refused.
+      double minSegmentLength = 0.0;         // 0 selects 0.1 of the mean segment length.
+      double snapshotInterval = 1.0;         // 0 disables snapshots.
+      double stimulusDuration = 2.0;
+
+      double tauIn = 0.3;
+      double tauOut = 6.0;
+      double tauOpen = 120.0;
+      double tauClose = 150.0;
+      double gateVoltage = 0.13;
+
+      double activationThreshold = 0.5;
+      double restingPotential = -80.0;       // mV
+      double peakPotential = 20.0;           // mV
+    };
+
+    sv4guiPurkinjeNetworkCable(sv4guiPurkinjeNetworkGraph& network);
+    ~sv4guiPurkinjeNetworkCable();
+
+    bool Initialize(const Parameters& params, const std::vector<int>& sourceNodes);
+    bool Solve(const std::string& snapshotPrefix);
+
+    double GetTimeStep() const { return m_TimeStep; }
+    const std::vector<double>& GetActivationTimes() const { return m_ActivationTimes; }
+    void GetMembranePotential(std::vector<double>& potential) const;
+
+  private:
+
+    sv4guiPurkinjeNetworkGraph& m_Network;
+    Parameters m_Parameters;
+    double m_TimeStep;
+
+    // Diffusion coefficients stored with the network adjacency.
+    std::vector<double> m_Coefficients;
+
+    // State.
+    std::vector<double> m_V;
+    std::vector<double> m_H;
+    std::vector<double> m_VNew;
+    std::vector<double> m_ActivationTimes;
+    std::vector<char> m_SourceFlags;
+
+    void Step(double time);
+    bool WriteSnapshot(sv4guiPurkinjeNetworkGraph& snapshot, const std::string& snapshotPrefix, int index);
+};
+
+#endif //SV4GUI_PURKINJENETWORK_CABLE_H
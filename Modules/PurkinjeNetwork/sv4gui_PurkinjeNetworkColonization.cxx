@@ -0,0 +1,737 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sv4gui_PurkinjeNetworkColonization.h"
+
+#include <mitkLogMacros.h>
+
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include <vtkPoints.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+
+namespace {
+
+double Distance2(const sv4guiPurkinjeNetworkColonization::Point& a, const sv4guiPurkinjeNetworkColonization::Point& b)
+{
+  double dx = a[0] - b[0];
+  double dy = a[1] - b[1];
+  double dz = a[2] - b[2];
+  return dx*dx + dy*dy + dz*dz;
+}
+
+// Check if the bounding box of points 'a', 'b' and 'c' intersects 'bounds' 
+// given as (xmin,xmax, ymin,ymax, zmin,zmax).
+bool InBounds(const double bounds[6], const double* a, const double* b, const double* c)
+{
+  for (int k = 0; k < 3; k++) {
+    if ((std::max({a[k], b[k], c[k]}) < bounds[2*k]) || (std::min({a[k], b[k], c[k]}) > bounds[2*k+1])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+};
+
+sv4guiPurkinjeNetworkColonization::sv4guiPurkinjeNetworkColonization(vtkPolyData* surface) : m_Surface(surface),
+    m_AttractorSpacing(0.0), m_InfluenceRadius(0.0), m_KillRadius(0.0), m_SegmentLength(0.0), 
+    m_MaximumIterations(100000), m_Seed(0)
+{
+}
+
+sv4guiPurkinjeNetworkColonization::~sv4guiPurkinjeNetworkColonization()
+{
+}
+
+//------------
+// Grid::Build
+//------------
+// Bin points into a uniform grid.
+//
+// The cell size is increased if needed so the grid has no more cells 
+// than a few times the number of points.
+
+void sv4guiPurkinjeNetworkColonization::Grid::Build(const std::vector<Point>& points, double cellSize)
+{
+  double lo[3] = { 0.0, 0.0, 0.0 };
+  double hi[3] = { 0.0, 0.0, 0.0 };
+  if (!points.empty()) {
+    for (int k = 0; k < 3; k++) {
+      lo[k] = hi[k] = points[0][k];
+    }
+  }
+  for (const auto& point : points) {
+    for (int k = 0; k < 3; k++) {
+      lo[k] = std::min(lo[k], point[k]);
+      hi[k] = std::max(hi[k], point[k]);
+    }
+  }
+
+  double maxCells = 4.0 * points.size() + 1.0;
+  m_CellSize = cellSize;
+  while (true) {
+    double numCells = 1.0;
+    for (int k = 0; k < 3; k++) {
+      numCells *= std::floor((hi[k] - lo[k]) / m_CellSize) + 1.0;
+    }
+    if (numCells <= maxCells) {
+      break;
+    }
+    m_CellSize *= std::cbrt(numCells / maxCells) * 1.01;
+  }
+
+  for (int k = 0; k < 3; k++) {
+    m_Origin[k] = lo[k];
+    m_Dims[k] = static_cast<int>(std::floor((hi[k] - lo[k]) / m_CellSize)) + 1;
+  }
+
+  // Count the points in each cell and then fill the cells.
+  std::vector<int> cellIds(points.size());
+  m_Offsets.assign(m_Dims[0]*m_Dims[1]*m_Dims[2] + 1, 0);
+  for (size_t i = 0; i < points.size(); i++) {
+    int cell[3];
+    GetCell(points[i], cell);
+    cellIds[i] = cell[0] + m_Dims[0]*(cell[1] + m_Dims[1]*cell[2]);
+    m_Offsets[cellIds[i]+1] += 1;
+  }
+  std::partial_sum(m_Offsets.begin(), m_Offsets.end(), m_Offsets.begin());
+
+  m_Ids.resize(points.size());
+  std::vector<int> next(m_Offsets.begin(), m_Offsets.end()-1);
+  for (size_t i = 0; i < points.size(); i++) {
+    m_Ids[next[cellIds[i]]++] = i;
+  }
+}
+
+void sv4guiPurkinjeNetworkColonization::Grid::GetCell(const Point& point, int cell[3]) const
+{
+  for (int k = 0; k < 3; k++) {
+    int i = static_cast<int>(std::floor((point[k] - m_Origin[k]) / m_CellSize));
+    cell[k] = std::max(0, std::min(m_Dims[k]-1, i));
+  }
+}
+
+//-----------------
+// Grid::FindPoints
+//-----------------
+// Find the points in the cells overlapping a box of half width 'radius' 
+// centered at 'point'. The caller tests the actual distances.
+
+void sv4guiPurkinjeNetworkColonization::Grid::FindPoints(const Point& point, double radius, std::vector<int>& ids) const
+{
+  ids.clear();
+  Point lo, hi;
+  for (int k = 0; k < 3; k++) {
+    lo[k] = point[k] - radius;
+    hi[k] = point[k] + radius;
+  }
+  int c0[3], c1[3];
+  GetCell(lo, c0);
+  GetCell(hi, c1);
+
+  for (int k = c0[2]; k <= c1[2]; k++) {
+    for (int j = c0[1]; j <= c1[1]; j++) {
+      for (int i = c0[0]; i <= c1[0]; i++) {
+        int cell = i + m_Dims[0]*(j + m_Dims[1]*k);
+        ids.insert(ids.end(), m_Ids.begin() + m_Offsets[cell], m_Ids.begin() + m_Offsets[cell+1]);
+      }
+    }
+  }
+}
+
+//------------------
+// SampleAttractors
+//------------------
+// Sample attractor points on the surface with Poisson-disk spacing.
+//
+// Candidate points are sampled uniformly over the surface triangles and 
+// visited in random order. A candidate is accepted if no accepted point 
+// is closer than the attractor spacing.
+//
+// If 'bounds' (xmin,xmax, ymin,ymax, zmin,zmax) is given only the part of 
+// the surface inside it is sampled.
+
+bool sv4guiPurkinjeNetworkColonization::SampleAttractors(const double* bounds)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkColonization::SampleAttractors] ";
+  m_Attractors.clear();
+
+  if ((m_Surface == nullptr) || (m_Surface->GetNumberOfCells() == 0)) {
+    MITK_ERROR << msgPrefix << "The surface has no triangles.";
+    return false;
+  }
+
+  if (m_AttractorSpacing <= 0.0) {
+    MITK_ERROR << msgPrefix << "The attractor spacing must be positive.";
+    return false;
+  }
+
+  // Sample about 4 candidates per spacing squared of area.
+  std::mt19937 generator(m_Seed);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  double density = 4.0 / (m_AttractorSpacing * m_AttractorSpacing);
+  std::vector<Point> candidates;
+  auto cellPoints = vtkSmartPointer<vtkIdList>::New();
+
+  for (vtkIdType i = 0; i < m_Surface->GetNumberOfCells(); i++) {
+    if (m_Surface->GetCellType(i) != VTK_TRIANGLE) {
+      continue;
+    }
+    m_Surface->GetCellPoints(i, cellPoints);
+    Point a, b, c;
+    m_Surface->GetPoint(cellPoints->GetId(0), a.data());
+    m_Surface->GetPoint(cellPoints->GetId(1), b.data());
+    m_Surface->GetPoint(cellPoints->GetId(2), c.data());
+    if ((bounds != nullptr) && !InBounds(bounds, a.data(), b.data(), c.data())) {
+      continue;
+    }
+
+    double u[3] = { b[0]-a[0], b[1]-a[1], b[2]-a[2] };
+    double v[3] = { c[0]-a[0], c[1]-a[1], c[2]-a[2] };
+    double n[3] = { u[1]*v[2]-u[2]*v[1], u[2]*v[0]-u[0]*v[2], u[0]*v[1]-u[1]*v[0] };
+    double area = 0.5 * std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+
+    double expected = density * area;
+    int numSamples = static_cast<int>(expected);
+    if (uniform(generator) < expected - numSamples) {
+      numSamples += 1;
+    }
+
+    for (int j = 0; j < numSamples; j++) {
+      double r1 = std::sqrt(uniform(generator));
+      double r2 = uniform(generator);
+      Point p;
+      for (int k = 0; k < 3; k++) {
+        p[k] = (1.0 - r1)*a[k] + r1*(1.0 - r2)*b[k] + r1*r2*c[k];
+      }
+      if ((bounds == nullptr) || InBounds(bounds, p.data(), p.data(), p.data())) {
+        candidates.push_back(p);
+      }
+    }
+  }
+
+  std::shuffle(candidates.begin(), candidates.end(), generator);
+
+  Grid grid;
+  grid.Build(candidates, m_AttractorSpacing);
+  std::vector<char> accepted(candidates.size(), 0);
+  std::vector<int> ids;
+  double spacing2 = m_AttractorSpacing * m_AttractorSpacing;
+
+  for (size_t i = 0; i < candidates.size(); i++) {
+    grid.FindPoints(candidates[i], m_AttractorSpacing, ids);
+    bool covered = false;
+    for (auto id : ids) {
+      if (accepted[id] && (Distance2(candidates[i], candidates[id]) < spacing2)) {
+        covered = true;
+        break;
+      }
+    }
+    if (!covered) {
+      accepted[i] = 1;
+      m_Attractors.push_back(candidates[i]);
+    }
+  }
+
+  MITK_INFO << msgPrefix << "Number of candidates " << candidates.size() << "  attractors " << m_Attractors.size();
+  return !m_Attractors.empty();
+}
+
+//--------------
+// ProjectPoint 
+//--------------
+// Find the closest point on the surface.
+
+bool sv4guiPurkinjeNetworkColonization::ProjectPoint(const Point& point, Point& projectedPoint) const
+{
+  double dist2;
+  vtkIdType cellId;
+  int subId;
+  m_Locator->FindClosestPoint(point.data(), projectedPoint.data(), cellId, subId, dist2);
+  return cellId != -1;
+}
+
+//---------
+// AddNode 
+//---------
+// Add a node to the network and update the attractors near it.
+//
+// Attractors within the kill radius are removed, attractors within the 
+// influence radius are pulled by the node if it is their nearest node.
+
+int sv4guiPurkinjeNetworkColonization::AddNode(const Point& point)
+{
+  int node = m_Nodes.size();
+  m_Nodes.push_back(point);
+
+  std::vector<int> ids;
+  m_AttractorGrid.FindPoints(point, m_InfluenceRadius, ids);
+  double kill2 = m_KillRadius * m_KillRadius;
+  double influence2 = m_InfluenceRadius * m_InfluenceRadius;
+
+  for (auto id : ids) {
+    if (!m_Alive[id]) {
+      continue;
+    }
+    double d2 = Distance2(point, m_Attractors[id]);
+    if (d2 <= kill2) {
+      m_Alive[id] = 0;
+    } else if ((d2 < influence2) && (d2 < m_NearestDistance2[id])) {
+      if (m_NearestNode[id] == -1) {
+        m_Active.push_back(id);
+      }
+      m_NearestNode[id] = node;
+      m_NearestDistance2[id] = d2;
+    }
+  }
+
+  return node;
+}
+
+//-----------------
+// InitializeGrowth 
+//-----------------
+// Set the default radii, sample the attractors and build the surface 
+// locator.
+//
+// If 'bounds' is given the attractors are sampled again within the influence 
+// radius of 'bounds' and the locator is built only for the surface triangles 
+// within twice the influence radius of 'bounds'. Nodes are only grown toward 
+// attractors so they stay within the located part of the surface.
+
+bool sv4guiPurkinjeNetworkColonization::InitializeGrowth(const std::string& msgPrefix, const double* bounds)
+{
+  if (m_InfluenceRadius <= 0.0) {
+    m_InfluenceRadius = 3.0 * m_AttractorSpacing;
+  }
+  if (m_KillRadius <= 0.0) {
+    m_KillRadius = m_AttractorSpacing;
+  }
+
+  if ((m_SegmentLength <= 0.0) || (m_SegmentLength >= m_KillRadius)) {
+    MITK_ERROR << msgPrefix << "The segment length must be positive and less than the kill radius " << m_KillRadius << ".";
+    return false;
+  }
+
+  if (bounds == nullptr) {
+    if (m_Attractors.empty() && !SampleAttractors()) {
+      return false;
+    }
+    m_Locator = vtkSmartPointer<vtkStaticCellLocator>::New();
+    m_Locator->SetDataSet(m_Surface);
+    m_Locator->BuildLocator();
+    return true;
+  }
+
+  double sampleBounds[6], surfaceBounds[6];
+  for (int k = 0; k < 6; k++) {
+    double sign = (k % 2 == 0) ? -1.0 : 1.0;
+    sampleBounds[k] = bounds[k] + sign * m_InfluenceRadius;
+    surfaceBounds[k] = bounds[k] + sign * 2.0 * m_InfluenceRadius;
+  }
+
+  if (!SampleAttractors(sampleBounds)) {
+    return false;
+  }
+
+  // Copy the surface triangles near the bounds.
+  auto points = vtkSmartPointer<vtkPoints>::New();
+  auto triangles = vtkSmartPointer<vtkCellArray>::New();
+  auto cellPoints = vtkSmartPointer<vtkIdList>::New();
+  std::unordered_map<vtkIdType,vtkIdType> pointIds;
+
+  for (vtkIdType i = 0; i < m_Surface->GetNumberOfCells(); i++) {
+    if (m_Surface->GetCellType(i) != VTK_TRIANGLE) {
+      continue;
+    }
+    m_Surface->GetCellPoints(i, cellPoints);
+    double a[3], b[3], c[3];
+    m_Surface->GetPoint(cellPoints->GetId(0), a);
+    m_Surface->GetPoint(cellPoints->GetId(1), b);
+    m_Surface->GetPoint(cellPoints->GetId(2), c);
+    if (!InBounds(surfaceBounds, a, b, c)) {
+      continue;
+    }
+    vtkIdType ids[3];
+    for (int j = 0; j < 3; j++) {
+      auto it = pointIds.find(cellPoints->GetId(j));
+      if (it == pointIds.end()) {
+        it = pointIds.insert({cellPoints->GetId(j), points->InsertNextPoint(m_Surface->GetPoint(cellPoints->GetId(j)))}).first;
+      }
+      ids[j] = it->second;
+    }
+    triangles->InsertNextCell(3, ids);
+  }
+
+  auto surface = vtkSmartPointer<vtkPolyData>::New();
+  surface->SetPoints(points);
+  surface->SetPolys(triangles);
+  MITK_INFO << msgPrefix << "Number of surface triangles " << surface->GetNumberOfCells();
+
+  m_Locator = vtkSmartPointer<vtkStaticCellLocator>::New();
+  m_Locator->SetDataSet(surface);
+  m_Locator->BuildLocator();
+  return true;
+}
+
+//-------------
+// ResetGrowth 
+//-------------
+// Reset the growth state for the current attractors.
+
+void sv4guiPurkinjeNetworkColonization::ResetGrowth()
+{
+  m_AttractorGrid.Build(m_Attractors, m_InfluenceRadius);
+  m_Alive.assign(m_Attractors.size(), 1);
+  m_NearestNode.assign(m_Attractors.size(), -1);
+  m_NearestDistance2.assign(m_Attractors.size(), std::numeric_limits<double>::max());
+  m_Active.clear();
+  m_Nodes.clear();
+}
+
+//--------------
+// GrowBranches 
+//--------------
+// Grow segments from the nodes toward the attractors until no attractor 
+// is within the influence radius of a node.
+//
+// Returns the number of iterations, counting from 'iteration'.
+
+int sv4guiPurkinjeNetworkColonization::GrowBranches(std::vector<sv4guiPurkinjeNetworkGraph::Segment>& segments, 
+    int iteration)
+{
+  std::vector<Point> pull;
+  std::vector<int> pulledNodes;
+  std::vector<char> pulled;
+  std::vector<Point> lastGrowth;
+  double minStep2 = 0.01 * m_SegmentLength * m_SegmentLength;
+
+  while (iteration < m_MaximumIterations) {
+    m_Active.erase(std::remove_if(m_Active.begin(), m_Active.end(), [&](int id) { return !m_Alive[id]; }), 
+        m_Active.end());
+    if (m_Active.empty()) {
+      break;
+    }
+
+    // Sum the directions from each node to the attractors it is nearest to.
+    pull.resize(m_Nodes.size());
+    pulled.resize(m_Nodes.size(), 0);
+    lastGrowth.resize(m_Nodes.size(), {{std::numeric_limits<double>::max(), 0.0, 0.0}});
+    pulledNodes.clear();
+    for (auto id : m_Active) {
+      int node = m_NearestNode[id];
+      double d = std::sqrt(m_NearestDistance2[id]);
+      if (!pulled[node]) {
+        pulled[node] = 1;
+        pulledNodes.push_back(node);
+        pull[node] = {{0.0, 0.0, 0.0}};
+      }
+      for (int k = 0; k < 3; k++) {
+        pull[node][k] += (m_Attractors[id][k] - m_Nodes[node][k]) / d;
+      }
+    }
+
+    // Grow one segment from each pulled node. A node pulled to the same 
+    // point it grew to before is stuck between attractors and is skipped.
+    int numGrown = 0;
+    for (auto node : pulledNodes) {
+      pulled[node] = 0;
+      double norm = std::sqrt(pull[node][0]*pull[node][0] + pull[node][1]*pull[node][1] + pull[node][2]*pull[node][2]);
+      if (norm == 0.0) {
+        continue;
+      }
+      Point point, nextPoint;
+      for (int k = 0; k < 3; k++) {
+        point[k] = m_Nodes[node][k] + m_SegmentLength * pull[node][k] / norm;
+      }
+      if (!ProjectPoint(point, nextPoint) || (Distance2(nextPoint, m_Nodes[node]) < minStep2) || 
+          (Distance2(nextPoint, lastGrowth[node]) < minStep2)) {
+        continue;
+      }
+      lastGrowth[node] = nextPoint;
+      segments.push_back({node, AddNode(nextPoint)});
+      numGrown += 1;
+    }
+
+    iteration += 1;
+    if (numGrown == 0) {
+      break;
+    }
+  }
+
+  return iteration;
+}
+
+//------
+// Grow 
+//------
+// Grow a network from 'firstPoint' toward the attractors.
+//
+// The network starts with a trunk grown from 'firstPoint' in the direction 
+// of 'secondPoint' until it reaches the influence radius of an attractor. 
+// The root node is node 0.
+
+bool sv4guiPurkinjeNetworkColonization::Grow(const Point& firstPoint, const Point& secondPoint, 
+    sv4guiPurkinjeNetworkGraph& network)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkColonization::Grow] ";
+  auto startTime = std::chrono::steady_clock::now();
+
+  if (!InitializeGrowth(msgPrefix)) {
+    return false;
+  }
+
+  ResetGrowth();
+  std::vector<sv4guiPurkinjeNetworkGraph::Segment> segments;
+
+  Point root;
+  if (!ProjectPoint(firstPoint, root)) {
+    MITK_ERROR << msgPrefix << "The first point could not be projected onto the surface.";
+    return false;
+  }
+  AddNode(root);
+
+  // Grow the trunk.
+  Point dir;
+  double length = std::sqrt(Distance2(secondPoint, firstPoint));
+  if (length == 0.0) {
+    MITK_ERROR << msgPrefix << "The first and second points are the same.";
+    return false;
+  }
+  for (int k = 0; k < 3; k++) {
+    dir[k] = (secondPoint[k] - firstPoint[k]) / length;
+  }
+
+  int iteration = 0;
+  while (m_Active.empty() && (iteration < m_MaximumIterations)) {
+    int last = m_Nodes.size() - 1;
+    Point point, nextPoint;
+    for (int k = 0; k < 3; k++) {
+      point[k] = m_Nodes[last][k] + m_SegmentLength * dir[k];
+    }
+    if (!ProjectPoint(point, nextPoint)) {
+      break;
+    }
+    double step = std::sqrt(Distance2(nextPoint, m_Nodes[last]));
+    if (step < 0.1 * m_SegmentLength) {
+      break;
+    }
+    for (int k = 0; k < 3; k++) {
+      dir[k] = (nextPoint[k] - m_Nodes[last][k]) / step;
+    }
+    segments.push_back({last, AddNode(nextPoint)});
+    iteration += 1;
+  }
+
+  // Grow toward the attractors.
+  iteration = GrowBranches(segments, iteration);
+
+  // End nodes are the nodes other than the root with a single segment.
+  std::vector<int> endNodes;
+  GetEndNodes(segments, endNodes);
+
+  int numRemaining = std::count(m_Alive.begin(), m_Alive.end(), 1);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+  MITK_INFO << msgPrefix << "Number of iterations " << iteration << "  nodes " << m_Nodes.size() << "  end nodes " 
+      << endNodes.size() << "  attractors remaining " << numRemaining << "  time " << elapsed.count() << " s";
+
+  if (segments.empty()) {
+    MITK_ERROR << msgPrefix << "No segments were grown.";
+    return false;
+  }
+
+  network.SetNodes(m_Nodes);
+  network.SetSegments(segments);
+  network.SetEndNodes(endNodes);
+  network.SetRootNode(0);
+  return true;
+}
+
+//--------
+// Regrow 
+//--------
+// Grow a new subtree from node 'startNode' of an existing network to 
+// replace the subtree made of the segments 'removedSegments'.
+//
+// Attractors are sampled again only near the bounding box of the removed 
+// subtree and the surface locator is built only for that part of the 
+// surface. Attractors within the influence radius of the removed subtree 
+// and farther than the kill radius from the rest of the network, found 
+// using 'segmentTree' built for 'network', are used. Apart from a scan of 
+// the surface triangle bounds, the cost depends on the size of the region 
+// of the subtree rather than on the size of the surface or the network.
+//
+// Returns the new nodes, segments and end nodes. Node 'startNode' keeps its 
+// index, new node i is node network.GetNumberOfNodes()+i.
+
+bool sv4guiPurkinjeNetworkColonization::Regrow(const sv4guiPurkinjeNetworkGraph& network, 
+    const sv4guiPurkinjeNetworkSegmentTree& segmentTree, int startNode, const std::vector<int>& removedSegments, 
+    std::vector<Point>& nodes, std::vector<sv4guiPurkinjeNetworkGraph::Segment>& segments, std::vector<int>& endNodes)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkColonization::Regrow] ";
+  auto startTime = std::chrono::steady_clock::now();
+  nodes.clear();
+  segments.clear();
+  endNodes.clear();
+
+  // Build a tree for the removed subtree.
+  sv4guiPurkinjeNetworkGraph subtree;
+  std::vector<Point> subtreeNodes;
+  std::vector<sv4guiPurkinjeNetworkGraph::Segment> subtreeSegments;
+  std::map<int,int> subtreeNodeIds;
+  std::vector<char> removed(network.GetNumberOfSegments(), 0);
+  double lo[3], hi[3];
+  for (int k = 0; k < 3; k++) {
+    lo[k] = hi[k] = network.GetNodes()[startNode][k];
+  }
+
+  for (auto id : removedSegments) {
+    removed[id] = 1;
+    sv4guiPurkinjeNetworkGraph::Segment segment;
+    for (int j = 0; j < 2; j++) {
+      int node = network.GetSegments()[id][j];
+      auto it = subtreeNodeIds.find(node);
+      if (it == subtreeNodeIds.end()) {
+        it = subtreeNodeIds.insert({node, static_cast<int>(subtreeNodes.size())}).first;
+        const auto& point = network.GetNodes()[node];
+        subtreeNodes.push_back(point);
+        for (int k = 0; k < 3; k++) {
+          lo[k] = std::min(lo[k], point[k]);
+          hi[k] = std::max(hi[k], point[k]);
+        }
+      }
+      segment[j] = it->second;
+    }
+    subtreeSegments.push_back(segment);
+  }
+
+  if (subtreeSegments.empty()) {
+    MITK_ERROR << msgPrefix << "No segments were removed.";
+    return false;
+  }
+
+  double bounds[6] = { lo[0], hi[0], lo[1], hi[1], lo[2], hi[2] };
+  if (!InitializeGrowth(msgPrefix, bounds)) {
+    return false;
+  }
+
+  subtree.SetNodes(subtreeNodes);
+  subtree.SetSegments(subtreeSegments);
+  sv4guiPurkinjeNetworkSegmentTree subtreeTree;
+  subtreeTree.Build(subtree);
+
+  // Select the attractors.
+  std::vector<Point> attractors;
+  for (const auto& point : m_Attractors) {
+    bool inside = true;
+    for (int k = 0; k < 3; k++) {
+      inside = inside && (point[k] >= lo[k] - m_InfluenceRadius) && (point[k] <= hi[k] + m_InfluenceRadius);
+    }
+    if (!inside) {
+      continue;
+    }
+    int segment;
+    double param, distance;
+    subtreeTree.FindClosestSegment(point.data(), segment, param, distance);
+    if (distance >= m_InfluenceRadius) {
+      continue;
+    }
+    if (segmentTree.FindClosestSegment(point.data(), segment, param, distance, &removed) && 
+        (distance <= m_KillRadius)) {
+      continue;
+    }
+    attractors.push_back(point);
+  }
+
+  // Grow from the start node using the selected attractors.
+  std::swap(m_Attractors, attractors);
+  ResetGrowth();
+  AddNode(network.GetNodes()[startNode]);
+  std::vector<sv4guiPurkinjeNetworkGraph::Segment> localSegments;
+  int iteration = GrowBranches(localSegments, 0);
+  std::vector<int> localEndNodes;
+  GetEndNodes(localSegments, localEndNodes);
+  int numAttractors = m_Attractors.size();
+  int numRemaining = std::count(m_Alive.begin(), m_Alive.end(), 1);
+  std::swap(m_Attractors, attractors);
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+  MITK_INFO << msgPrefix << "Number of attractors " << numAttractors << "  iterations " << iteration << "  nodes " 
+      << m_Nodes.size() << "  end nodes " << localEndNodes.size() << "  attractors remaining " << numRemaining 
+      << "  time " << elapsed.count() << " s";
+
+  if (localSegments.empty()) {
+    MITK_ERROR << msgPrefix << "No segments were grown.";
+    return false;
+  }
+
+  // Number the new nodes after the network nodes.
+  int offset = network.GetNumberOfNodes() - 1;
+  auto nodeId = [&](int node) { return (node == 0) ? startNode : node + offset; };
+  nodes.assign(m_Nodes.begin() + 1, m_Nodes.end());
+  for (const auto& segment : localSegments) {
+    segments.push_back({{ nodeId(segment[0]), nodeId(segment[1]) }});
+  }
+  for (auto node : localEndNodes) {
+    endNodes.push_back(nodeId(node));
+  }
+  return true;
+}
+
+//-------------
+// GetEndNodes 
+//-------------
+// Get the nodes other than node 0 with a single segment.
+
+void sv4guiPurkinjeNetworkColonization::GetEndNodes(const std::vector<sv4guiPurkinjeNetworkGraph::Segment>& segments,
+    std::vector<int>& endNodes) const
+{
+  std::vector<int> degree(m_Nodes.size(), 0);
+  for (const auto& segment : segments) {
+    degree[segment[0]] += 1;
+    degree[segment[1]] += 1;
+  }
+  endNodes.clear();
+  for (size_t i = 1; i < m_Nodes.size(); i++) {
+    if (degree[i] == 1) {
+      endNodes.push_back(i);
+    }
+  }
+}
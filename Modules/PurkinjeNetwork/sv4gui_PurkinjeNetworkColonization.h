@@ -0,0 +1,136 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// This class is used to grow a Purkinje network on a surface using the 
+// space colonization algorithm.
+//
+// Attractor points are sampled on the surface with Poisson-disk spacing. 
+// At each iteration every attractor pulls the network node nearest to it 
+// within the influence radius. Each node that is pulled grows a segment 
+// in the average direction of its attractors, projected onto the surface. 
+// Attractors within the kill radius of a node are removed. Growth stops 
+// when no attractor is within the influence radius of the network.
+//
+// The network density is set directly by the attractor spacing, terminal 
+// branches end about one kill radius apart.
+//
+// Attractors are binned in a uniform grid with cells the size of the 
+// influence radius. Each attractor stores its nearest node, updated only 
+// when a node is added near it, so an iteration costs time proportional 
+// to the number of active attractors and new nodes.
+//
+// A subtree of an existing network can be regrown using only attractors 
+// sampled near it, see Regrow().
+
+#ifndef SV4GUI_PURKINJENETWORK_COLONIZATION_H
+#define SV4GUI_PURKINJENETWORK_COLONIZATION_H
+
+#include "sv4guiModulePurkinjeNetworkExports.h"
+#include "sv4gui_PurkinjeNetworkGraph.h"
+#include "sv4gui_PurkinjeNetworkSegmentTree.h"
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkStaticCellLocator.h>
+
+#include <string>
+#include <vector>
+
+class SV4GUIMODULEPURKINJENETWORK_EXPORT sv4guiPurkinjeNetworkColonization
+{
+  public:
+
+    typedef sv4guiPurkinjeNetworkGraph::Point Point;
+
+    sv4guiPurkinjeNetworkColonization(vtkPolyData* surface);
+    ~sv4guiPurkinjeNetworkColonization();
+
+    // The influence and kill radii default to 3 and 1 times the attractor spacing.
+    void SetAttractorSpacing(double spacing) { m_AttractorSpacing = spacing; }
+    void SetInfluenceRadius(double radius) { m_InfluenceRadius = radius; }
+    void SetKillRadius(double radius) { m_KillRadius = radius; }
+    void SetSegmentLength(double length) { m_SegmentLength = length; }
+    void SetMaximumIterations(int numIterations) { m_MaximumIterations = numIterations; }
+    void SetSeed(unsigned int seed) { m_Seed = seed; }
+
+    bool SampleAttractors(const double* bounds = nullptr);
+    const std::vector<Point>& GetAttractors() const { return m_Attractors; }
+
+    bool Grow(const Point& firstPoint, const Point& secondPoint, sv4guiPurkinjeNetworkGraph& network);
+    bool Regrow(const sv4guiPurkinjeNetworkGraph& network, const sv4guiPurkinjeNetworkSegmentTree& segmentTree, 
+        int startNode, const std::vector<int>& removedSegments, std::vector<Point>& nodes, 
+        std::vector<sv4guiPurkinjeNetworkGraph::Segment>& segments, std::vector<int>& endNodes);
+
+  private:
+
+    // A uniform grid of points stored in compressed sparse row format.
+    class Grid {
+      public:
+        void Build(const std::vector<Point>& points, double cellSize);
+        void FindPoints(const Point& point, double radius, std::vector<int>& ids) const;
+      private:
+        void GetCell(const Point& point, int cell[3]) const;
+        double m_Origin[3];
+        double m_CellSize;
+        int m_Dims[3];
+        std::vector<int> m_Offsets;
+        std::vector<int> m_Ids;
+    };
+
+    vtkPolyData* m_Surface;
+    vtkSmartPointer<vtkStaticCellLocator> m_Locator;
+
+    double m_AttractorSpacing;
+    double m_InfluenceRadius;
+    double m_KillRadius;
+    double m_SegmentLength;
+    int m_MaximumIterations;
+    unsigned int m_Seed;
+
+    std::vector<Point> m_Attractors;
+
+    // Growth state.
+    Grid m_AttractorGrid;
+    std::vector<char> m_Alive;
+    std::vector<int> m_NearestNode;
+    std::vector<double> m_NearestDistance2;
+    std::vector<int> m_Active;
+    std::vector<Point> m_Nodes;
+
+    bool InitializeGrowth(const std::string& msgPrefix, const double* bounds = nullptr);
+    void ResetGrowth();
+    int GrowBranches(std::vector<sv4guiPurkinjeNetworkGraph::Segment>& segments, int iteration);
+    void GetEndNodes(const std::vector<sv4guiPurkinjeNetworkGraph::Segment>& segments, std::vector<int>& endNodes) const;
+    bool ProjectPoint(const Point& point, Point& projectedPoint) const;
+    int AddNode(const Point& point);
+};
+
+#endif //SV4GUI_PURKINJENETWORK_COLONIZATION_H
@@ -0,0 +1,435 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sv4gui_PurkinjeNetworkCoupling.h"
+
+#include <mitkLogMacros.h>
+
+#include <vtkGenericCell.h>
+#include <vtkIdList.h>
+#include <vtkSMPTools.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <map>
+
+sv4guiPurkinjeNetworkCoupling::sv4guiPurkinjeNetworkCoupling(vtkDataSet* mesh) : m_Mesh(mesh), m_MeanEdgeLength(0.0)
+{
+}
+
+sv4guiPurkinjeNetworkCoupling::~sv4guiPurkinjeNetworkCoupling()
+{
+}
+
+//-----------
+// GetMethod
+//-----------
+// Get the coupling method from its name: 'none', 'nearest' or 'barycentric'.
+
+bool sv4guiPurkinjeNetworkCoupling::GetMethod(const std::string& name, Method& method)
+{
+  if (name == "" || name == "none") {
+    method = Method::None;
+  } else if (name == "nearest") {
+    method = Method::Nearest;
+  } else if (name == "barycentric") {
+    method = Method::Barycentric;
+  } else {
+    MITK_ERROR << "[sv4guiPurkinjeNetworkCoupling::GetMethod] Unknown PMJ coupling method '" << name << "'.";
+    return false;
+  }
+  return true;
+}
+
+void sv4guiPurkinjeNetworkCoupling::BuildPointLocator()
+{
+  if (m_PointLocator != nullptr) {
+    return;
+  }
+  m_PointLocator = vtkSmartPointer<vtkStaticPointLocator>::New();
+  m_PointLocator->SetDataSet(m_Mesh);
+  m_PointLocator->BuildLocator();
+}
+
+void sv4guiPurkinjeNetworkCoupling::BuildCellLocator()
+{
+  if (m_CellLocator != nullptr) {
+    return;
+  }
+  m_CellLocator = vtkSmartPointer<vtkStaticCellLocator>::New();
+  m_CellLocator->SetDataSet(m_Mesh);
+  m_CellLocator->BuildLocator();
+}
+
+//-------------------
+// GetMeanEdgeLength
+//-------------------
+// Get the mean edge length of the mesh cells, computed once from a sample 
+// of at most 10000 cells. The distances between all pairs of cell points 
+// are used, these are the edges of tetrahedral cells.
+
+double sv4guiPurkinjeNetworkCoupling::GetMeanEdgeLength()
+{
+  if (m_MeanEdgeLength > 0.0) {
+    return m_MeanEdgeLength;
+  }
+
+  vtkIdType numCells = m_Mesh->GetNumberOfCells();
+  vtkIdType stride = std::max(numCells / 10000, vtkIdType(1));
+  auto cellPoints = vtkSmartPointer<vtkIdList>::New();
+  double p1[3], p2[3];
+  double sum = 0.0;
+  int64_t numEdges = 0;
+
+  for (vtkIdType i = 0; i < numCells; i += stride) {
+    m_Mesh->GetCellPoints(i, cellPoints);
+    vtkIdType numCellPoints = cellPoints->GetNumberOfIds();
+    for (vtkIdType j = 0; j < numCellPoints; j++) {
+      m_Mesh->GetPoint(cellPoints->GetId(j), p1);
+      for (vtkIdType k = j+1; k < numCellPoints; k++) {
+        m_Mesh->GetPoint(cellPoints->GetId(k), p2);
+        sum += std::sqrt((p1[0]-p2[0])*(p1[0]-p2[0]) + (p1[1]-p2[1])*(p1[1]-p2[1]) + (p1[2]-p2[2])*(p1[2]-p2[2]));
+        numEdges += 1;
+      }
+    }
+  }
+
+  if (numEdges != 0) {
+    m_MeanEdgeLength = sum / numEdges;
+  }
+  return m_MeanEdgeLength;
+}
+
+//-------------
+// MapEndNodes
+//-------------
+// Map the end nodes of a network to the mesh.
+
+bool sv4guiPurkinjeNetworkCoupling::MapEndNodes(const sv4guiPurkinjeNetworkGraph& network, Method method, 
+    Matrix& matrix, int numNearest)
+{
+  const auto& nodes = network.GetNodes();
+  const auto& endNodes = network.GetEndNodes();
+  std::vector<sv4guiPurkinjeNetworkGraph::Point> points;
+  points.reserve(endNodes.size());
+  for (auto node : endNodes) {
+    points.push_back(nodes[node]);
+  }
+
+  bool result = false;
+  if (method == Method::Nearest) {
+    result = MapNearestNodes(points, numNearest, matrix);
+  } else if (method == Method::Barycentric) {
+    result = MapContainingCells(points, matrix);
+  }
+
+  if (result) {
+    matrix.rowNodes.assign(endNodes.begin(), endNodes.end());
+  }
+
+  return result;
+}
+
+//-----------------
+// MapNearestNodes
+//-----------------
+// Map points to their 'numNearest' nearest mesh nodes. 
+//
+// Weights are proportional to the inverse distance to each node and sum 
+// to 1. A point coinciding with a mesh node is mapped to that node only.
+
+bool sv4guiPurkinjeNetworkCoupling::MapNearestNodes(const std::vector<sv4guiPurkinjeNetworkGraph::Point>& points, 
+    int numNearest, Matrix& matrix)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkCoupling::MapNearestNodes] ";
+  MITK_INFO << msgPrefix << "Number of points " << points.size();
+
+  if ((m_Mesh == nullptr) || (m_Mesh->GetNumberOfPoints() < numNearest) || (numNearest < 1)) {
+    MITK_ERROR << msgPrefix << "The mesh has fewer than " << numNearest << " nodes.";
+    return false;
+  }
+
+  BuildPointLocator();
+
+  int numPoints = points.size();
+  matrix.numColumns = m_Mesh->GetNumberOfPoints();
+  matrix.rowNodes.resize(numPoints);
+  matrix.rowOffsets.resize(numPoints+1);
+  matrix.columns.resize(numPoints*numNearest);
+  matrix.values.resize(numPoints*numNearest);
+
+  for (int i = 0; i <= numPoints; i++) {
+    matrix.rowOffsets[i] = i * numNearest;
+  }
+
+  auto mapPoints = [&](vtkIdType begin, vtkIdType end) {
+    auto ids = vtkSmartPointer<vtkIdList>::New();
+    double meshPoint[3];
+    std::vector<double> distances(numNearest);
+
+    for (vtkIdType i = begin; i < end; i++) {
+      matrix.rowNodes[i] = i;
+      m_PointLocator->FindClosestNPoints(numNearest, points[i].data(), ids);
+      int64_t offset = matrix.rowOffsets[i];
+      int exactMatch = -1;
+
+      for (int j = 0; j < numNearest; j++) {
+        m_Mesh->GetPoint(ids->GetId(j), meshPoint);
+        double d2 = 0.0;
+        for (int k = 0; k < 3; k++) {
+          d2 += (meshPoint[k] - points[i][k]) * (meshPoint[k] - points[i][k]);
+        }
+        distances[j] = std::sqrt(d2);
+        matrix.columns[offset+j] = ids->GetId(j);
+        if ((distances[j] == 0.0) && (exactMatch == -1)) {
+          exactMatch = j;
+        }
+      }
+
+      double sum = 0.0;
+      for (int j = 0; j < numNearest; j++) {
+        double w = (exactMatch == -1) ? 1.0 / distances[j] : (j == exactMatch ? 1.0 : 0.0);
+        matrix.values[offset+j] = w;
+        sum += w;
+      }
+      for (int j = 0; j < numNearest; j++) {
+        matrix.values[offset+j] /= sum;
+      }
+    }
+  };
+  vtkSMPTools::For(0, numPoints, mapPoints);
+
+  return true;
+}
+
+//--------------------
+// MapContainingCells
+//--------------------
+// Map points to the nodes of the mesh cell containing them using the 
+// cell interpolation (barycentric for tetrahedra) weights.
+//
+// Network end nodes are grown on the mesh surface so many lie on a cell 
+// face or just outside it. A point within 0.01 of the mean mesh edge length 
+// of a cell is mapped to that cell, negative weights are clamped to 0. 
+// Points further outside the mesh are mapped to their nearest mesh node.
+
+bool sv4guiPurkinjeNetworkCoupling::MapContainingCells(const std::vector<sv4guiPurkinjeNetworkGraph::Point>& points, 
+    Matrix& matrix)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkCoupling::MapContainingCells] ";
+  MITK_INFO << msgPrefix << "Number of points " << points.size();
+
+  if ((m_Mesh == nullptr) || (m_Mesh->GetNumberOfCells() == 0)) {
+    MITK_ERROR << msgPrefix << "The mesh has no cells.";
+    return false;
+  }
+
+  BuildPointLocator();
+  BuildCellLocator();
+
+  // FindCell() takes the squared tolerance.
+  double tolerance = 0.01 * GetMeanEdgeLength();
+  double tolerance2 = tolerance * tolerance;
+  MITK_INFO << msgPrefix << "Cell tolerance " << tolerance;
+
+  int numPoints = points.size();
+  std::vector<std::vector<vtkIdType>> rowColumns(numPoints);
+  std::vector<std::vector<double>> rowValues(numPoints);
+  std::atomic<int> numOutside(0);
+
+  auto mapPoints = [&](vtkIdType begin, vtkIdType end) {
+    auto cell = vtkSmartPointer<vtkGenericCell>::New();
+    double point[3], pcoords[3];
+    double weights[VTK_CELL_SIZE];
+
+    for (vtkIdType i = begin; i < end; i++) {
+      point[0] = points[i][0];
+      point[1] = points[i][1];
+      point[2] = points[i][2];
+      vtkIdType cellId = m_CellLocator->FindCell(point, tolerance2, cell, pcoords, weights);
+
+      if (cellId < 0) {
+        numOutside++;
+        rowColumns[i].push_back(m_PointLocator->FindClosestPoint(point));
+        rowValues[i].push_back(1.0);
+        continue;
+      }
+
+      // A point just outside the cell has small negative weights.
+      int numCellPoints = cell->GetNumberOfPoints();
+      double weightSum = 0.0;
+      for (int j = 0; j < numCellPoints; j++) {
+        weights[j] = std::max(weights[j], 0.0);
+        weightSum += weights[j];
+      }
+      for (int j = 0; j < numCellPoints; j++) {
+        rowColumns[i].push_back(cell->GetPointId(j));
+        rowValues[i].push_back(weights[j] / weightSum);
+      }
+    }
+  };
+  vtkSMPTools::For(0, numPoints, mapPoints);
+
+  if (numOutside != 0) {
+    MITK_WARN << msgPrefix << numOutside << " of " << numPoints << " points are further than " << tolerance 
+        << " outside the mesh and were mapped to their nearest node.";
+  } else {
+    MITK_INFO << msgPrefix << "All points were mapped to a mesh cell.";
+  }
+
+  // Assemble the CSR matrix.
+  //
+  matrix.numColumns = m_Mesh->GetNumberOfPoints();
+  matrix.rowNodes.resize(numPoints);
+  matrix.rowOffsets.assign(1, 0);
+  matrix.columns.clear();
+  matrix.values.clear();
+
+  for (int i = 0; i < numPoints; i++) {
+    matrix.rowNodes[i] = i;
+    matrix.columns.insert(matrix.columns.end(), rowColumns[i].begin(), rowColumns[i].end());
+    matrix.values.insert(matrix.values.end(), rowValues[i].begin(), rowValues[i].end());
+    matrix.rowOffsets.push_back(matrix.columns.size());
+  }
+
+  return true;
+}
+
+//-----------------
+// MapEndNodeTimes
+//-----------------
+// Map the activation times of the end nodes of a network to their nearest 
+// mesh nodes.
+//
+// The network must have 'ActivationTime' point data. The time of a mesh node 
+// is the end node activation time plus the time to travel from the end node 
+// to the mesh node with the given velocity. Mesh nodes mapped from several 
+// end nodes use the earliest time, end nodes that were not activated are 
+// skipped.
+
+bool sv4guiPurkinjeNetworkCoupling::MapEndNodeTimes(const sv4guiPurkinjeNetworkGraph& network, double velocity, 
+    std::vector<vtkIdType>& meshNodes, std::vector<double>& times)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkCoupling::MapEndNodeTimes] ";
+
+  auto it = network.GetPointData().find("ActivationTime");
+  if (it == network.GetPointData().end()) {
+    MITK_ERROR << msgPrefix << "The network does not have activation times.";
+    return false;
+  }
+  const auto& networkTimes = it->second;
+
+  if ((m_Mesh == nullptr) || (m_Mesh->GetNumberOfPoints() == 0)) {
+    MITK_ERROR << msgPrefix << "The mesh has no nodes.";
+    return false;
+  }
+
+  BuildPointLocator();
+
+  const auto& nodes = network.GetNodes();
+  const auto& endNodes = network.GetEndNodes();
+  int numEndNodes = endNodes.size();
+  std::vector<vtkIdType> endNodeMeshNodes(numEndNodes);
+  std::vector<double> endNodeTimes(numEndNodes);
+
+  auto mapPoints = [&](vtkIdType begin, vtkIdType end) {
+    double meshPoint[3];
+    for (vtkIdType i = begin; i < end; i++) {
+      const auto& point = nodes[endNodes[i]];
+      endNodeMeshNodes[i] = m_PointLocator->FindClosestPoint(point.data());
+      m_Mesh->GetPoint(endNodeMeshNodes[i], meshPoint);
+      double d2 = 0.0;
+      for (int k = 0; k < 3; k++) {
+        d2 += (meshPoint[k] - point[k]) * (meshPoint[k] - point[k]);
+      }
+      endNodeTimes[i] = networkTimes[endNodes[i]] + std::sqrt(d2) / velocity;
+    }
+  };
+  vtkSMPTools::For(0, numEndNodes, mapPoints);
+
+  std::map<vtkIdType, double> meshNodeTimes;
+  for (int i = 0; i < numEndNodes; i++) {
+    if (networkTimes[endNodes[i]] < 0.0) {
+      continue;
+    }
+    auto result = meshNodeTimes.insert(std::make_pair(endNodeMeshNodes[i], endNodeTimes[i]));
+    if (!result.second && (endNodeTimes[i] < result.first->second)) {
+      result.first->second = endNodeTimes[i];
+    }
+  }
+
+  meshNodes.clear();
+  times.clear();
+  for (const auto& entry : meshNodeTimes) {
+    meshNodes.push_back(entry.first);
+    times.push_back(entry.second);
+  }
+  MITK_INFO << msgPrefix << "Mapped " << numEndNodes << " end nodes to " << meshNodes.size() << " mesh nodes.";
+
+  return meshNodes.size() != 0;
+}
+
+//-------------
+// WriteMatrix
+//-------------
+// Write a coupling matrix to a binary file.
+//
+// The file contains, in native byte order
+//
+//   int64 numRows, numColumns, numNonzeros
+//   int64 rowNodes[numRows]         - network node of each row
+//   int64 rowOffsets[numRows+1]     - CSR row offsets
+//   int64 columns[numNonzeros]      - mesh node ids
+//   float64 values[numNonzeros]     - weights
+
+bool sv4guiPurkinjeNetworkCoupling::WriteMatrix(const std::string& fileName, const Matrix& matrix)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkCoupling::WriteMatrix] ";
+  MITK_INFO << msgPrefix << "File name " << fileName;
+
+  std::ofstream outFile(fileName, std::ios::binary);
+  if (!outFile.is_open()) {
+    MITK_ERROR << msgPrefix << "Can't open file " << fileName;
+    return false;
+  }
+
+  int64_t header[3] = { static_cast<int64_t>(matrix.rowNodes.size()), matrix.numColumns, 
+      static_cast<int64_t>(matrix.columns.size()) };
+  outFile.write(reinterpret_cast<const char*>(header), sizeof(header));
+  outFile.write(reinterpret_cast<const char*>(matrix.rowNodes.data()), matrix.rowNodes.size()*sizeof(int64_t));
+  outFile.write(reinterpret_cast<const char*>(matrix.rowOffsets.data()), matrix.rowOffsets.size()*sizeof(int64_t));
+  outFile.write(reinterpret_cast<const char*>(matrix.columns.data()), matrix.columns.size()*sizeof(int64_t));
+  outFile.write(reinterpret_cast<const char*>(matrix.values.data()), matrix.values.size()*sizeof(double));
+
+  return outFile.good();
+}
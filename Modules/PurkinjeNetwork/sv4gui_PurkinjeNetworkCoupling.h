@@ -0,0 +1,107 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// This class is used to couple Purkinje network end nodes (Purkinje-muscle 
+// junctions, PMJs) to a myocardium volume mesh.
+//
+// Each end node is mapped to either 
+//   1) Its nearest volume mesh nodes with inverse distance weights.
+//   2) The volume mesh cell containing it with barycentric (interpolation) weights. 
+//      End nodes within a small fraction of the mean mesh edge length of a cell 
+//      are mapped to that cell, end nodes further outside the mesh are mapped 
+//      to their nearest mesh node.
+//
+// Spatial indexes of the mesh points and cells are built once when first used 
+// so a coupling object can map any number of networks to the same mesh. End 
+// nodes are mapped in parallel.
+//
+// The coupling is stored as a sparse matrix in compressed sparse row (CSR) format 
+// with a row for each end node and a column for each mesh node.
+//
+// End node activation times can also be mapped to their nearest mesh nodes to 
+// seed activation time computations on surface and volume meshes.
+
+#ifndef SV4GUI_PURKINJENETWORK_COUPLING_H
+#define SV4GUI_PURKINJENETWORK_COUPLING_H
+
+#include "sv4guiModulePurkinjeNetworkExports.h"
+#include "sv4gui_PurkinjeNetworkGraph.h"
+
+#include <vtkDataSet.h>
+#include <vtkSmartPointer.h>
+#include <vtkStaticCellLocator.h>
+#include <vtkStaticPointLocator.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class SV4GUIMODULEPURKINJENETWORK_EXPORT sv4guiPurkinjeNetworkCoupling
+{
+  public:
+
+    enum class Method { None, Nearest, Barycentric };
+
+    // The coupling matrix, row i couples network node rowNodes[i].
+    struct Matrix {
+      int64_t numColumns = 0;
+      std::vector<int64_t> rowNodes;
+      std::vector<int64_t> rowOffsets;
+      std::vector<int64_t> columns;
+      std::vector<double> values;
+    };
+
+    sv4guiPurkinjeNetworkCoupling(vtkDataSet* mesh);
+    ~sv4guiPurkinjeNetworkCoupling();
+
+    static bool GetMethod(const std::string& name, Method& method);
+
+    bool MapEndNodes(const sv4guiPurkinjeNetworkGraph& network, Method method, Matrix& matrix, int numNearest=1);
+    bool MapNearestNodes(const std::vector<sv4guiPurkinjeNetworkGraph::Point>& points, int numNearest, Matrix& matrix);
+    bool MapContainingCells(const std::vector<sv4guiPurkinjeNetworkGraph::Point>& points, Matrix& matrix);
+    bool MapEndNodeTimes(const sv4guiPurkinjeNetworkGraph& network, double velocity, std::vector<vtkIdType>& meshNodes, 
+        std::vector<double>& times);
+
+    static bool WriteMatrix(const std::string& fileName, const Matrix& matrix);
+
+  private:
+
+    vtkSmartPointer<vtkDataSet> m_Mesh;
+    vtkSmartPointer<vtkStaticPointLocator> m_PointLocator;
+    vtkSmartPointer<vtkStaticCellLocator> m_CellLocator;
+    double m_MeanEdgeLength;
+
+    void BuildPointLocator();
+    void BuildCellLocator();
+    double GetMeanEdgeLength();
+};
+
+#endif //SV4GUI_PURKINJENETWORK_COUPLING_H
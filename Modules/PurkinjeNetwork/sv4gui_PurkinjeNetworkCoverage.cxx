@@ -0,0 +1,314 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sv4gui_PurkinjeNetworkCoverage.h"
+
+#include <mitkLogMacros.h>
+
+#include <vtkDoubleArray.h>
+#include <vtkIdList.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+#include <vtkXMLPolyDataWriter.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <sstream>
+
+sv4guiPurkinjeNetworkCoverage::sv4guiPurkinjeNetworkCoverage(vtkPolyData* surface) : m_Surface(surface)
+{
+  BuildTriangles();
+}
+
+sv4guiPurkinjeNetworkCoverage::~sv4guiPurkinjeNetworkCoverage()
+{
+}
+
+//----------------
+// BuildTriangles
+//----------------
+// Extract the surface triangles and compute the area represented 
+// by each vertex.
+//
+// Cells that are not triangles are ignored.
+
+void sv4guiPurkinjeNetworkCoverage::BuildTriangles()
+{
+  if (m_Surface == nullptr) {
+    return;
+  }
+
+  vtkIdType numPoints = m_Surface->GetNumberOfPoints();
+  vtkIdType numCells = m_Surface->GetNumberOfCells();
+  m_Points.resize(numPoints);
+  for (vtkIdType i = 0; i < numPoints; i++) {
+    m_Surface->GetPoint(i, m_Points[i].data());
+  }
+
+  auto cellPoints = vtkSmartPointer<vtkIdList>::New();
+  m_Triangles.clear();
+  m_Triangles.reserve(numCells);
+  m_VertexAreas.assign(numPoints, 0.0);
+
+  for (vtkIdType i = 0; i < numCells; i++) {
+    if (m_Surface->GetCellType(i) != VTK_TRIANGLE) {
+      continue;
+    }
+    m_Surface->GetCellPoints(i, cellPoints);
+    std::array<vtkIdType,3> triangle = {{cellPoints->GetId(0), cellPoints->GetId(1), cellPoints->GetId(2)}};
+    m_Triangles.push_back(triangle);
+
+    const auto& a = m_Points[triangle[0]];
+    const auto& b = m_Points[triangle[1]];
+    const auto& c = m_Points[triangle[2]];
+    double u[3] = { b[0]-a[0], b[1]-a[1], b[2]-a[2] };
+    double v[3] = { c[0]-a[0], c[1]-a[1], c[2]-a[2] };
+    double n[3] = { u[1]*v[2]-u[2]*v[1], u[2]*v[0]-u[0]*v[2], u[0]*v[1]-u[1]*v[0] };
+    double area = 0.5 * std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+
+    for (auto vertex : triangle) {
+      m_VertexAreas[vertex] += area / 3.0;
+    }
+  }
+}
+
+//------------------
+// ComputeDistances
+//------------------
+// Compute the distance from each surface vertex to the nearest 
+// network segment.
+
+bool sv4guiPurkinjeNetworkCoverage::ComputeDistances(const sv4guiPurkinjeNetworkSegmentTree& segmentTree, 
+    std::vector<double>& distances) const
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkCoverage::ComputeDistances] ";
+
+  if (segmentTree.GetNumberOfSegments() == 0) {
+    MITK_ERROR << msgPrefix << "The network has no segments.";
+    return false;
+  }
+
+  auto startTime = std::chrono::steady_clock::now();
+  vtkIdType numPoints = m_Points.size();
+  distances.assign(numPoints, 0.0);
+
+  auto computeDistances = [&](vtkIdType begin, vtkIdType end) {
+    int segment;
+    double param;
+    for (vtkIdType i = begin; i < end; i++) {
+      segmentTree.FindClosestSegment(m_Points[i].data(), segment, param, distances[i]);
+    }
+  };
+  vtkSMPTools::For(0, numPoints, computeDistances);
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+  MITK_INFO << msgPrefix << "Number of vertices " << numPoints << "  time " << elapsed.count() << " s";
+  return true;
+}
+
+//-------------------
+// ComputeStatistics
+//-------------------
+// Compute area weighted coverage statistics and find the uncovered 
+// patches of the surface.
+//
+// Arguments:
+//   distances - The distance from each vertex to the network.
+//   coverageDistance - Vertices farther than this distance are uncovered.
+
+bool sv4guiPurkinjeNetworkCoverage::ComputeStatistics(const std::vector<double>& distances, 
+    double coverageDistance, Statistics& statistics) const
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkCoverage::ComputeStatistics] ";
+  vtkIdType numPoints = m_Points.size();
+  statistics = Statistics();
+
+  if (distances.size() != numPoints) {
+    MITK_ERROR << msgPrefix << "The number of distances does not equal the number of vertices.";
+    return false;
+  }
+
+  if (numPoints == 0) {
+    return true;
+  }
+
+  // Area weighted mean and percentiles.
+  //
+  std::vector<vtkIdType> order(numPoints);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&distances](vtkIdType i, vtkIdType j) { return distances[i] < distances[j]; });
+
+  for (vtkIdType i = 0; i < numPoints; i++) {
+    statistics.totalArea += m_VertexAreas[i];
+    statistics.meanDistance += m_VertexAreas[i] * distances[i];
+  }
+  if (statistics.totalArea > 0.0) {
+    statistics.meanDistance /= statistics.totalArea;
+  }
+  statistics.maxDistance = distances[order.back()];
+
+  double area = 0.0;
+  vtkIdType index = 0;
+  for (auto percent : { 50.0, 75.0, 90.0, 95.0, 99.0 }) {
+    while ((index < numPoints - 1) && (area + m_VertexAreas[order[index]] < percent / 100.0 * statistics.totalArea)) {
+      area += m_VertexAreas[order[index]];
+      index += 1;
+    }
+    statistics.percentiles.push_back(std::make_pair(percent, distances[order[index]]));
+  }
+
+  // Uncovered patches: union uncovered vertices sharing a triangle edge.
+  //
+  std::vector<vtkIdType> parent(numPoints);
+  std::iota(parent.begin(), parent.end(), 0);
+  auto findRoot = [&parent](vtkIdType i) {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  };
+
+  for (const auto& triangle : m_Triangles) {
+    for (int j = 0; j < 3; j++) {
+      auto v1 = triangle[j];
+      auto v2 = triangle[(j+1)%3];
+      if ((distances[v1] > coverageDistance) && (distances[v2] > coverageDistance)) {
+        auto r1 = findRoot(v1);
+        auto r2 = findRoot(v2);
+        if (r1 != r2) {
+          parent[std::max(r1,r2)] = std::min(r1,r2);
+        }
+      }
+    }
+  }
+
+  std::vector<double> patchAreas(numPoints, 0.0);
+  std::vector<int> patchVertices(numPoints, 0);
+  for (vtkIdType i = 0; i < numPoints; i++) {
+    if (distances[i] <= coverageDistance) {
+      continue;
+    }
+    auto root = findRoot(i);
+    statistics.uncoveredArea += m_VertexAreas[i];
+    if (patchVertices[root] == 0) {
+      statistics.numPatches += 1;
+    }
+    patchAreas[root] += m_VertexAreas[i];
+    patchVertices[root] += 1;
+  }
+
+  if (statistics.numPatches == 0) {
+    return true;
+  }
+
+  auto largest = std::max_element(patchAreas.begin(), patchAreas.end()) - patchAreas.begin();
+  statistics.largestPatchArea = patchAreas[largest];
+  statistics.largestPatchVertices = patchVertices[largest];
+
+  for (vtkIdType i = 0; i < numPoints; i++) {
+    if ((distances[i] > coverageDistance) && (findRoot(i) == largest)) {
+      for (int j = 0; j < 3; j++) {
+        statistics.largestPatchCenter[j] += m_Points[i][j] / patchVertices[largest];
+      }
+    }
+  }
+
+  return true;
+}
+
+//-----------
+// GetReport
+//-----------
+// Get a text report of coverage statistics.
+
+std::string sv4guiPurkinjeNetworkCoverage::GetReport(const Statistics& statistics, double coverageDistance) const
+{
+  std::stringstream report;
+  double uncoveredPercent = 0.0;
+  if (statistics.totalArea > 0.0) {
+    uncoveredPercent = 100.0 * statistics.uncoveredArea / statistics.totalArea;
+  }
+
+  report << "Coverage distance: " << coverageDistance << "\n";
+  report << "Mean distance: " << statistics.meanDistance << "\n";
+  report << "Max distance: " << statistics.maxDistance << "\n";
+  for (const auto& percentile : statistics.percentiles) {
+    report << "Distance percentile " << percentile.first << ": " << percentile.second << "\n";
+  }
+  report << "Uncovered area: " << statistics.uncoveredArea << " (" << uncoveredPercent << "%)\n";
+  report << "Number of uncovered patches: " << statistics.numPatches << "\n";
+
+  if (statistics.numPatches != 0) {
+    const auto& center = statistics.largestPatchCenter;
+    report << "Largest uncovered patch area: " << statistics.largestPatchArea << "\n";
+    report << "Largest uncovered patch vertices: " << statistics.largestPatchVertices << "\n";
+    report << "Largest uncovered patch center: " << center[0] << " " << center[1] << " " << center[2] << "\n";
+  }
+
+  return report.str();
+}
+
+//-------
+// Write
+//-------
+// Write the surface with distances to the network as point data 
+// named 'NetworkDistance' to a VTK .vtp file.
+
+bool sv4guiPurkinjeNetworkCoverage::Write(const std::string& fileName, const std::vector<double>& distances)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkCoverage::Write] ";
+  MITK_INFO << msgPrefix << "File name " << fileName;
+
+  if (distances.size() != m_Points.size()) {
+    MITK_ERROR << msgPrefix << "The number of distances does not equal the number of vertices.";
+    return false;
+  }
+
+  auto array = vtkSmartPointer<vtkDoubleArray>::New();
+  array->SetName("NetworkDistance");
+  array->SetNumberOfValues(distances.size());
+  for (vtkIdType i = 0; i < distances.size(); i++) {
+    array->SetValue(i, distances[i]);
+  }
+
+  auto surface = vtkSmartPointer<vtkPolyData>::New();
+  surface->ShallowCopy(m_Surface);
+  surface->GetPointData()->AddArray(array);
+  surface->GetPointData()->SetActiveScalars("NetworkDistance");
+
+  auto writer = vtkSmartPointer<vtkXMLPolyDataWriter>::New();
+  writer->SetFileName(fileName.c_str());
+  writer->SetInputData(surface);
+  return writer->Write() == 1;
+}
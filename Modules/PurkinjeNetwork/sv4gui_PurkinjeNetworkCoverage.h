@@ -0,0 +1,95 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// This class is used to measure how well a Purkinje network covers the 
+// surface it was grown on.
+//
+// The distance from each surface vertex to the nearest network segment is 
+// computed in parallel using a segment tree (sv4guiPurkinjeNetworkSegmentTree). 
+// Vertices farther than a given distance from the network are uncovered. 
+//
+// Coverage statistics are area weighted: each vertex represents a third of 
+// the area of its triangles. Uncovered patches are connected sets of uncovered 
+// vertices.
+
+#ifndef SV4GUI_PURKINJENETWORK_COVERAGE_H
+#define SV4GUI_PURKINJENETWORK_COVERAGE_H
+
+#include "sv4guiModulePurkinjeNetworkExports.h"
+#include "sv4gui_PurkinjeNetworkSegmentTree.h"
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <array>
+#include <string>
+#include <utility>
+#include <vector>
+
+class SV4GUIMODULEPURKINJENETWORK_EXPORT sv4guiPurkinjeNetworkCoverage
+{
+  public:
+
+    struct Statistics {
+      double totalArea = 0.0;
+      double meanDistance = 0.0;
+      double maxDistance = 0.0;
+      std::vector<std::pair<double,double>> percentiles;
+      double uncoveredArea = 0.0;
+      int numPatches = 0;
+      double largestPatchArea = 0.0;
+      int largestPatchVertices = 0;
+      std::array<double,3> largestPatchCenter = {{0.0, 0.0, 0.0}};
+    };
+
+    sv4guiPurkinjeNetworkCoverage(vtkPolyData* surface);
+    ~sv4guiPurkinjeNetworkCoverage();
+
+    bool ComputeDistances(const sv4guiPurkinjeNetworkSegmentTree& segmentTree, std::vector<double>& distances) const;
+    bool ComputeStatistics(const std::vector<double>& distances, double coverageDistance, Statistics& statistics) const;
+    std::string GetReport(const Statistics& statistics, double coverageDistance) const;
+
+    bool Write(const std::string& fileName, const std::vector<double>& distances);
+
+    vtkIdType GetNumberOfVertices() const { return m_Points.size(); }
+
+  private:
+
+    vtkSmartPointer<vtkPolyData> m_Surface;
+
+    std::vector<std::array<double,3>> m_Points;
+    std::vector<std::array<vtkIdType,3>> m_Triangles;
+    std::vector<double> m_VertexAreas;
+
+    void BuildTriangles();
+};
+
+#endif //SV4GUI_PURKINJENETWORK_COVERAGE_H
@@ -0,0 +1,893 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sv4gui_PurkinjeNetworkGraph.h"
+
+#include <mitkLogMacros.h>
+
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkDoubleArray.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnstructuredGrid.h>
+#include <vtkIdList.h>
+#include <vtkIntArray.h>
+#include <vtkXMLUnstructuredGridReader.h>
+#include <vtkXMLUnstructuredGridWriter.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <set>
+#include <sstream>
+
+namespace {
+
+//-----------------
+// ComputeIndexMap
+//-----------------
+// Compute the indices of the elements of an array after removing the 
+// elements 'removed' and appending 'numAdded' elements.
+//
+// Elements are numbered as if the added elements were appended to the 
+// array, map[i] is the new index of element i or -1 if it is removed. 
+// Removed elements are replaced by added elements and then by elements 
+// moved from the end of the array. 
+//
+// 'ids' returns the indices whose values change and sources[i] the element 
+// stored at ids[i] after the change, -1 if ids[i] is past the new size.
+
+void ComputeIndexMap(int oldSize, const std::vector<int>& removed, int numAdded, std::vector<int>& map, 
+    std::vector<int>& ids, std::vector<int>& sources)
+{
+  int newSize = oldSize - removed.size() + numAdded;
+  map.resize(oldSize + numAdded);
+  std::iota(map.begin(), map.begin() + oldSize, 0);
+  ids.clear();
+  sources.clear();
+
+  std::vector<int> holes(removed);
+  std::sort(holes.begin(), holes.end());
+  for (auto id : holes) {
+    map[id] = -1;
+  }
+  int numHoles = std::lower_bound(holes.begin(), holes.end(), newSize) - holes.begin();
+  for (int i = numHoles; i < holes.size(); i++) {
+    ids.push_back(holes[i]);
+    sources.push_back(-1);
+  }
+
+  int hole = 0;
+  for (int j = 0; j < numAdded; j++) {
+    int id = (hole < numHoles) ? holes[hole++] : oldSize + j - holes.size();
+    map[oldSize + j] = id;
+    ids.push_back(id);
+    sources.push_back(oldSize + j);
+  }
+
+  for (int id = newSize; (id < oldSize) && (hole < numHoles); id++) {
+    if (map[id] == -1) {
+      continue;
+    }
+    map[id] = holes[hole];
+    ids.push_back(holes[hole++]);
+    sources.push_back(id);
+    ids.push_back(id);
+    sources.push_back(-1);
+  }
+}
+
+//-----------
+// SetValues
+//-----------
+// Set the values of an array at 'ids' and resize it to 'size'.
+
+template <class T>
+void SetValues(std::vector<T>& values, const std::vector<int>& ids, const std::vector<T>& newValues, int size)
+{
+  values.resize(std::max(static_cast<int>(values.size()), size));
+  for (int i = 0; i < ids.size(); i++) {
+    if (ids[i] < size) {
+      values[ids[i]] = newValues[i];
+    }
+  }
+  values.resize(size);
+}
+
+};
+
+//-------------
+// Constructor
+//-------------
+sv4guiPurkinjeNetworkGraph::sv4guiPurkinjeNetworkGraph() : m_RootNode(0)
+{
+}
+
+//------------
+// Destructor
+//------------
+sv4guiPurkinjeNetworkGraph::~sv4guiPurkinjeNetworkGraph()
+{
+}
+
+//------
+// Read
+//------
+// Read a network from the text files written by the fractal tree code.
+//
+// The files are named using 'filePrefix' (e.g. PROJECT/Purkinje-Network/FACENAME)
+//
+//   filePrefix_xyz.txt - node coordinates, one node per line.
+//   filePrefix_ien.txt - segment connectivity, two node indices per line.
+//   filePrefix_endnodes.txt - end node indices, one per line.
+//
+// The root node is set to node 0.
+
+bool sv4guiPurkinjeNetworkGraph::Read(const std::string& filePrefix)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkGraph::Read] ";
+  MITK_INFO << msgPrefix << "File prefix " << filePrefix;
+
+  std::ifstream nodeFile(filePrefix + "_xyz.txt");
+  if (!nodeFile.is_open()) {
+    MITK_ERROR << msgPrefix << "Can't open file " << filePrefix + "_xyz.txt";
+    return false;
+  }
+  std::ifstream segFile(filePrefix + "_ien.txt");
+  if (!segFile.is_open()) {
+    MITK_ERROR << msgPrefix << "Can't open file " << filePrefix + "_ien.txt";
+    return false;
+  }
+
+  m_Nodes.clear();
+  m_Segments.clear();
+  m_EndNodes.clear();
+  m_PointData.clear();
+  m_CellData.clear();
+  m_RootNode = 0;
+  ClearAdjacency();
+
+  Point point;
+  while (nodeFile >> point[0] >> point[1] >> point[2]) {
+    m_Nodes.push_back(point);
+  }
+
+  Segment segment;
+  int numNodes = m_Nodes.size();
+  while (segFile >> segment[0] >> segment[1]) {
+    if ((segment[0] < 0) || (segment[0] >= numNodes) || (segment[1] < 0) || (segment[1] >= numNodes)) { 
+      MITK_ERROR << msgPrefix << "Segment " << m_Segments.size() << " references an unknown node.";
+      return false;
+    }
+    m_Segments.push_back(segment);
+  }
+
+  // The end nodes file is empty if all branches are still growing.
+  std::ifstream endFile(filePrefix + "_endnodes.txt");
+  int node;
+  while (endFile >> node) {
+    if ((node < 0) || (node >= numNodes)) {
+      MITK_ERROR << msgPrefix << "End node " << node << " is not a network node.";
+      return false;
+    }
+    m_EndNodes.push_back(node);
+  }
+
+  MITK_INFO << msgPrefix << "Number of nodes " << m_Nodes.size();
+  MITK_INFO << msgPrefix << "Number of segments " << m_Segments.size();
+  MITK_INFO << msgPrefix << "Number of end nodes " << m_EndNodes.size();
+  return true;
+}
+
+//-------
+// Write
+//-------
+// Write a network using the same file names and formats as the 
+// fractal tree code.
+
+bool sv4guiPurkinjeNetworkGraph::Write(const std::string& filePrefix) const
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkGraph::Write] ";
+  MITK_INFO << msgPrefix << "File prefix " << filePrefix;
+
+  std::ofstream nodeFile(filePrefix + "_xyz.txt");
+  std::ofstream segFile(filePrefix + "_ien.txt");
+  std::ofstream endFile(filePrefix + "_endnodes.txt");
+
+  if (!nodeFile.is_open() || !segFile.is_open() || !endFile.is_open()) {
+    MITK_ERROR << msgPrefix << "Can't open files for writing.";
+    return false;
+  }
+
+  nodeFile.precision(17);
+  for (const auto& point : m_Nodes) {
+    nodeFile << point[0] << " " << point[1] << " " << point[2] << "\n";
+  }
+
+  for (const auto& segment : m_Segments) {
+    segFile << segment[0] << " " << segment[1] << "\n";
+  }
+
+  for (auto node : m_EndNodes) {
+    endFile << node << "\n";
+  }
+
+  return true;
+}
+
+//----------
+// WriteVtu 
+//----------
+// Write the network to a VTK .vtu file as an unstructured mesh of line elements.
+//
+// Point and cell data arrays set with SetPointData() and SetCellData() are
+// written with the mesh.
+
+bool sv4guiPurkinjeNetworkGraph::WriteVtu(const std::string& fileName) const
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkGraph::WriteVtu] ";
+  MITK_INFO << msgPrefix << "File name " << fileName;
+
+  auto points = vtkSmartPointer<vtkPoints>::New();
+  points->SetNumberOfPoints(m_Nodes.size());
+  for (vtkIdType i = 0; i < m_Nodes.size(); i++) {
+    points->SetPoint(i, m_Nodes[i].data());
+  }
+
+  auto lines = vtkSmartPointer<vtkCellArray>::New();
+  lines->Allocate(3*m_Segments.size());
+  for (const auto& segment : m_Segments) {
+    vtkIdType ids[2] = { segment[0], segment[1] };
+    lines->InsertNextCell(2, ids);
+  }
+
+  auto mesh = vtkSmartPointer<vtkUnstructuredGrid>::New();
+  mesh->SetPoints(points);
+  mesh->SetCells(VTK_LINE, lines);
+
+  for (const auto& data : m_PointData) {
+    auto array = vtkSmartPointer<vtkDoubleArray>::New();
+    array->SetName(data.first.c_str());
+    array->SetNumberOfValues(data.second.size());
+    for (vtkIdType i = 0; i < data.second.size(); i++) {
+      array->SetValue(i, data.second[i]);
+    }
+    mesh->GetPointData()->AddArray(array);
+  }
+
+  for (const auto& data : m_CellData) {
+    auto array = vtkSmartPointer<vtkDoubleArray>::New();
+    array->SetName(data.first.c_str());
+    array->SetNumberOfValues(data.second.size());
+    for (vtkIdType i = 0; i < data.second.size(); i++) {
+      array->SetValue(i, data.second[i]);
+    }
+    mesh->GetCellData()->AddArray(array);
+  }
+
+  auto writer = vtkSmartPointer<vtkXMLUnstructuredGridWriter>::New();
+  writer->SetFileName(fileName.c_str());
+  writer->SetInputData(mesh);
+  return writer->Write() == 1;
+}
+
+//---------
+// ReadVtu 
+//---------
+// Read a network from a VTK .vtu file of line elements.
+//
+// Polyline cells are split into segments. Single component point and 
+// cell data arrays are read as network data. There are no end nodes, 
+// the root node is set to node 0.
+
+bool sv4guiPurkinjeNetworkGraph::ReadVtu(const std::string& fileName)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkGraph::ReadVtu] ";
+  MITK_INFO << msgPrefix << "File name " << fileName;
+
+  std::ifstream file(fileName);
+  if (!file.is_open()) {
+    MITK_ERROR << msgPrefix << "Can't open file " << fileName;
+    return false;
+  }
+  file.close();
+
+  auto reader = vtkSmartPointer<vtkXMLUnstructuredGridReader>::New();
+  reader->SetFileName(fileName.c_str());
+  reader->Update();
+  vtkUnstructuredGrid* mesh = reader->GetOutput();
+
+  m_Nodes.clear();
+  m_Segments.clear();
+  m_EndNodes.clear();
+  m_PointData.clear();
+  m_CellData.clear();
+  m_RootNode = 0;
+  ClearAdjacency();
+
+  m_Nodes.resize(mesh->GetNumberOfPoints());
+  for (vtkIdType i = 0; i < mesh->GetNumberOfPoints(); i++) {
+    mesh->GetPoint(i, m_Nodes[i].data());
+  }
+
+  // Cell data is only kept if every cell is a single segment.
+  std::vector<vtkIdType> segmentCells;
+  auto cellPoints = vtkSmartPointer<vtkIdList>::New();
+  for (vtkIdType i = 0; i < mesh->GetNumberOfCells(); i++) {
+    mesh->GetCellPoints(i, cellPoints);
+    for (vtkIdType j = 0; j + 1 < cellPoints->GetNumberOfIds(); j++) {
+      m_Segments.push_back({ static_cast<int>(cellPoints->GetId(j)), static_cast<int>(cellPoints->GetId(j+1)) });
+      segmentCells.push_back(i);
+    }
+  }
+
+  auto pointData = mesh->GetPointData();
+  for (int i = 0; i < pointData->GetNumberOfArrays(); i++) {
+    auto array = pointData->GetArray(i);
+    if ((array == nullptr) || (array->GetNumberOfComponents() != 1) || (array->GetName() == nullptr)) {
+      continue;
+    }
+    std::vector<double> values(m_Nodes.size());
+    for (vtkIdType j = 0; j < values.size(); j++) {
+      values[j] = array->GetTuple1(j);
+    }
+    m_PointData[array->GetName()] = values;
+  }
+
+  auto cellData = mesh->GetCellData();
+  if (segmentCells.size() == mesh->GetNumberOfCells()) {
+    for (int i = 0; i < cellData->GetNumberOfArrays(); i++) {
+      auto array = cellData->GetArray(i);
+      if ((array == nullptr) || (array->GetNumberOfComponents() != 1) || (array->GetName() == nullptr)) {
+        continue;
+      }
+      std::vector<double> values(m_Segments.size());
+      for (vtkIdType j = 0; j < values.size(); j++) {
+        values[j] = array->GetTuple1(segmentCells[j]);
+      }
+      m_CellData[array->GetName()] = values;
+    }
+  }
+
+  MITK_INFO << msgPrefix << "Number of nodes " << m_Nodes.size();
+  MITK_INFO << msgPrefix << "Number of segments " << m_Segments.size();
+  return true;
+}
+
+//-------------------------------
+// Set nodes, segments and data
+//-------------------------------
+
+void sv4guiPurkinjeNetworkGraph::SetNodes(const std::vector<Point>& nodes)
+{
+  m_Nodes = nodes;
+  m_PointData.clear();
+  ClearAdjacency();
+}
+
+void sv4guiPurkinjeNetworkGraph::SetSegments(const std::vector<Segment>& segments)
+{
+  m_Segments = segments;
+  m_CellData.clear();
+  ClearAdjacency();
+}
+
+void sv4guiPurkinjeNetworkGraph::SetEndNodes(const std::vector<int>& endNodes)
+{
+  m_EndNodes = endNodes;
+  ClearAdjacency();
+}
+
+void sv4guiPurkinjeNetworkGraph::SetPointData(const std::string& name, const std::vector<double>& values)
+{
+  if (values.size() != m_Nodes.size()) {
+    MITK_WARN << "[sv4guiPurkinjeNetworkGraph::SetPointData] Array '" << name << "' size does not match the number of nodes.";
+    return;
+  }
+  m_PointData[name] = values;
+}
+
+void sv4guiPurkinjeNetworkGraph::SetCellData(const std::string& name, const std::vector<double>& values)
+{
+  if (values.size() != m_Segments.size()) {
+    MITK_WARN << "[sv4guiPurkinjeNetworkGraph::SetCellData] Array '" << name << "' size does not match the number of segments.";
+    return;
+  }
+  m_CellData[name] = values;
+}
+
+//----------------
+// BuildAdjacency
+//----------------
+// Build the node adjacency in compressed sparse row format.
+//
+// The nodes and segments adjacent to node i are stored in 
+//
+//   m_AdjacentNodes[m_AdjacencyOffsets[i] : m_AdjacencyOffsets[i+1]]
+//   m_AdjacentSegments[m_AdjacencyOffsets[i] : m_AdjacencyOffsets[i+1]]
+//
+// End nodes are also flagged here. The fractal tree code may record a junction 
+// node as an end node when a child branch fails to grow so end nodes are not 
+// always terminals.
+
+void sv4guiPurkinjeNetworkGraph::BuildAdjacency()
+{
+  int numNodes = m_Nodes.size();
+  m_EndNodeFlags.assign(numNodes, 0);
+  for (auto node : m_EndNodes) {
+    m_EndNodeFlags[node] = 1;
+  }
+
+  m_AdjacencyOffsets.assign(numNodes+1, 0);
+
+  for (const auto& segment : m_Segments) {
+    m_AdjacencyOffsets[segment[0]+1] += 1;
+    m_AdjacencyOffsets[segment[1]+1] += 1;
+  }
+
+  for (int i = 0; i < numNodes; i++) {
+    m_AdjacencyOffsets[i+1] += m_AdjacencyOffsets[i];
+  }
+
+  m_AdjacentNodes.resize(m_AdjacencyOffsets[numNodes]);
+  m_AdjacentSegments.resize(m_AdjacencyOffsets[numNodes]);
+  std::vector<int> fill(m_AdjacencyOffsets.begin(), m_AdjacencyOffsets.end()-1);
+
+  for (int i = 0; i < m_Segments.size(); i++) {
+    int n0 = m_Segments[i][0];
+    int n1 = m_Segments[i][1];
+    m_AdjacentNodes[fill[n0]] = n1;
+    m_AdjacentSegments[fill[n0]++] = i;
+    m_AdjacentNodes[fill[n1]] = n0;
+    m_AdjacentSegments[fill[n1]++] = i;
+  }
+}
+
+void sv4guiPurkinjeNetworkGraph::ClearAdjacency()
+{
+  m_AdjacencyOffsets.clear();
+  m_AdjacentNodes.clear();
+  m_AdjacentSegments.clear();
+  m_EndNodeFlags.clear();
+}
+
+//-----------------
+// ExtractBranches
+//-----------------
+// Split the network into branches running between junction, terminal 
+// and root nodes. 
+//
+// The adjacency must have been built using BuildAdjacency().
+
+void sv4guiPurkinjeNetworkGraph::ExtractBranches(std::vector<Branch>& branches) const
+{
+  branches.clear();
+  int numNodes = m_Nodes.size();
+  std::vector<bool> visited(m_Segments.size(), false);
+  int numVisited = 0;
+
+  for (int node = 0; node < numNodes; node++) {
+    if (!IsBranchEndNode(node)) {
+      continue;
+    }
+
+    for (int k = m_AdjacencyOffsets[node]; k < m_AdjacencyOffsets[node+1]; k++) {
+      int segment = m_AdjacentSegments[k];
+      if (visited[segment]) {
+        continue;
+      }
+
+      Branch branch;
+      branch.nodes.push_back(node);
+      int next = m_AdjacentNodes[k];
+
+      while (true) {
+        visited[segment] = true;
+        numVisited += 1;
+        branch.segments.push_back(segment);
+        branch.nodes.push_back(next);
+
+        if (IsBranchEndNode(next)) {
+          break;
+        }
+
+        // Continue through the other segment of the degree two node.
+        int j = m_AdjacencyOffsets[next];
+        if (m_AdjacentSegments[j] == segment) {
+          j += 1;
+        }
+        segment = m_AdjacentSegments[j];
+        next = m_AdjacentNodes[j];
+        if (visited[segment]) {
+          break;
+        }
+      }
+
+      branches.push_back(branch);
+    }
+  }
+
+  if (numVisited != m_Segments.size()) {
+    MITK_WARN << "[sv4guiPurkinjeNetworkGraph::ExtractBranches] " << m_Segments.size() - numVisited 
+              << " segments are in closed loops and are not part of any branch.";
+  }
+}
+
+//----------------------
+// GetBranchGenerations
+//----------------------
+// Compute the generation of each branch, the number of junctions between
+// the branch and the root node. 
+//
+// Branches are visited breadth first from the branches starting at the 
+// root node, which have generation 0. Branches not connected to the root 
+// node are given generation 0.
+
+void sv4guiPurkinjeNetworkGraph::GetBranchGenerations(const std::vector<Branch>& branches, 
+    std::vector<int>& generations) const
+{
+  int numNodes = m_Nodes.size();
+  int numBranches = branches.size();
+  generations.assign(numBranches, -1);
+
+  // Branches incident on each branch end node in CSR format.
+  std::vector<int> offsets(numNodes+1, 0);
+  for (const auto& branch : branches) {
+    offsets[branch.nodes.front()+1] += 1;
+    offsets[branch.nodes.back()+1] += 1;
+  }
+  for (int i = 0; i < numNodes; i++) {
+    offsets[i+1] += offsets[i];
+  }
+  std::vector<int> nodeBranches(offsets[numNodes]);
+  std::vector<int> fill(offsets.begin(), offsets.end()-1);
+  for (int i = 0; i < numBranches; i++) {
+    nodeBranches[fill[branches[i].nodes.front()]++] = i;
+    nodeBranches[fill[branches[i].nodes.back()]++] = i;
+  }
+
+  std::vector<int> queue;
+  if ((m_RootNode >= 0) && (m_RootNode < numNodes)) {
+    for (int k = offsets[m_RootNode]; k < offsets[m_RootNode+1]; k++) {
+      generations[nodeBranches[k]] = 0;
+      queue.push_back(nodeBranches[k]);
+    }
+  }
+
+  for (int q = 0; q < queue.size(); q++) {
+    int branch = queue[q];
+    for (int node : { branches[branch].nodes.front(), branches[branch].nodes.back() }) {
+      for (int k = offsets[node]; k < offsets[node+1]; k++) {
+        int next = nodeBranches[k];
+        if (generations[next] == -1) {
+          generations[next] = generations[branch] + 1;
+          queue.push_back(next);
+        }
+      }
+    }
+  }
+
+  for (auto& generation : generations) {
+    if (generation == -1) {
+      generation = 0;
+    }
+  }
+}
+
+//----------------------
+// CreateBranchPolyData
+//----------------------
+// Create vtkPolyData with one polyline cell per branch.
+//
+// Branch polylines share the network nodes as points so point data arrays 
+// are copied directly. The generation of each branch is stored in the 
+// 'BranchGeneration' cell data array. Segments in closed loops are not part of any branch 
+// and are not included. The adjacency must have been built using 
+// BuildAdjacency().
+
+vtkSmartPointer<vtkPolyData> sv4guiPurkinjeNetworkGraph::CreateBranchPolyData() const
+{
+  std::vector<Branch> branches;
+  ExtractBranches(branches);
+  std::vector<int> generations;
+  GetBranchGenerations(branches, generations);
+  return CreateBranchPolyData(branches, generations);
+}
+
+// Create the polydata for branches and generations already computed by 
+// ExtractBranches() and GetBranchGenerations(). Cell i is branches[i].
+
+vtkSmartPointer<vtkPolyData> sv4guiPurkinjeNetworkGraph::CreateBranchPolyData(const std::vector<Branch>& branches,
+    const std::vector<int>& generations) const
+{
+  auto points = vtkSmartPointer<vtkPoints>::New();
+  points->SetNumberOfPoints(m_Nodes.size());
+  for (vtkIdType i = 0; i < m_Nodes.size(); i++) {
+    points->SetPoint(i, m_Nodes[i].data());
+  }
+
+  auto lines = vtkSmartPointer<vtkCellArray>::New();
+  lines->Allocate(m_Segments.size() + 2*branches.size());
+  auto ids = vtkSmartPointer<vtkIdList>::New();
+  for (const auto& branch : branches) {
+    ids->SetNumberOfIds(branch.nodes.size());
+    for (vtkIdType i = 0; i < branch.nodes.size(); i++) {
+      ids->SetId(i, branch.nodes[i]);
+    }
+    lines->InsertNextCell(ids);
+  }
+
+  auto polyData = vtkSmartPointer<vtkPolyData>::New();
+  polyData->SetPoints(points);
+  polyData->SetLines(lines);
+
+  auto generationArray = vtkSmartPointer<vtkIntArray>::New();
+  generationArray->SetName("BranchGeneration");
+  generationArray->SetNumberOfValues(branches.size());
+  for (vtkIdType i = 0; i < branches.size(); i++) {
+    generationArray->SetValue(i, generations[i]);
+  }
+  polyData->GetCellData()->AddArray(generationArray);
+
+  for (const auto& data : m_PointData) {
+    auto array = vtkSmartPointer<vtkDoubleArray>::New();
+    array->SetName(data.first.c_str());
+    array->SetNumberOfValues(data.second.size());
+    for (vtkIdType i = 0; i < data.second.size(); i++) {
+      array->SetValue(i, data.second[i]);
+    }
+    polyData->GetPointData()->AddArray(array);
+  }
+
+  MITK_INFO << "[sv4guiPurkinjeNetworkGraph::CreateBranchPolyData] Number of branches " << branches.size();
+  return polyData;
+}
+
+//------------------
+// GetSegmentLength
+//------------------
+
+double sv4guiPurkinjeNetworkGraph::GetSegmentLength(int segment) const
+{
+  const auto& p0 = m_Nodes[m_Segments[segment][0]];
+  const auto& p1 = m_Nodes[m_Segments[segment][1]];
+  double dx = p1[0] - p0[0];
+  double dy = p1[1] - p0[1];
+  double dz = p1[2] - p0[2];
+  return sqrt(dx*dx + dy*dy + dz*dz);
+}
+
+//------------
+// GetSubtree
+//------------
+// Get the nodes reached from 'node' without passing through 'parentNode' 
+// and the segments incident on them. 
+//
+// Returns false if the subtree contains the root node, which happens when 
+// 'parentNode' is below 'node' or the nodes are in a closed loop. The 
+// adjacency must have been built using BuildAdjacency().
+
+bool sv4guiPurkinjeNetworkGraph::GetSubtree(int node, int parentNode, std::vector<int>& nodes, 
+    std::vector<int>& segments) const
+{
+  nodes.clear();
+  segments.clear();
+  std::vector<char> visited(m_Nodes.size(), 0);
+  std::vector<char> segmentVisited(m_Segments.size(), 0);
+  visited[node] = 1;
+  visited[parentNode] = 1;
+  nodes.push_back(node);
+
+  for (int q = 0; q < nodes.size(); q++) {
+    int n = nodes[q];
+    if (n == m_RootNode) {
+      return false;
+    }
+    for (int k = m_AdjacencyOffsets[n]; k < m_AdjacencyOffsets[n+1]; k++) {
+      int segment = m_AdjacentSegments[k];
+      if (!segmentVisited[segment]) {
+        segmentVisited[segment] = 1;
+        segments.push_back(segment);
+      }
+      int next = m_AdjacentNodes[k];
+      if (!visited[next]) {
+        visited[next] = 1;
+        nodes.push_back(next);
+      }
+    }
+  }
+
+  return true;
+}
+
+//---------------------
+// CreateReplaceChange
+//---------------------
+// Create the change removing nodes and segments and adding new ones.
+//
+// Added segments and end nodes index the added nodes as if they were 
+// appended to the nodes, added node i is node GetNumberOfNodes()+i. Point 
+// and cell data values of added nodes and segments are set to 0. 
+//
+// Only the removed and added nodes and segments, the nodes and segments 
+// moved into the holes left by removed ones and the segments of moved 
+// nodes are stored in the change. The adjacency must have been built 
+// using BuildAdjacency().
+
+void sv4guiPurkinjeNetworkGraph::CreateReplaceChange(const std::vector<int>& removedNodes, 
+    const std::vector<int>& removedSegments, const std::vector<Point>& addedNodes, 
+    const std::vector<Segment>& addedSegments, const std::vector<int>& addedEndNodes, Change& change) const
+{
+  int oldNumNodes = m_Nodes.size();
+  int oldNumSegments = m_Segments.size();
+  change = Change();
+  change.numNodes[0] = oldNumNodes;
+  change.numNodes[1] = oldNumNodes - removedNodes.size() + addedNodes.size();
+  change.numSegments[0] = oldNumSegments;
+  change.numSegments[1] = oldNumSegments - removedSegments.size() + addedSegments.size();
+
+  // Nodes.
+  std::vector<int> nodeMap, nodeSources;
+  ComputeIndexMap(oldNumNodes, removedNodes, addedNodes.size(), nodeMap, change.nodeIds, nodeSources);
+
+  for (int i = 0; i < change.nodeIds.size(); i++) {
+    int id = change.nodeIds[i];
+    int source = nodeSources[i];
+    change.nodes[0].push_back((id < oldNumNodes) ? m_Nodes[id] : Point());
+    change.nodes[1].push_back((source == -1) ? Point() : 
+        (source < oldNumNodes) ? m_Nodes[source] : addedNodes[source - oldNumNodes]);
+  }
+
+  for (const auto& data : m_PointData) {
+    auto& oldValues = change.pointData[0][data.first];
+    auto& newValues = change.pointData[1][data.first];
+    for (int i = 0; i < change.nodeIds.size(); i++) {
+      int id = change.nodeIds[i];
+      int source = nodeSources[i];
+      oldValues.push_back((id < oldNumNodes) ? data.second[id] : 0.0);
+      newValues.push_back(((source != -1) && (source < oldNumNodes)) ? data.second[source] : 0.0);
+    }
+  }
+
+  // Segments, the segments of moved nodes are also changed.
+  std::vector<int> segmentMap, segmentSources;
+  ComputeIndexMap(oldNumSegments, removedSegments, addedSegments.size(), segmentMap, change.segmentIds, 
+      segmentSources);
+
+  std::set<int> movedNodeSegments;
+  for (int node = 0; node < oldNumNodes; node++) {
+    if ((nodeMap[node] == node) || (nodeMap[node] == -1)) {
+      continue;
+    }
+    for (int k = m_AdjacencyOffsets[node]; k < m_AdjacencyOffsets[node+1]; k++) {
+      int segment = m_AdjacentSegments[k];
+      if (segmentMap[segment] == segment) {
+        movedNodeSegments.insert(segment);
+      }
+    }
+  }
+  for (auto segment : movedNodeSegments) {
+    change.segmentIds.push_back(segment);
+    segmentSources.push_back(segment);
+  }
+
+  for (int i = 0; i < change.segmentIds.size(); i++) {
+    int id = change.segmentIds[i];
+    int source = segmentSources[i];
+    change.segments[0].push_back((id < oldNumSegments) ? m_Segments[id] : Segment());
+    Segment segment = {{0, 0}};
+    if (source != -1) {
+      segment = (source < oldNumSegments) ? m_Segments[source] : addedSegments[source - oldNumSegments];
+      segment = {{ nodeMap[segment[0]], nodeMap[segment[1]] }};
+    }
+    change.segments[1].push_back(segment);
+  }
+
+  for (const auto& data : m_CellData) {
+    auto& oldValues = change.cellData[0][data.first];
+    auto& newValues = change.cellData[1][data.first];
+    for (int i = 0; i < change.segmentIds.size(); i++) {
+      int id = change.segmentIds[i];
+      int source = segmentSources[i];
+      oldValues.push_back((id < oldNumSegments) ? data.second[id] : 0.0);
+      newValues.push_back(((source != -1) && (source < oldNumSegments)) ? data.second[source] : 0.0);
+    }
+  }
+
+  // End nodes.
+  for (auto node : m_EndNodes) {
+    if (nodeMap[node] != node) {
+      change.endNodes[0].push_back(node);
+      if (nodeMap[node] != -1) {
+        change.endNodes[1].push_back(nodeMap[node]);
+      }
+    }
+  }
+  for (auto node : addedEndNodes) {
+    if ((node >= oldNumNodes) || !m_EndNodeFlags[node]) {
+      change.endNodes[1].push_back(nodeMap[node]);
+    }
+  }
+}
+
+//----------------------
+// CreateMoveNodeChange
+//----------------------
+// Create the change moving a node to 'point'. Only the position of the 
+// node is stored, segments and data values are not changed.
+
+void sv4guiPurkinjeNetworkGraph::CreateMoveNodeChange(int node, const Point& point, Change& change) const
+{
+  change = Change();
+  for (int i = 0; i < 2; i++) {
+    change.numNodes[i] = m_Nodes.size();
+    change.numSegments[i] = m_Segments.size();
+  }
+  change.nodeIds.push_back(node);
+  change.nodes[0].push_back(m_Nodes[node]);
+  change.nodes[1].push_back(point);
+}
+
+//-------------
+// ApplyChange
+//-------------
+// Apply or undo a change. The adjacency is rebuilt if it was built.
+
+void sv4guiPurkinjeNetworkGraph::ApplyChange(const Change& change, bool undo)
+{
+  int from = undo ? 1 : 0;
+  int to = undo ? 0 : 1;
+  bool haveAdjacency = HaveAdjacency();
+
+  SetValues(m_Nodes, change.nodeIds, change.nodes[to], change.numNodes[to]);
+  SetValues(m_Segments, change.segmentIds, change.segments[to], change.numSegments[to]);
+
+  for (const auto& data : change.pointData[to]) {
+    SetValues(m_PointData[data.first], change.nodeIds, data.second, change.numNodes[to]);
+  }
+  for (const auto& data : change.cellData[to]) {
+    SetValues(m_CellData[data.first], change.segmentIds, data.second, change.numSegments[to]);
+  }
+
+  std::vector<int> removedEndNodes(change.endNodes[from]);
+  std::sort(removedEndNodes.begin(), removedEndNodes.end());
+  m_EndNodes.erase(std::remove_if(m_EndNodes.begin(), m_EndNodes.end(), [&removedEndNodes](int node) 
+      { return std::binary_search(removedEndNodes.begin(), removedEndNodes.end(), node); }), m_EndNodes.end());
+  m_EndNodes.insert(m_EndNodes.end(), change.endNodes[to].begin(), change.endNodes[to].end());
+
+  ClearAdjacency();
+  if (haveAdjacency) {
+    BuildAdjacency();
+  }
+}
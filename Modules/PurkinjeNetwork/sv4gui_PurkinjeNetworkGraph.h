@@ -0,0 +1,167 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// This class is used to represent the 1D element network generated by the 
+// fractal tree code.
+//
+// The network is stored as 
+//   1) Node coordinates (FACENAME_xyz.txt) 
+//   2) Segment connectivity (FACENAME_ien.txt) 
+//   3) End node indices (FACENAME_endnodes.txt)
+//
+// The root node is the initial node of the network, node 0 in the files 
+// written by the fractal tree code.
+//
+// Node adjacency is stored in compressed sparse row (CSR) format, built on 
+// demand by BuildAdjacency(). 
+//
+// For rendering, the network is converted to vtkPolyData with one polyline
+// per branch by CreateBranchPolyData().
+//
+// Local edits (e.g. replacing a subtree) are stored as a Change holding the 
+// values of the nodes and segments it modifies before and after the edit. 
+// Removed nodes and segments are replaced by added ones or by nodes and 
+// segments moved from the end of the arrays, so the indices of the rest of 
+// the network do not change. A change can be applied and undone.
+
+#ifndef SV4GUI_PURKINJENETWORK_GRAPH_H
+#define SV4GUI_PURKINJENETWORK_GRAPH_H
+
+#include "sv4guiModulePurkinjeNetworkExports.h"
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <array>
+#include <map>
+#include <string>
+#include <vector>
+
+class SV4GUIMODULEPURKINJENETWORK_EXPORT sv4guiPurkinjeNetworkGraph
+{
+  public:
+
+    typedef std::array<double,3> Point;
+    typedef std::array<int,2> Segment;
+
+    // A branch is a chain of segments between two nodes that are 
+    // junctions, terminals, end nodes or the root node. 
+    struct Branch {
+      std::vector<int> nodes;
+      std::vector<int> segments;
+    };
+
+    // The nodes, segments and data values modified by an edit. Index 0 
+    // stores the values before the edit and index 1 the values after it. 
+    // Values are only stored for indices less than the number of nodes or 
+    // segments of that state. End nodes store the end node indices that 
+    // are removed (0) and added (1) by the edit.
+    struct Change {
+      int numNodes[2] = {0, 0};
+      int numSegments[2] = {0, 0};
+      std::vector<int> nodeIds;
+      std::vector<Point> nodes[2];
+      std::vector<int> segmentIds;
+      std::vector<Segment> segments[2];
+      std::vector<int> endNodes[2];
+      std::map<std::string, std::vector<double>> pointData[2];
+      std::map<std::string, std::vector<double>> cellData[2];
+    };
+
+    sv4guiPurkinjeNetworkGraph();
+    ~sv4guiPurkinjeNetworkGraph();
+
+    bool Read(const std::string& filePrefix);
+    bool Write(const std::string& filePrefix) const;
+    bool WriteVtu(const std::string& fileName) const;
+    bool ReadVtu(const std::string& fileName);
+
+    void SetNodes(const std::vector<Point>& nodes);
+    void SetSegments(const std::vector<Segment>& segments);
+    void SetEndNodes(const std::vector<int>& endNodes);
+
+    const std::vector<Point>& GetNodes() const { return m_Nodes; }
+    const std::vector<Segment>& GetSegments() const { return m_Segments; }
+    const std::vector<int>& GetEndNodes() const { return m_EndNodes; }
+
+    void SetRootNode(int node) { m_RootNode = node; }
+    int GetRootNode() const { return m_RootNode; }
+
+    int GetNumberOfNodes() const { return m_Nodes.size(); }
+    int GetNumberOfSegments() const { return m_Segments.size(); }
+
+    void SetPointData(const std::string& name, const std::vector<double>& values);
+    void SetCellData(const std::string& name, const std::vector<double>& values);
+    const std::map<std::string, std::vector<double>>& GetPointData() const { return m_PointData; }
+    const std::map<std::string, std::vector<double>>& GetCellData() const { return m_CellData; }
+
+    void BuildAdjacency();
+    bool HaveAdjacency() const { return m_AdjacencyOffsets.size() == m_Nodes.size() + 1; }
+    int GetDegree(int node) const { return m_AdjacencyOffsets[node+1] - m_AdjacencyOffsets[node]; }
+    const std::vector<int>& GetAdjacencyOffsets() const { return m_AdjacencyOffsets; }
+    const std::vector<int>& GetAdjacentNodes() const { return m_AdjacentNodes; }
+    const std::vector<int>& GetAdjacentSegments() const { return m_AdjacentSegments; }
+
+    bool IsBranchEndNode(int node) const { return (node == m_RootNode) || (GetDegree(node) != 2) || m_EndNodeFlags[node]; }
+    void ExtractBranches(std::vector<Branch>& branches) const;
+    void GetBranchGenerations(const std::vector<Branch>& branches, std::vector<int>& generations) const;
+    vtkSmartPointer<vtkPolyData> CreateBranchPolyData() const;
+    vtkSmartPointer<vtkPolyData> CreateBranchPolyData(const std::vector<Branch>& branches, 
+        const std::vector<int>& generations) const;
+
+    double GetSegmentLength(int segment) const;
+
+    bool GetSubtree(int node, int parentNode, std::vector<int>& nodes, std::vector<int>& segments) const;
+    void CreateReplaceChange(const std::vector<int>& removedNodes, const std::vector<int>& removedSegments,
+        const std::vector<Point>& addedNodes, const std::vector<Segment>& addedSegments, 
+        const std::vector<int>& addedEndNodes, Change& change) const;
+    void CreateMoveNodeChange(int node, const Point& point, Change& change) const;
+    void ApplyChange(const Change& change, bool undo=false);
+
+  private:
+
+    std::vector<Point> m_Nodes;
+    std::vector<Segment> m_Segments;
+    std::vector<int> m_EndNodes;
+    int m_RootNode;
+
+    std::map<std::string, std::vector<double>> m_PointData;
+    std::map<std::string, std::vector<double>> m_CellData;
+
+    std::vector<int> m_AdjacencyOffsets;
+    std::vector<int> m_AdjacentNodes;
+    std::vector<int> m_AdjacentSegments;
+    std::vector<char> m_EndNodeFlags;
+
+    void ClearAdjacency();
+};
+
+#endif //SV4GUI_PURKINJENETWORK_GRAPH_H
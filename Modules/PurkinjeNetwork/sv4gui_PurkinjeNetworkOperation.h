@@ -0,0 +1,95 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// This class is used to define operations editing a Purkinje network that 
+// can be undone using the MITK undo controller.
+//
+// A network edit is stored as a sv4guiPurkinjeNetworkGraph::Change holding 
+// only the nodes, segments and data values modified by the edit. The do and 
+// undo operations of an edit share the same change, applied forward by 
+// OpAPPLYCHANGE and backward by OpUNDOCHANGE, so an undo step costs memory 
+// proportional to the size of the edit rather than the size of the network.
+//
+// A change can only be applied to the network it was created for. The 
+// operation stores the ID of that network, operations for a network that 
+// has since been replaced are ignored.
+//
+// A parameter edit stores the values of the edited parameters before and 
+// after the edit. OpSETPROPS sets the new values and OpUNDOPROPS restores 
+// the old ones.
+
+#ifndef SV4GUI_PURKINJENETWORK_OPERATION_H
+#define SV4GUI_PURKINJENETWORK_OPERATION_H
+
+#include "sv4guiModulePurkinjeNetworkExports.h"
+#include "sv4gui_PurkinjeNetworkGraph.h"
+
+#include "mitkOperation.h"
+
+#include <map>
+#include <memory>
+#include <string>
+
+class SV4GUIMODULEPURKINJENETWORK_EXPORT sv4guiPurkinjeNetworkOperation : public mitk::Operation
+{
+public:
+
+    enum NetworkOperationType {OpAPPLYCHANGE = 9161, OpUNDOCHANGE, OpSETPROPS, OpUNDOPROPS};
+
+    typedef std::shared_ptr<const sv4guiPurkinjeNetworkGraph::Change> ChangePointer;
+    typedef std::map<std::string,std::string> Props;
+
+    sv4guiPurkinjeNetworkOperation(mitk::OperationType operationType, ChangePointer change, unsigned long networkID);
+
+    sv4guiPurkinjeNetworkOperation(mitk::OperationType operationType, const Props& oldProps, const Props& newProps);
+
+    virtual ~sv4guiPurkinjeNetworkOperation();
+
+    const sv4guiPurkinjeNetworkGraph::Change* GetChange() const { return m_Change.get(); }
+
+    unsigned long GetNetworkID() const { return m_NetworkID; }
+
+    const Props& GetOldProps() const { return m_OldProps; }
+
+    const Props& GetNewProps() const { return m_NewProps; }
+
+  private:
+
+    ChangePointer m_Change;
+
+    unsigned long m_NetworkID;
+
+    Props m_OldProps;
+
+    Props m_NewProps;
+};
+
+#endif // SV4GUI_PURKINJENETWORK_OPERATION_H
@@ -0,0 +1,323 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sv4gui_PurkinjeNetworkPartition.h"
+
+#include <mitkLogMacros.h>
+
+#include <algorithm>
+#include <fstream>
+
+//---------
+// CutTree
+//---------
+// Cut the rooted network into parts using the given segment threshold.
+//
+// Nodes are processed in reverse breadth-first order so the children of a 
+// node are processed before it. The segments of the subtrees below the 
+// children of a node are accumulated, when the count reaches 'threshold' 
+// the segments connecting the node to those children are assigned a new 
+// part. A group of children is cut before reaching the threshold if the 
+// next child would overshoot it by more. At most 'maxCuts' parts are cut, 
+// the remaining segments are left for the last part.
+//
+// Output:
+//   cutParts - The part assigned to the segments at cuts, -1 otherwise.
+//   partSizes - The number of segments in each part.
+//
+// Returns the number of parts, the last part is empty if no segments remain.
+
+int sv4guiPurkinjeNetworkPartition::CutTree(const sv4guiPurkinjeNetworkGraph& network, const std::vector<int>& order, 
+    const std::vector<int>& childBegin, const std::vector<int>& childEnd, const std::vector<int>& parentSegments, 
+    int maxCuts, int threshold, std::vector<int>& cutParts, std::vector<int>& partSizes)
+{
+  int numNodes = order.size();
+  std::vector<int> subtreeSizes(numNodes, 0);
+  cutParts.assign(network.GetNumberOfSegments(), -1);
+  partSizes.clear();
+  int numCuts = 0;
+  int numCutSegments = 0;
+
+  auto cut = [&](int begin, int end, int size) {
+    for (int k = begin; k < end; k++) {
+      cutParts[parentSegments[order[k]]] = numCuts;
+    }
+    partSizes.push_back(size);
+    numCutSegments += size;
+    numCuts += 1;
+  };
+
+  for (int i = numNodes-1; i >= 0; i--) {
+    int node = order[i];
+    int size = 0;
+    int groupBegin = childBegin[node];
+
+    for (int j = childBegin[node]; j < childEnd[node]; j++) {
+      int childSize = subtreeSizes[order[j]] + 1;
+
+      // Cut the children accumulated so far if adding this child 
+      // would take the part further from the threshold.
+      if ((size > 0) && (size + childSize > threshold) && (size + childSize - threshold > threshold - size) && 
+          (numCuts < maxCuts)) {
+        cut(groupBegin, j, size);
+        groupBegin = j;
+        size = 0;
+      }
+
+      size += childSize;
+
+      if ((size >= threshold) && (numCuts < maxCuts)) {
+        cut(groupBegin, j+1, size);
+        groupBegin = j + 1;
+        size = 0;
+      }
+    }
+
+    subtreeSizes[node] = size;
+  }
+
+  int remainder = network.GetNumberOfSegments() - numCutSegments;
+  partSizes.push_back(remainder);
+  return (remainder > 0) ? partSizes.size() : partSizes.size() - 1;
+}
+
+//-----------
+// Partition
+//-----------
+// Partition the network into 'numParts' parts with balanced numbers of segments.
+//
+// The cut threshold is found by bisection as the smallest threshold for which 
+// no more than 'numParts' parts are created. 'numParts' is clamped to the 
+// number of segments and on return is the number of parts actually created,
+// which can be fewer than requested.
+//
+// Output:
+//   segmentParts - The part of each segment.
+//   nodeParts - The part owning each node. 
+
+bool sv4guiPurkinjeNetworkPartition::Partition(sv4guiPurkinjeNetworkGraph& network, int& numParts, 
+    std::vector<int>& segmentParts, std::vector<int>& nodeParts)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkPartition::Partition] ";
+  MITK_INFO << msgPrefix << "Number of parts " << numParts;
+
+  int numNodes = network.GetNumberOfNodes();
+  int numSegments = network.GetNumberOfSegments();
+
+  if ((numParts < 1) || (numSegments == 0)) {
+    MITK_ERROR << msgPrefix << "The number of parts must be at least 1 and the network must have segments.";
+    return false;
+  }
+
+  if (numParts > numSegments) {
+    MITK_WARN << msgPrefix << "The number of parts " << numParts << " is larger than the number of segments " << numSegments << ".";
+    numParts = numSegments;
+  }
+
+  if (!network.HaveAdjacency()) {
+    network.BuildAdjacency();
+  }
+
+  // Root the network at its root node using a breadth-first traversal. The children 
+  // of a node are contiguous in the traversal order. 
+  //
+  const auto& offsets = network.GetAdjacencyOffsets();
+  const auto& adjNodes = network.GetAdjacentNodes();
+  const auto& adjSegments = network.GetAdjacentSegments();
+  std::vector<int> order;
+  order.reserve(numNodes);
+  std::vector<int> parentSegments(numNodes, -1);
+  std::vector<int> childBegin(numNodes);
+  std::vector<int> childEnd(numNodes);
+  std::vector<char> visited(numNodes, 0);
+
+  for (int k = -1; k < numNodes; k++) {
+    int root = (k == -1) ? network.GetRootNode() : k;
+    if (visited[root]) {
+      continue;
+    }
+    order.push_back(root);
+    visited[root] = 1;
+
+    for (int i = order.size()-1; i < order.size(); i++) {
+      int node = order[i];
+      childBegin[node] = order.size();
+      for (int j = offsets[node]; j < offsets[node+1]; j++) {
+        int child = adjNodes[j];
+        if (!visited[child]) {
+          visited[child] = 1;
+          parentSegments[child] = adjSegments[j];
+          order.push_back(child);
+        } else if ((adjSegments[j] != parentSegments[node]) && (child != node)) {
+          MITK_WARN << msgPrefix << "The network contains a loop at node " << node << ".";
+        }
+      }
+      childEnd[node] = order.size();
+    }
+  }
+
+  // Find the cut threshold.
+  //
+  std::vector<int> cutParts;
+  std::vector<int> partSizes;
+  int lower = 1;
+  int upper = numSegments;
+
+  while (lower < upper) {
+    int threshold = (lower + upper) / 2;
+    int count = CutTree(network, order, childBegin, childEnd, parentSegments, numSegments, threshold, cutParts, partSizes);
+    if (count <= numParts) {
+      upper = threshold;
+    } else {
+      lower = threshold + 1;
+    }
+  }
+
+  int count = CutTree(network, order, childBegin, childEnd, parentSegments, numParts-1, lower, cutParts, partSizes);
+
+  // Assign the segments below a cut to the cut part. 
+  //
+  int lastPart = partSizes.size() - 1;
+  std::vector<int> nodeInheritedParts(numNodes, lastPart);
+  segmentParts.resize(numSegments);
+
+  for (auto node : order) {
+    int segment = parentSegments[node];
+    if (segment == -1) {
+      continue;
+    }
+    int parent = network.GetSegments()[segment][0] == node ? network.GetSegments()[segment][1] : network.GetSegments()[segment][0];
+    int part = (cutParts[segment] != -1) ? cutParts[segment] : nodeInheritedParts[parent];
+    segmentParts[segment] = part;
+    nodeInheritedParts[node] = part;
+  }
+
+  // A non-root node is owned by the part of the segment to its parent, 
+  // a root node by the part of its first segment.
+  //
+  nodeParts.resize(numNodes);
+  for (int node = 0; node < numNodes; node++) {
+    if (parentSegments[node] != -1) {
+      nodeParts[node] = segmentParts[parentSegments[node]];
+    } else if (offsets[node+1] > offsets[node]) {
+      nodeParts[node] = segmentParts[adjSegments[offsets[node]]];
+    } else {
+      nodeParts[node] = 0;
+    }
+  }
+
+  partSizes.resize(count);
+  int minSize = *std::min_element(partSizes.begin(), partSizes.end());
+  int maxSize = *std::max_element(partSizes.begin(), partSizes.end());
+  MITK_INFO << msgPrefix << "Cut threshold " << lower;
+  MITK_INFO << msgPrefix << "Segments per part: min " << minSize << "  max " << maxSize;
+
+  if (count < numParts) {
+    MITK_WARN << msgPrefix << "Only " << count << " parts could be created.";
+    numParts = count;
+  }
+
+  return true;
+}
+
+//----------
+// GetParts
+//----------
+// Get the owned nodes, segments and halo nodes of each part.
+
+void sv4guiPurkinjeNetworkPartition::GetParts(const sv4guiPurkinjeNetworkGraph& network, int numParts, 
+    const std::vector<int>& segmentParts, const std::vector<int>& nodeParts, std::vector<Part>& parts)
+{
+  parts.clear();
+  parts.resize(numParts);
+
+  for (int node = 0; node < nodeParts.size(); node++) {
+    parts[nodeParts[node]].nodes.push_back(node);
+  }
+
+  const auto& segments = network.GetSegments();
+  for (int i = 0; i < segments.size(); i++) {
+    int part = segmentParts[i];
+    parts[part].segments.push_back(i);
+    for (auto node : segments[i]) {
+      if (nodeParts[node] != part) {
+        parts[part].haloNodes.push_back(node);
+      }
+    }
+  }
+
+  int numHaloNodes = 0;
+  for (auto& part : parts) {
+    std::sort(part.haloNodes.begin(), part.haloNodes.end());
+    part.haloNodes.erase(std::unique(part.haloNodes.begin(), part.haloNodes.end()), part.haloNodes.end());
+    numHaloNodes += part.haloNodes.size();
+  }
+
+  MITK_INFO << "[sv4guiPurkinjeNetworkPartition::GetParts] Number of halo nodes " << numHaloNodes;
+}
+
+//------------
+// WriteParts
+//------------
+// Write the owned nodes, segments and halo nodes of each part to the 
+// files 'filePrefix'_partN_nodes.txt, 'filePrefix'_partN_segments.txt 
+// and 'filePrefix'_partN_halo.txt, one index per line.
+
+bool sv4guiPurkinjeNetworkPartition::WriteParts(const std::string& filePrefix, const std::vector<Part>& parts)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkPartition::WriteParts] ";
+
+  for (int i = 0; i < parts.size(); i++) {
+    auto partPrefix = filePrefix + "_part" + std::to_string(i);
+    std::ofstream nodeFile(partPrefix + "_nodes.txt");
+    std::ofstream segFile(partPrefix + "_segments.txt");
+    std::ofstream haloFile(partPrefix + "_halo.txt");
+
+    if (!nodeFile.is_open() || !segFile.is_open() || !haloFile.is_open()) {
+      MITK_ERROR << msgPrefix << "Can't open files for writing part " << i << ".";
+      return false;
+    }
+
+    for (auto node : parts[i].nodes) {
+      nodeFile << node << "\n";
+    }
+
+    for (auto segment : parts[i].segments) {
+      segFile << segment << "\n";
+    }
+
+    for (auto node : parts[i].haloNodes) {
+      haloFile << node << "\n";
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,79 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// This class is used to partition a Purkinje network for distributed 1D solvers.
+//
+// The network is a tree so it can be partitioned by cutting it at nodes: the 
+// network is rooted at its root node and traversed from the leaves to the root 
+// accumulating the number of segments in each subtree. When the accumulated 
+// number of segments reaches a threshold the subtrees are cut off as a part. 
+// The threshold is chosen to balance the number of segments per part.
+//
+// Each part is a connected subtree and parts only share the nodes they were 
+// cut at. Nodes are owned by a single part, a node used by the segments of a 
+// part but owned by another part is a halo node of that part.
+
+#ifndef SV4GUI_PURKINJENETWORK_PARTITION_H
+#define SV4GUI_PURKINJENETWORK_PARTITION_H
+
+#include "sv4guiModulePurkinjeNetworkExports.h"
+#include "sv4gui_PurkinjeNetworkGraph.h"
+
+#include <string>
+#include <vector>
+
+class SV4GUIMODULEPURKINJENETWORK_EXPORT sv4guiPurkinjeNetworkPartition
+{
+  public:
+
+    struct Part {
+      std::vector<int> nodes;
+      std::vector<int> segments;
+      std::vector<int> haloNodes;
+    };
+
+    static bool Partition(sv4guiPurkinjeNetworkGraph& network, int& numParts, 
+        std::vector<int>& segmentParts, std::vector<int>& nodeParts);
+
+    static void GetParts(const sv4guiPurkinjeNetworkGraph& network, int numParts, const std::vector<int>& segmentParts, 
+        const std::vector<int>& nodeParts, std::vector<Part>& parts);
+
+    static bool WriteParts(const std::string& filePrefix, const std::vector<Part>& parts);
+
+  private:
+
+    static int CutTree(const sv4guiPurkinjeNetworkGraph& network, const std::vector<int>& order, 
+        const std::vector<int>& childBegin, const std::vector<int>& childEnd, 
+        const std::vector<int>& parentSegments, int maxCuts, 
+        int threshold, std::vector<int>& cutParts, std::vector<int>& partSizes);
+};
+
+#endif //SV4GUI_PURKINJENETWORK_PARTITION_H
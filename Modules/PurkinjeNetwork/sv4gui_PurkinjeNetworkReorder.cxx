@@ -0,0 +1,316 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sv4gui_PurkinjeNetworkReorder.h"
+
+#include <mitkLogMacros.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+//-----------
+// GetMethod
+//-----------
+// Get the ordering method from its name: 'none', 'bfs' or 'rcm'.
+
+bool sv4guiPurkinjeNetworkReorder::GetMethod(const std::string& name, Method& method)
+{
+  if (name == "" || name == "none") {
+    method = Method::None;
+  } else if (name == "bfs") {
+    method = Method::BFS;
+  } else if (name == "rcm") {
+    method = Method::RCM;
+  } else {
+    MITK_ERROR << "[sv4guiPurkinjeNetworkReorder::GetMethod] Unknown node ordering '" << name << "'.";
+    return false;
+  }
+  return true;
+}
+
+//------------------
+// ComputeBandwidth
+//------------------
+// Compute the bandwidth of the network connectivity, the maximum 
+// difference between the indices of the two nodes of a segment.
+
+int sv4guiPurkinjeNetworkReorder::ComputeBandwidth(const sv4guiPurkinjeNetworkGraph& network)
+{
+  int bandwidth = 0;
+  for (const auto& segment : network.GetSegments()) {
+    bandwidth = std::max(bandwidth, std::abs(segment[1] - segment[0]));
+  }
+  return bandwidth;
+}
+
+//--------------------------
+// FindPseudoPeripheralNode
+//--------------------------
+// Find a node of near-maximal eccentricity in the connected component 
+// containing 'startNode'.
+//
+// This is the George-Liu algorithm: repeat a level-structure BFS from the 
+// minimum degree node of the last level until the number of levels stops 
+// increasing.
+//
+// 'levels' is work storage sized to the number of nodes and set to -1 
+// for nodes that have not been ordered.
+
+int sv4guiPurkinjeNetworkReorder::FindPseudoPeripheralNode(const sv4guiPurkinjeNetworkGraph& network, 
+    int startNode, std::vector<int>& levels)
+{
+  const auto& offsets = network.GetAdjacencyOffsets();
+  const auto& adjNodes = network.GetAdjacentNodes();
+  std::vector<int> queue;
+
+  int node = startNode;
+  int numLevels = -1;
+
+  while (true) {
+    queue.clear();
+    queue.push_back(node);
+    levels[node] = 0;
+    int maxLevel = 0;
+
+    for (int i = 0; i < queue.size(); i++) {
+      int n = queue[i];
+      maxLevel = levels[n];
+      for (int j = offsets[n]; j < offsets[n+1]; j++) {
+        int m = adjNodes[j];
+        if (levels[m] == -1) {
+          levels[m] = levels[n] + 1;
+          queue.push_back(m);
+        }
+      }
+    }
+
+    // Select the minimum degree node in the last level.
+    int nextNode = node;
+    int minDegree = -1;
+    for (auto n : queue) {
+      if ((levels[n] == maxLevel) && ((minDegree == -1) || (network.GetDegree(n) < minDegree))) {
+        minDegree = network.GetDegree(n);
+        nextNode = n;
+      }
+    }
+
+    for (auto n : queue) {
+      levels[n] = -1;
+    }
+
+    if (maxLevel <= numLevels) {
+      break;
+    }
+    numLevels = maxLevel;
+    node = nextNode;
+  }
+
+  return node;
+}
+
+//-----------------
+// ComputeOrdering
+//-----------------
+// Compute the new node numbering for the given method.
+//
+// nodeMap[i] is the new index of node i. The connected component containing 
+// the root node is ordered first starting from the root node, so the root 
+// node is node 0 and can be found when the network is read back. Other 
+// components follow.
+
+bool sv4guiPurkinjeNetworkReorder::ComputeOrdering(sv4guiPurkinjeNetworkGraph& network, Method method, 
+    std::vector<int>& nodeMap)
+{
+  int numNodes = network.GetNumberOfNodes();
+  nodeMap.resize(numNodes);
+
+  if (numNodes == 0) {
+    MITK_ERROR << "[sv4guiPurkinjeNetworkReorder::ComputeOrdering] The network has no nodes.";
+    return false;
+  }
+
+  if (method == Method::None) {
+    for (int i = 0; i < numNodes; i++) {
+      nodeMap[i] = i;
+    }
+    return true;
+  }
+
+  if (!network.HaveAdjacency()) {
+    network.BuildAdjacency();
+  }
+
+  const auto& offsets = network.GetAdjacencyOffsets();
+  const auto& adjNodes = network.GetAdjacentNodes();
+
+  std::vector<int> order;
+  order.reserve(numNodes);
+  std::vector<int> levels(numNodes, -1);
+  std::vector<char> visited(numNodes, 0);
+  std::vector<int> neighbors;
+
+  for (int k = -1; k < numNodes; k++) {
+    int root = (k == -1) ? network.GetRootNode() : k;
+    if (visited[root]) {
+      continue;
+    }
+
+    int startNode = root;
+    if ((method == Method::RCM) && (k != -1)) {
+      startNode = FindPseudoPeripheralNode(network, root, levels);
+    }
+
+    int first = order.size();
+    order.push_back(startNode);
+    visited[startNode] = 1;
+
+    for (int i = first; i < order.size(); i++) {
+      int n = order[i];
+      neighbors.clear();
+      for (int j = offsets[n]; j < offsets[n+1]; j++) {
+        int m = adjNodes[j];
+        if (!visited[m]) {
+          visited[m] = 1;
+          neighbors.push_back(m);
+        }
+      }
+
+      // Cuthill-McKee visits neighbors in increasing degree.
+      if (method == Method::RCM) {
+        std::stable_sort(neighbors.begin(), neighbors.end(), 
+          [&](int a, int b) { return network.GetDegree(a) < network.GetDegree(b); });
+      }
+
+      order.insert(order.end(), neighbors.begin(), neighbors.end());
+    }
+  }
+
+  for (int i = 0; i < numNodes; i++) {
+    nodeMap[order[i]] = i;
+  }
+
+  return true;
+}
+
+//---------
+// Reorder
+//---------
+// Renumber the nodes of 'network' and rewrite its segments, end nodes 
+// and point data. 
+//
+// If the new numbering would increase the bandwidth the nodes keep their 
+// numbering.
+
+bool sv4guiPurkinjeNetworkReorder::Reorder(sv4guiPurkinjeNetworkGraph& network, Method method, 
+    sv4guiPurkinjeNetworkGraph& reordered, std::vector<int>& nodeMap)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkReorder::Reorder] ";
+
+  if (network.GetNumberOfNodes() == 0) {
+    MITK_ERROR << msgPrefix << "The network has no nodes.";
+    return false;
+  }
+
+  if (!ComputeOrdering(network, method, nodeMap)) {
+    return false;
+  }
+
+  int bandwidth = ComputeBandwidth(network);
+  int newBandwidth = 0;
+  for (const auto& segment : network.GetSegments()) {
+    newBandwidth = std::max(newBandwidth, std::abs(nodeMap[segment[1]] - nodeMap[segment[0]]));
+  }
+
+  if (newBandwidth > bandwidth) {
+    MITK_WARN << msgPrefix << "The node ordering would increase the bandwidth from " << bandwidth << " to " 
+        << newBandwidth << ", the nodes are not renumbered.";
+    ComputeOrdering(network, Method::None, nodeMap);
+  }
+
+  const auto& nodes = network.GetNodes();
+  int numNodes = nodes.size();
+  std::vector<sv4guiPurkinjeNetworkGraph::Point> newNodes(numNodes);
+  for (int i = 0; i < numNodes; i++) {
+    newNodes[nodeMap[i]] = nodes[i];
+  }
+
+  std::vector<sv4guiPurkinjeNetworkGraph::Segment> newSegments;
+  newSegments.reserve(network.GetNumberOfSegments());
+  for (const auto& segment : network.GetSegments()) {
+    newSegments.push_back({ nodeMap[segment[0]], nodeMap[segment[1]] });
+  }
+
+  std::vector<int> newEndNodes;
+  for (auto node : network.GetEndNodes()) {
+    newEndNodes.push_back(nodeMap[node]);
+  }
+
+  reordered.SetNodes(newNodes);
+  reordered.SetSegments(newSegments);
+  reordered.SetEndNodes(newEndNodes);
+  reordered.SetRootNode(nodeMap[network.GetRootNode()]);
+
+  for (const auto& data : network.GetPointData()) {
+    std::vector<double> values(numNodes);
+    for (int i = 0; i < numNodes; i++) {
+      values[nodeMap[i]] = data.second[i];
+    }
+    reordered.SetPointData(data.first, values);
+  }
+
+  for (const auto& data : network.GetCellData()) {
+    reordered.SetCellData(data.first, data.second);
+  }
+
+  MITK_INFO << msgPrefix << "Bandwidth " << bandwidth << " -> " << ComputeBandwidth(reordered);
+  return true;
+}
+
+//--------------
+// WriteNodeMap
+//--------------
+// Write the new index of each original node, one per line.
+
+bool sv4guiPurkinjeNetworkReorder::WriteNodeMap(const std::string& filePrefix, const std::vector<int>& nodeMap)
+{
+  std::ofstream outFile(filePrefix + "_nodemap.txt");
+  if (!outFile.is_open()) {
+    MITK_ERROR << "[sv4guiPurkinjeNetworkReorder::WriteNodeMap] Can't open file " << filePrefix + "_nodemap.txt";
+    return false;
+  }
+
+  for (auto node : nodeMap) {
+    outFile << node << "\n";
+  }
+
+  return true;
+}
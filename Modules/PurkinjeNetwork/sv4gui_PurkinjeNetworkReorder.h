@@ -0,0 +1,85 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// This class is used to renumber the nodes of a Purkinje network to 
+// improve memory locality.
+//
+// Nodes generated by the fractal tree code are numbered in branch creation 
+// order so nodes connected by a segment can be far apart in memory. 
+//
+// Two orderings are supported
+//   1) BFS - Breadth-first search from the root node, the root node becomes node 0.
+//   2) RCM - Cuthill-McKee starting from the root node, neighbors are numbered 
+//      in increasing degree. 
+//
+// The root node is always node 0 because network files do not store the 
+// root node, readers take node 0 as the root. For this reason the RCM ordering 
+// is not reversed: the reversal would move the root node to the end, and 
+// moving it back to 0 would make the bandwidth of its segments the size of 
+// the network. On a tree the reversal does not reduce the bandwidth. Other 
+// connected components start from a pseudo-peripheral node.
+//
+// An ordering that would increase the bandwidth is not applied.
+//
+// Only nodes are renumbered, segments keep their original order so cell data 
+// remains valid.
+
+#ifndef SV4GUI_PURKINJENETWORK_REORDER_H
+#define SV4GUI_PURKINJENETWORK_REORDER_H
+
+#include "sv4guiModulePurkinjeNetworkExports.h"
+#include "sv4gui_PurkinjeNetworkGraph.h"
+
+#include <string>
+#include <vector>
+
+class SV4GUIMODULEPURKINJENETWORK_EXPORT sv4guiPurkinjeNetworkReorder
+{
+  public:
+
+    enum class Method { None, BFS, RCM };
+
+    static bool GetMethod(const std::string& name, Method& method);
+
+    static bool ComputeOrdering(sv4guiPurkinjeNetworkGraph& network, Method method, std::vector<int>& nodeMap);
+    static bool Reorder(sv4guiPurkinjeNetworkGraph& network, Method method, 
+        sv4guiPurkinjeNetworkGraph& reordered, std::vector<int>& nodeMap);
+
+    static int ComputeBandwidth(const sv4guiPurkinjeNetworkGraph& network);
+    static bool WriteNodeMap(const std::string& filePrefix, const std::vector<int>& nodeMap);
+
+  private:
+
+    static int FindPseudoPeripheralNode(const sv4guiPurkinjeNetworkGraph& network, int startNode, 
+        std::vector<int>& levels);
+};
+
+#endif //SV4GUI_PURKINJENETWORK_REORDER_H
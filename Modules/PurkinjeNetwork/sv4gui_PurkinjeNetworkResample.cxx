@@ -0,0 +1,246 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sv4gui_PurkinjeNetworkResample.h"
+
+#include <mitkLogMacros.h>
+
+#include <vtkSMPTools.h>
+
+#include <cmath>
+#include <fstream>
+
+//----------
+// Resample
+//----------
+// Resample 'network' to the target element size 'elementSize'.
+//
+// Each branch of length L is split into max(1, round(L/elementSize)) segments 
+// of equal arc length. New nodes are placed by linear interpolation along the 
+// original branch polyline. Point data such as activation times are copied 
+// to the preserved nodes and interpolated the same way to the new nodes.
+//
+// Output:
+//   resampled - The resampled network. Junction, terminal, end and root nodes are 
+//     numbered first in their original order. 
+//   parentSegments - For each resampled segment the index of the original segment 
+//     containing its midpoint. 
+
+bool sv4guiPurkinjeNetworkResample::Resample(sv4guiPurkinjeNetworkGraph& network, double elementSize,
+    sv4guiPurkinjeNetworkGraph& resampled, std::vector<int>& parentSegments)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkResample::Resample] ";
+  MITK_INFO << msgPrefix << "Element size " << elementSize;
+
+  if (network.GetNumberOfNodes() == 0) {
+    MITK_ERROR << msgPrefix << "The network has no nodes.";
+    return false;
+  }
+
+  if (elementSize <= 0.0) {
+    MITK_ERROR << msgPrefix << "The element size must be positive.";
+    return false;
+  }
+
+  if (!network.HaveAdjacency()) {
+    network.BuildAdjacency();
+  }
+
+  std::vector<sv4guiPurkinjeNetworkGraph::Branch> branches;
+  network.ExtractBranches(branches);
+  int numBranches = branches.size();
+  MITK_INFO << msgPrefix << "Number of branches " << numBranches;
+
+  // Number the nodes at the ends of branches. 
+  //
+  const auto& nodes = network.GetNodes();
+  int numNodes = nodes.size();
+  std::vector<int> nodeMap(numNodes, -1);
+  int numEndNodes = 0;
+  for (int i = 0; i < numNodes; i++) {
+    if (network.IsBranchEndNode(i)) {
+      nodeMap[i] = numEndNodes++;
+    }
+  }
+
+  // Compute the number of resampled segments for each branch.
+  //
+  std::vector<double> branchLengths(numBranches);
+  std::vector<int> branchNumSegments(numBranches);
+
+  auto countSegments = [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType b = begin; b < end; b++) {
+      double length = 0.0;
+      for (auto segment : branches[b].segments) {
+        length += network.GetSegmentLength(segment);
+      }
+      branchLengths[b] = length;
+      int numSegs = static_cast<int>(std::round(length / elementSize));
+      branchNumSegments[b] = std::max(1, numSegs);
+    }
+  };
+  vtkSMPTools::For(0, numBranches, countSegments);
+
+  // Compute offsets into the new node and segment arrays. A branch
+  // with n segments adds n-1 interior nodes.
+  //
+  std::vector<int> nodeOffsets(numBranches+1);
+  std::vector<int> segOffsets(numBranches+1);
+  nodeOffsets[0] = numEndNodes;
+  segOffsets[0] = 0;
+  for (int b = 0; b < numBranches; b++) {
+    nodeOffsets[b+1] = nodeOffsets[b] + branchNumSegments[b] - 1;
+    segOffsets[b+1] = segOffsets[b] + branchNumSegments[b];
+  }
+
+  std::vector<sv4guiPurkinjeNetworkGraph::Point> newNodes(nodeOffsets[numBranches]);
+  std::vector<sv4guiPurkinjeNetworkGraph::Segment> newSegments(segOffsets[numBranches]);
+  parentSegments.resize(segOffsets[numBranches]);
+
+  const auto& pointData = network.GetPointData();
+  std::vector<const std::vector<double>*> values;
+  std::vector<std::vector<double>> newValues(pointData.size(), std::vector<double>(newNodes.size()));
+  for (const auto& data : pointData) {
+    values.push_back(&data.second);
+  }
+
+  for (int i = 0; i < numNodes; i++) {
+    if (nodeMap[i] != -1) {
+      newNodes[nodeMap[i]] = nodes[i];
+      for (int n = 0; n < values.size(); n++) {
+        newValues[n][nodeMap[i]] = (*values[n])[i];
+      }
+    }
+  }
+
+  // Redistribute the nodes of each branch.
+  //
+  auto resampleBranches = [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType b = begin; b < end; b++) {
+      const auto& branch = branches[b];
+      int numSegs = branchNumSegments[b];
+      double ds = branchLengths[b] / numSegs;
+
+      // Walk along the original polyline, 'k' is the current original 
+      // segment and 'sk' the arc length at its start.
+      int k = 0;
+      double sk = 0.0;
+      double lk = network.GetSegmentLength(branch.segments[0]);
+
+      auto locate = [&](double s) {
+        while ((s > sk + lk) && (k < branch.segments.size()-1)) {
+          sk += lk;
+          k += 1;
+          lk = network.GetSegmentLength(branch.segments[k]);
+        }
+      };
+
+      int prevNode = nodeMap[branch.nodes.front()];
+
+      for (int j = 0; j < numSegs; j++) {
+        // Parent segment contains the new segment midpoint.
+        locate((j + 0.5) * ds);
+        parentSegments[segOffsets[b]+j] = branch.segments[k];
+
+        int nextNode;
+        if (j == numSegs-1) {
+          nextNode = nodeMap[branch.nodes.back()];
+        } else {
+          double s = (j + 1) * ds;
+          locate(s);
+          double t = (lk > 0.0) ? (s - sk) / lk : 0.0;
+          t = std::min(1.0, std::max(0.0, t));
+          const auto& p0 = nodes[branch.nodes[k]];
+          const auto& p1 = nodes[branch.nodes[k+1]];
+          nextNode = nodeOffsets[b] + j;
+          for (int i = 0; i < 3; i++) {
+            newNodes[nextNode][i] = p0[i] + t * (p1[i] - p0[i]);
+          }
+          for (int n = 0; n < values.size(); n++) {
+            double v0 = (*values[n])[branch.nodes[k]];
+            double v1 = (*values[n])[branch.nodes[k+1]];
+            newValues[n][nextNode] = v0 + t * (v1 - v0);
+          }
+        }
+
+        newSegments[segOffsets[b]+j] = { prevNode, nextNode };
+        prevNode = nextNode;
+      }
+    }
+  };
+  vtkSMPTools::For(0, numBranches, resampleBranches);
+
+  // Map end nodes, these are always branch end nodes.
+  //
+  std::vector<int> newEndNodes;
+  for (auto node : network.GetEndNodes()) {
+    newEndNodes.push_back(nodeMap[node]);
+  }
+
+  resampled.SetNodes(newNodes);
+  resampled.SetSegments(newSegments);
+  resampled.SetEndNodes(newEndNodes);
+  resampled.SetRootNode(nodeMap[network.GetRootNode()]);
+
+  int n = 0;
+  for (const auto& data : pointData) {
+    resampled.SetPointData(data.first, newValues[n++]);
+  }
+
+  std::vector<double> parents(parentSegments.begin(), parentSegments.end());
+  resampled.SetCellData("ParentSegment", parents);
+
+  MITK_INFO << msgPrefix << "Number of nodes " << numNodes << " -> " << newNodes.size();
+  MITK_INFO << msgPrefix << "Number of segments " << network.GetNumberOfSegments() << " -> " << newSegments.size();
+  return true;
+}
+
+//---------------------
+// WriteParentSegments
+//---------------------
+// Write the map from resampled segments to the original segments, 
+// one original segment index per line.
+
+bool sv4guiPurkinjeNetworkResample::WriteParentSegments(const std::string& filePrefix, 
+    const std::vector<int>& parentSegments)
+{
+  std::ofstream outFile(filePrefix + "_parentseg.txt");
+  if (!outFile.is_open()) {
+    MITK_ERROR << "[sv4guiPurkinjeNetworkResample::WriteParentSegments] Can't open file " << filePrefix + "_parentseg.txt";
+    return false;
+  }
+
+  for (auto segment : parentSegments) {
+    outFile << segment << "\n";
+  }
+
+  return true;
+}
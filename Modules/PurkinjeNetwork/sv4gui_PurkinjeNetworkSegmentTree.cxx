@@ -0,0 +1,465 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sv4gui_PurkinjeNetworkSegmentTree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+sv4guiPurkinjeNetworkSegmentTree::sv4guiPurkinjeNetworkSegmentTree()
+{
+}
+
+sv4guiPurkinjeNetworkSegmentTree::~sv4guiPurkinjeNetworkSegmentTree()
+{
+}
+
+//-------
+// Build
+//-------
+// Build the tree for the segments of a network.
+//
+// Leaves hold at most 'leafSize' segments. Segment end points are stored 
+// in leaf order so the network is not needed for queries.
+
+void sv4guiPurkinjeNetworkSegmentTree::Build(const sv4guiPurkinjeNetworkGraph& network, int leafSize)
+{
+  const auto& nodes = network.GetNodes();
+  const auto& segments = network.GetSegments();
+  int numSegments = segments.size();
+
+  m_TreeNodes.clear();
+  m_SegmentIds.resize(numSegments);
+  m_SegmentPoints.resize(numSegments);
+
+  if (numSegments == 0) {
+    return;
+  }
+
+  std::vector<std::array<double,3>> centers(numSegments);
+  for (int i = 0; i < numSegments; i++) {
+    m_SegmentIds[i] = i;
+    const auto& p1 = nodes[segments[i][0]];
+    const auto& p2 = nodes[segments[i][1]];
+    for (int j = 0; j < 3; j++) {
+      m_SegmentPoints[i][j] = p1[j];
+      m_SegmentPoints[i][j+3] = p2[j];
+      centers[i][j] = 0.5 * (p1[j] + p2[j]);
+    }
+  }
+
+  m_TreeNodes.reserve(2 * numSegments / std::max(leafSize, 1) + 1);
+  BuildNode(0, numSegments, std::max(leafSize, 1), centers);
+
+  // Store segment end points in leaf order.
+  std::vector<std::array<double,6>> points(numSegments);
+  for (int i = 0; i < numSegments; i++) {
+    points[i] = m_SegmentPoints[m_SegmentIds[i]];
+  }
+  m_SegmentPoints.swap(points);
+}
+
+//-----------
+// BuildNode
+//-----------
+// Build the subtree for the segments m_SegmentIds[begin:end] and 
+// return the index of its root.
+
+int sv4guiPurkinjeNetworkSegmentTree::BuildNode(int begin, int end, int leafSize, 
+    const std::vector<std::array<double,3>>& centers)
+{
+  int index = m_TreeNodes.size();
+  m_TreeNodes.push_back(TreeNode());
+
+  double bounds[6] = { std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(),
+                       std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(),
+                       std::numeric_limits<double>::max(), -std::numeric_limits<double>::max() };
+  double centerBounds[6] = { bounds[0], bounds[1], bounds[2], bounds[3], bounds[4], bounds[5] };
+
+  for (int i = begin; i < end; i++) {
+    int segment = m_SegmentIds[i];
+    const auto& points = m_SegmentPoints[segment];
+    for (int j = 0; j < 3; j++) {
+      bounds[2*j] = std::min(bounds[2*j], std::min(points[j], points[j+3]));
+      bounds[2*j+1] = std::max(bounds[2*j+1], std::max(points[j], points[j+3]));
+      centerBounds[2*j] = std::min(centerBounds[2*j], centers[segment][j]);
+      centerBounds[2*j+1] = std::max(centerBounds[2*j+1], centers[segment][j]);
+    }
+  }
+  std::copy(bounds, bounds+6, m_TreeNodes[index].bounds);
+
+  if (end - begin <= leafSize) {
+    m_TreeNodes[index].first = begin;
+    m_TreeNodes[index].count = end - begin;
+    return index;
+  }
+
+  // Split at the median center along the longest axis.
+  int axis = 0;
+  for (int j = 1; j < 3; j++) {
+    if (centerBounds[2*j+1] - centerBounds[2*j] > centerBounds[2*axis+1] - centerBounds[2*axis]) {
+      axis = j;
+    }
+  }
+
+  int middle = (begin + end) / 2;
+  std::nth_element(m_SegmentIds.begin()+begin, m_SegmentIds.begin()+middle, m_SegmentIds.begin()+end,
+      [&centers, axis](int s1, int s2) { return centers[s1][axis] < centers[s2][axis]; });
+
+  BuildNode(begin, middle, leafSize, centers);
+  int second = BuildNode(middle, end, leafSize, centers);
+  m_TreeNodes[index].first = second;
+  m_TreeNodes[index].count = 0;
+  return index;
+}
+
+//--------------------
+// FindClosestSegment
+//--------------------
+// Find the segment closest to a point.
+//
+// Returns the segment index, the parametric coordinate of the closest 
+// point on the segment and the distance to it. Segments flagged in 
+// 'skipSegments' are ignored, used to query a network with a part of 
+// it removed without rebuilding the tree.
+
+bool sv4guiPurkinjeNetworkSegmentTree::FindClosestSegment(const double point[3], int& segment, double& param, 
+    double& distance, const std::vector<char>* skipSegments) const
+{
+  segment = -1;
+  param = 0.0;
+  distance = std::numeric_limits<double>::max();
+
+  if (m_TreeNodes.size() == 0) {
+    return false;
+  }
+
+  double minDist2 = std::numeric_limits<double>::max();
+  int stack[64];
+  int stackSize = 0;
+  stack[stackSize++] = 0;
+
+  while (stackSize > 0) {
+    const auto& node = m_TreeNodes[stack[--stackSize]];
+    if (BoxDistance2(node.bounds, point) >= minDist2) {
+      continue;
+    }
+
+    if (node.count > 0) {
+      for (int i = node.first; i < node.first + node.count; i++) {
+        if ((skipSegments != nullptr) && (*skipSegments)[m_SegmentIds[i]]) {
+          continue;
+        }
+        const auto& points = m_SegmentPoints[i];
+        double t;
+        double dist2 = SegmentDistance2(point, &points[0], &points[3], t);
+        if (dist2 < minDist2) {
+          minDist2 = dist2;
+          segment = m_SegmentIds[i];
+          param = t;
+        }
+      }
+      continue;
+    }
+
+    // Visit the nearer child first.
+    int first = &node - &m_TreeNodes[0] + 1;
+    int second = node.first;
+    double dist1 = BoxDistance2(m_TreeNodes[first].bounds, point);
+    double dist2 = BoxDistance2(m_TreeNodes[second].bounds, point);
+    if (dist1 < dist2) {
+      std::swap(first, second);
+    }
+    stack[stackSize++] = first;
+    stack[stackSize++] = second;
+  }
+
+  distance = std::sqrt(minDist2);
+  return segment != -1;
+}
+
+//-----------------------
+// FindSegmentsNearPlane
+//-----------------------
+// Find the segments with a point within 'distance' of a plane.
+//
+// The plane normal must have unit length. A box is skipped when the 
+// distance from the plane to its center is larger than the projection 
+// of its half-diagonal onto the normal plus 'distance'.
+
+void sv4guiPurkinjeNetworkSegmentTree::FindSegmentsNearPlane(const double origin[3], const double normal[3], 
+    double distance, std::vector<int>& segments) const
+{
+  segments.clear();
+
+  if (m_TreeNodes.size() == 0) {
+    return;
+  }
+
+  int stack[64];
+  int stackSize = 0;
+  stack[stackSize++] = 0;
+
+  while (stackSize > 0) {
+    int index = stack[--stackSize];
+    const auto& node = m_TreeNodes[index];
+
+    double centerDist = 0.0;
+    double radius = 0.0;
+    for (int j = 0; j < 3; j++) {
+      double center = 0.5 * (node.bounds[2*j] + node.bounds[2*j+1]);
+      centerDist += normal[j] * (center - origin[j]);
+      radius += 0.5 * std::fabs(normal[j]) * (node.bounds[2*j+1] - node.bounds[2*j]);
+    }
+    if (std::fabs(centerDist) > radius + distance) {
+      continue;
+    }
+
+    if (node.count > 0) {
+      for (int i = node.first; i < node.first + node.count; i++) {
+        const auto& points = m_SegmentPoints[i];
+        double dist1 = 0.0, dist2 = 0.0;
+        for (int j = 0; j < 3; j++) {
+          dist1 += normal[j] * (points[j] - origin[j]);
+          dist2 += normal[j] * (points[j+3] - origin[j]);
+        }
+        if ((std::min(dist1, dist2) <= distance) && (std::max(dist1, dist2) >= -distance)) {
+          segments.push_back(m_SegmentIds[i]);
+        }
+      }
+      continue;
+    }
+
+    stack[stackSize++] = index + 1;
+    stack[stackSize++] = node.first;
+  }
+}
+
+//--------------------------
+// FindFirstSegmentNearLine
+//--------------------------
+// Find the segment within 'tolerance' of the line segment [start,end] that 
+// is closest to 'start'.
+//
+// This is used to pick the segment under the cursor with the line from the 
+// near to the far clipping plane. Boxes grown by 'tolerance' are clipped to 
+// the line and are skipped when they start after the best segment found so far.
+//
+// Returns the segment index, the parametric coordinate of the point on the 
+// segment closest to the line and the distance between them.
+
+bool sv4guiPurkinjeNetworkSegmentTree::FindFirstSegmentNearLine(const double start[3], const double end[3], 
+    double tolerance, int& segment, double& param, double& distance) const
+{
+  segment = -1;
+  param = 0.0;
+  distance = std::numeric_limits<double>::max();
+
+  if (m_TreeNodes.size() == 0) {
+    return false;
+  }
+
+  double direction[3] = { end[0] - start[0], end[1] - start[1], end[2] - start[2] };
+  double tolerance2 = tolerance * tolerance;
+  double bestLineParam = std::numeric_limits<double>::max();
+
+  int stack[64];
+  int stackSize = 0;
+  stack[stackSize++] = 0;
+
+  while (stackSize > 0) {
+    int index = stack[--stackSize];
+    const auto& node = m_TreeNodes[index];
+    double tmin, tmax;
+    if (!ClipLineToBox(node.bounds, tolerance, start, direction, tmin, tmax) || (tmin > bestLineParam)) {
+      continue;
+    }
+
+    if (node.count > 0) {
+      for (int i = node.first; i < node.first + node.count; i++) {
+        const auto& points = m_SegmentPoints[i];
+        double lineParam, t;
+        double dist2 = SegmentSegmentDistance2(start, end, &points[0], &points[3], lineParam, t);
+        if ((dist2 <= tolerance2) && (lineParam < bestLineParam)) {
+          bestLineParam = lineParam;
+          segment = m_SegmentIds[i];
+          param = t;
+          distance = std::sqrt(dist2);
+        }
+      }
+      continue;
+    }
+
+    stack[stackSize++] = node.first;
+    stack[stackSize++] = index + 1;
+  }
+
+  return segment != -1;
+}
+
+//------------------
+// SegmentDistance2
+//------------------
+// Compute the squared distance from a point to the segment [a,b] and the 
+// parametric coordinate of the closest point.
+
+double sv4guiPurkinjeNetworkSegmentTree::SegmentDistance2(const double point[3], const double a[3], 
+    const double b[3], double& param)
+{
+  double ab[3], ap[3];
+  double abab = 0.0, apab = 0.0;
+  for (int j = 0; j < 3; j++) {
+    ab[j] = b[j] - a[j];
+    ap[j] = point[j] - a[j];
+    abab += ab[j] * ab[j];
+    apab += ap[j] * ab[j];
+  }
+
+  param = 0.0;
+  if (abab > 0.0) {
+    param = std::min(std::max(apab / abab, 0.0), 1.0);
+  }
+
+  double dist2 = 0.0;
+  for (int j = 0; j < 3; j++) {
+    double d = ap[j] - param * ab[j];
+    dist2 += d * d;
+  }
+  return dist2;
+}
+
+//-------------------------
+// SegmentSegmentDistance2
+//-------------------------
+// Compute the squared distance between the segments [a1,b1] and [a2,b2] and 
+// the parametric coordinates of their closest points.
+
+double sv4guiPurkinjeNetworkSegmentTree::SegmentSegmentDistance2(const double a1[3], const double b1[3], 
+    const double a2[3], const double b2[3], double& param1, double& param2)
+{
+  double d1[3], d2[3], r[3];
+  for (int j = 0; j < 3; j++) {
+    d1[j] = b1[j] - a1[j];
+    d2[j] = b2[j] - a2[j];
+    r[j] = a1[j] - a2[j];
+  }
+  double a = d1[0]*d1[0] + d1[1]*d1[1] + d1[2]*d1[2];
+  double e = d2[0]*d2[0] + d2[1]*d2[1] + d2[2]*d2[2];
+  double f = d2[0]*r[0] + d2[1]*r[1] + d2[2]*r[2];
+
+  if ((a == 0.0) && (e == 0.0)) {
+    param1 = param2 = 0.0;
+  } else if (a == 0.0) {
+    param1 = 0.0;
+    param2 = std::min(std::max(f / e, 0.0), 1.0);
+  } else {
+    double c = d1[0]*r[0] + d1[1]*r[1] + d1[2]*r[2];
+    if (e == 0.0) {
+      param2 = 0.0;
+      param1 = std::min(std::max(-c / a, 0.0), 1.0);
+    } else {
+      // Minimize over the first segment for the closest points of the 
+      // infinite lines, then clamp to the second segment and recompute.
+      double b = d1[0]*d2[0] + d1[1]*d2[1] + d1[2]*d2[2];
+      double denom = a*e - b*b;
+      param1 = 0.0;
+      if (denom != 0.0) {
+        param1 = std::min(std::max((b*f - c*e) / denom, 0.0), 1.0);
+      }
+      param2 = (b*param1 + f) / e;
+      if (param2 < 0.0) {
+        param2 = 0.0;
+        param1 = std::min(std::max(-c / a, 0.0), 1.0);
+      } else if (param2 > 1.0) {
+        param2 = 1.0;
+        param1 = std::min(std::max((b - c) / a, 0.0), 1.0);
+      }
+    }
+  }
+
+  double dist2 = 0.0;
+  for (int j = 0; j < 3; j++) {
+    double d = (a1[j] + param1*d1[j]) - (a2[j] + param2*d2[j]);
+    dist2 += d * d;
+  }
+  return dist2;
+}
+
+//--------------
+// BoxDistance2
+//--------------
+// Compute the squared distance from a point to a box, 0 if the point is inside.
+
+double sv4guiPurkinjeNetworkSegmentTree::BoxDistance2(const double bounds[6], const double point[3])
+{
+  double dist2 = 0.0;
+  for (int j = 0; j < 3; j++) {
+    double d = std::max(std::max(bounds[2*j] - point[j], point[j] - bounds[2*j+1]), 0.0);
+    dist2 += d * d;
+  }
+  return dist2;
+}
+
+//---------------
+// ClipLineToBox
+//---------------
+// Clip the line start + t*direction, 0 <= t <= 1, to a box grown by 'tolerance'.
+//
+// Returns false if the line misses the box.
+
+bool sv4guiPurkinjeNetworkSegmentTree::ClipLineToBox(const double bounds[6], double tolerance, 
+    const double start[3], const double direction[3], double& tmin, double& tmax)
+{
+  tmin = 0.0;
+  tmax = 1.0;
+  for (int j = 0; j < 3; j++) {
+    double lower = bounds[2*j] - tolerance;
+    double upper = bounds[2*j+1] + tolerance;
+    if (direction[j] == 0.0) {
+      if ((start[j] < lower) || (start[j] > upper)) {
+        return false;
+      }
+      continue;
+    }
+    double t1 = (lower - start[j]) / direction[j];
+    double t2 = (upper - start[j]) / direction[j];
+    if (t1 > t2) {
+      std::swap(t1, t2);
+    }
+    tmin = std::max(tmin, t1);
+    tmax = std::min(tmax, t2);
+    if (tmin > tmax) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,98 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// This class is used to find the network segments nearest to a point.
+//
+// Segments are stored in a bounding volume hierarchy (BVH): a binary tree 
+// of axis-aligned boxes built by splitting the segments at the median of 
+// their centers along the longest axis of the box. Nodes are stored in a 
+// flat array in depth-first order with the segments of each leaf stored 
+// contiguously so queries touch a small, compact part of memory.
+//
+// The tree is read-only once built so any number of threads can query it.
+//
+// The tree is also used to find the segments near a plane, used to display 
+// the network in slices, by skipping boxes that are far from the plane, and 
+// the segments near a line, used to pick segments under the cursor.
+
+#ifndef SV4GUI_PURKINJENETWORK_SEGMENT_TREE_H
+#define SV4GUI_PURKINJENETWORK_SEGMENT_TREE_H
+
+#include "sv4guiModulePurkinjeNetworkExports.h"
+#include "sv4gui_PurkinjeNetworkGraph.h"
+
+#include <array>
+#include <vector>
+
+class SV4GUIMODULEPURKINJENETWORK_EXPORT sv4guiPurkinjeNetworkSegmentTree
+{
+  public:
+
+    sv4guiPurkinjeNetworkSegmentTree();
+    ~sv4guiPurkinjeNetworkSegmentTree();
+
+    void Build(const sv4guiPurkinjeNetworkGraph& network, int leafSize=4);
+
+    bool FindClosestSegment(const double point[3], int& segment, double& param, double& distance, 
+        const std::vector<char>* skipSegments=nullptr) const;
+    void FindSegmentsNearPlane(const double origin[3], const double normal[3], double distance, 
+        std::vector<int>& segments) const;
+    bool FindFirstSegmentNearLine(const double start[3], const double end[3], double tolerance, 
+        int& segment, double& param, double& distance) const;
+
+    int GetNumberOfSegments() const { return m_SegmentIds.size(); }
+    int GetNumberOfTreeNodes() const { return m_TreeNodes.size(); }
+
+    static double SegmentDistance2(const double point[3], const double a[3], const double b[3], double& param);
+    static double SegmentSegmentDistance2(const double a1[3], const double b1[3], const double a2[3], 
+        const double b2[3], double& param1, double& param2);
+
+  private:
+
+    // A tree node stores its box and either its second child (the first 
+    // child follows it in the array) or the range of its leaf segments.
+    struct TreeNode {
+      double bounds[6];
+      int first;
+      int count;
+    };
+
+    std::vector<TreeNode> m_TreeNodes;
+    std::vector<int> m_SegmentIds;
+    std::vector<std::array<double,6>> m_SegmentPoints;
+
+    int BuildNode(int begin, int end, int leafSize, const std::vector<std::array<double,3>>& centers);
+    static double BoxDistance2(const double bounds[6], const double point[3]);
+    static bool ClipLineToBox(const double bounds[6], double tolerance, const double start[3], 
+        const double direction[3], double& tmin, double& tmax);
+};
+
+#endif //SV4GUI_PURKINJENETWORK_SEGMENT_TREE_H
@@ -0,0 +1,427 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sv4gui_PurkinjeNetworkSurfaceActivation.h"
+
+#include <mitkLogMacros.h>
+
+#include <vtkDoubleArray.h>
+#include <vtkIdList.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+#include <vtkXMLPolyDataWriter.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+sv4guiPurkinjeNetworkSurfaceActivation::sv4guiPurkinjeNetworkSurfaceActivation(vtkPolyData* surface) : 
+    m_Surface(surface), m_AverageEdgeLength(0.0)
+{
+  BuildAdjacency();
+}
+
+sv4guiPurkinjeNetworkSurfaceActivation::~sv4guiPurkinjeNetworkSurfaceActivation()
+{
+}
+
+//----------------
+// BuildAdjacency
+//----------------
+// Build the triangles incident to each vertex and the vertices 
+// sharing a triangle with each vertex.
+//
+// Cells that are not triangles are ignored.
+
+void sv4guiPurkinjeNetworkSurfaceActivation::BuildAdjacency()
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkSurfaceActivation::BuildAdjacency] ";
+
+  if (m_Surface == nullptr) {
+    return;
+  }
+
+  vtkIdType numPoints = m_Surface->GetNumberOfPoints();
+  vtkIdType numCells = m_Surface->GetNumberOfCells();
+  m_Points.resize(numPoints);
+  for (vtkIdType i = 0; i < numPoints; i++) {
+    m_Surface->GetPoint(i, m_Points[i].data());
+  }
+
+  auto cellPoints = vtkSmartPointer<vtkIdList>::New();
+  m_Triangles.clear();
+  m_Triangles.reserve(numCells);
+  for (vtkIdType i = 0; i < numCells; i++) {
+    if (m_Surface->GetCellType(i) != VTK_TRIANGLE) {
+      continue;
+    }
+    m_Surface->GetCellPoints(i, cellPoints);
+    m_Triangles.push_back({cellPoints->GetId(0), cellPoints->GetId(1), cellPoints->GetId(2)});
+  }
+  MITK_INFO << msgPrefix << "Number of vertices " << numPoints << "  triangles " << m_Triangles.size();
+
+  // Vertex triangles.
+  //
+  m_TriangleOffsets.assign(numPoints+1, 0);
+  for (const auto& triangle : m_Triangles) {
+    for (auto vertex : triangle) {
+      m_TriangleOffsets[vertex+1] += 1;
+    }
+  }
+  for (vtkIdType i = 0; i < numPoints; i++) {
+    m_TriangleOffsets[i+1] += m_TriangleOffsets[i];
+  }
+
+  m_VertexTriangles.resize(m_TriangleOffsets[numPoints]);
+  std::vector<vtkIdType> position(m_TriangleOffsets.begin(), m_TriangleOffsets.end()-1);
+  for (vtkIdType i = 0; i < m_Triangles.size(); i++) {
+    for (auto vertex : m_Triangles[i]) {
+      m_VertexTriangles[position[vertex]++] = i;
+    }
+  }
+
+  // Vertex neighbors, each vertex has at most two neighbors per triangle.
+  //
+  std::vector<vtkIdType> numNeighbors(numPoints);
+  std::vector<vtkIdType> neighbors(2*m_VertexTriangles.size());
+
+  auto findNeighbors = [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; i++) {
+      auto first = neighbors.begin() + 2*m_TriangleOffsets[i];
+      auto last = first;
+      for (vtkIdType j = m_TriangleOffsets[i]; j < m_TriangleOffsets[i+1]; j++) {
+        for (auto vertex : m_Triangles[m_VertexTriangles[j]]) {
+          if (vertex != i) {
+            *last++ = vertex;
+          }
+        }
+      }
+      std::sort(first, last);
+      numNeighbors[i] = std::unique(first, last) - first;
+    }
+  };
+  vtkSMPTools::For(0, numPoints, findNeighbors);
+
+  m_NeighborOffsets.assign(numPoints+1, 0);
+  for (vtkIdType i = 0; i < numPoints; i++) {
+    m_NeighborOffsets[i+1] = m_NeighborOffsets[i] + numNeighbors[i];
+  }
+
+  m_Neighbors.resize(m_NeighborOffsets[numPoints]);
+  double edgeLengthSum = 0.0;
+  for (vtkIdType i = 0; i < numPoints; i++) {
+    auto first = neighbors.begin() + 2*m_TriangleOffsets[i];
+    std::copy(first, first + numNeighbors[i], m_Neighbors.begin() + m_NeighborOffsets[i]);
+    for (vtkIdType j = 0; j < numNeighbors[i]; j++) {
+      const auto& p1 = m_Points[i];
+      const auto& p2 = m_Points[first[j]];
+      edgeLengthSum += std::sqrt((p2[0]-p1[0])*(p2[0]-p1[0]) + (p2[1]-p1[1])*(p2[1]-p1[1]) + 
+          (p2[2]-p1[2])*(p2[2]-p1[2]));
+    }
+  }
+
+  if (m_Neighbors.size() != 0) {
+    m_AverageEdgeLength = edgeLengthSum / m_Neighbors.size();
+  }
+}
+
+//------------------------
+// ComputeActivationTimes
+//------------------------
+// Compute the activation time of each surface vertex.
+//
+// Arguments:
+//   sourceVertices - The vertices where activation starts.
+//   sourceTimes - The activation time at each source vertex.
+//   velocity - The conduction velocity.
+//
+// Output:
+//   activationTimes - The activation time of each vertex, vertices that can't be 
+//     reached from a source are set to -1.
+
+bool sv4guiPurkinjeNetworkSurfaceActivation::ComputeActivationTimes(const std::vector<vtkIdType>& sourceVertices, 
+    const std::vector<double>& sourceTimes, double velocity, std::vector<double>& activationTimes)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkSurfaceActivation::ComputeActivationTimes] ";
+  MITK_INFO << msgPrefix << "Number of sources " << sourceVertices.size();
+
+  vtkIdType numPoints = m_Points.size();
+
+  if (sourceVertices.size() != sourceTimes.size()) {
+    MITK_ERROR << msgPrefix << "The number of source vertices and source times differ.";
+    return false;
+  }
+
+  if (velocity <= 0.0) {
+    MITK_ERROR << msgPrefix << "The velocity must be positive.";
+    return false;
+  }
+
+  for (auto vertex : sourceVertices) {
+    if ((vertex < 0) || (vertex >= numPoints)) {
+      MITK_ERROR << msgPrefix << "Source vertex " << vertex << " is out of range.";
+      return false;
+    }
+  }
+
+  auto startTime = std::chrono::steady_clock::now();
+  const double infinity = std::numeric_limits<double>::infinity();
+  const double tolerance = 1e-6 * m_AverageEdgeLength / velocity;
+  activationTimes.assign(numPoints, infinity);
+
+  for (int i = 0; i < sourceVertices.size(); i++) {
+    auto vertex = sourceVertices[i];
+    activationTimes[vertex] = std::min(activationTimes[vertex], sourceTimes[i]);
+  }
+
+  // The narrow band starts with the neighbors of the sources.
+  //
+  std::vector<char> inBand(numPoints, 0);
+  std::vector<vtkIdType> band;
+  for (auto vertex : sourceVertices) {
+    for (vtkIdType j = m_NeighborOffsets[vertex]; j < m_NeighborOffsets[vertex+1]; j++) {
+      auto neighbor = m_Neighbors[j];
+      if (!inBand[neighbor]) {
+        inBand[neighbor] = 1;
+        band.push_back(neighbor);
+      }
+    }
+  }
+
+  std::vector<double> bandTimes;
+  std::vector<char> converged;
+  std::vector<vtkIdType> candidates, nextBand;
+  std::vector<double> candidateTimes;
+  int numIterations = 0;
+
+  while (band.size() != 0) {
+    numIterations += 1;
+
+    // Update the band vertices from the current solution.
+    //
+    vtkIdType numBand = band.size();
+    bandTimes.resize(numBand);
+    converged.resize(numBand);
+
+    auto updateBand = [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType i = begin; i < end; i++) {
+        auto vertex = band[i];
+        double time = activationTimes[vertex];
+        bandTimes[i] = std::min(time, UpdateVertex(vertex, activationTimes, velocity));
+        converged[i] = (time - bandTimes[i] <= tolerance);
+      }
+    };
+    vtkSMPTools::For(0, numBand, updateBand);
+
+    // Converged vertices leave the band, their neighbors 
+    // outside the band are candidates to enter it.
+    //
+    nextBand.clear();
+    candidates.clear();
+    for (vtkIdType i = 0; i < numBand; i++) {
+      auto vertex = band[i];
+      activationTimes[vertex] = bandTimes[i];
+      if (!converged[i]) {
+        nextBand.push_back(vertex);
+        continue;
+      }
+      inBand[vertex] = 0;
+    }
+
+    for (vtkIdType i = 0; i < numBand; i++) {
+      if (!converged[i]) {
+        continue;
+      }
+      auto vertex = band[i];
+      for (vtkIdType j = m_NeighborOffsets[vertex]; j < m_NeighborOffsets[vertex+1]; j++) {
+        auto neighbor = m_Neighbors[j];
+        if (!inBand[neighbor]) {
+          inBand[neighbor] = 1;
+          candidates.push_back(neighbor);
+        }
+      }
+    }
+
+    vtkIdType numCandidates = candidates.size();
+    candidateTimes.resize(numCandidates);
+
+    auto updateCandidates = [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType i = begin; i < end; i++) {
+        candidateTimes[i] = UpdateVertex(candidates[i], activationTimes, velocity);
+      }
+    };
+    vtkSMPTools::For(0, numCandidates, updateCandidates);
+
+    // Candidates whose time is reduced enter the band.
+    for (vtkIdType i = 0; i < numCandidates; i++) {
+      auto vertex = candidates[i];
+      if (candidateTimes[i] < activationTimes[vertex] - tolerance) {
+        activationTimes[vertex] = candidateTimes[i];
+        nextBand.push_back(vertex);
+      } else {
+        inBand[vertex] = 0;
+      }
+    }
+
+    band.swap(nextBand);
+  }
+
+  int numUnreached = 0;
+  for (auto& time : activationTimes) {
+    if (time == infinity) {
+      time = -1.0;
+      numUnreached += 1;
+    }
+  }
+
+  std::chrono::duration<double> elapsedTime = std::chrono::steady_clock::now() - startTime;
+  MITK_INFO << msgPrefix << "Number of iterations " << numIterations << "  time " << elapsedTime.count() << " s";
+
+  if (numUnreached != 0) {
+    MITK_WARN << msgPrefix << numUnreached << " vertices were not reached from a source.";
+  }
+
+  return true;
+}
+
+//--------------
+// UpdateVertex
+//--------------
+// Compute the arrival time at a vertex from the times at the other 
+// vertices of its triangles.
+
+double sv4guiPurkinjeNetworkSurfaceActivation::UpdateVertex(vtkIdType vertex, const std::vector<double>& times, 
+    double velocity) const
+{
+  double time = std::numeric_limits<double>::infinity();
+
+  for (vtkIdType j = m_TriangleOffsets[vertex]; j < m_TriangleOffsets[vertex+1]; j++) {
+    const auto& triangle = m_Triangles[m_VertexTriangles[j]];
+    int k = (triangle[0] == vertex) ? 0 : ((triangle[1] == vertex) ? 1 : 2);
+    auto a = triangle[(k+1) % 3];
+    auto b = triangle[(k+2) % 3];
+    double t = UpdateTriangle(m_Points[a].data(), m_Points[b].data(), m_Points[vertex].data(), times[a], times[b], 
+        velocity);
+    time = std::min(time, t);
+  }
+
+  return time;
+}
+
+//----------------
+// UpdateTriangle
+//----------------
+// Compute the arrival time at vertex c of a triangle from the times at 
+// vertices a and b.
+//
+// The wave reaches c from a point p = a + s (b - a), s in [0,1], on the 
+// opposite edge with the time at p linearly interpolated from the times 
+// at a and b. The arrival time 
+//
+//   T(s) = Ta + s (Tb - Ta) + |c - p| / velocity
+//
+// is convex in s so its minimum is either at the stationary point or at 
+// an edge vertex.
+
+double sv4guiPurkinjeNetworkSurfaceActivation::UpdateTriangle(const double* a, const double* b, const double* c, 
+    double timeA, double timeB, double velocity)
+{
+  const double infinity = std::numeric_limits<double>::infinity();
+  double u[3], w[3], v[3];
+  for (int i = 0; i < 3; i++) {
+    u[i] = b[i] - a[i];
+    w[i] = c[i] - a[i];
+    v[i] = c[i] - b[i];
+  }
+
+  double uu = u[0]*u[0] + u[1]*u[1] + u[2]*u[2];
+  double uw = u[0]*w[0] + u[1]*w[1] + u[2]*w[2];
+  double ww = w[0]*w[0] + w[1]*w[1] + w[2]*w[2];
+  double vv = v[0]*v[0] + v[1]*v[1] + v[2]*v[2];
+
+  double time = std::min(timeA + std::sqrt(ww) / velocity, timeB + std::sqrt(vv) / velocity);
+  if ((timeA == infinity) || (timeB == infinity) || (uu == 0.0)) {
+    return time;
+  }
+
+  // At the stationary point (s uu - uw) / |c - p| = -(Tb - Ta) velocity = k.
+  //
+  double k = -(timeB - timeA) * velocity;
+  double h2 = ww - uw*uw / uu;
+  if ((k*k >= uu) || (h2 <= 0.0)) {
+    return time;
+  }
+
+  double r = k * std::sqrt(h2 * uu / (uu - k*k));
+  double s = (r + uw) / uu;
+  if ((s <= 0.0) || (s >= 1.0)) {
+    return time;
+  }
+
+  double distance = std::sqrt(r*r / uu + h2);
+  return std::min(time, timeA + s * (timeB - timeA) + distance / velocity);
+}
+
+//-------
+// Write
+//-------
+// Write the surface with activation times as point data named 
+// 'ActivationTime' to a VTK .vtp file.
+
+bool sv4guiPurkinjeNetworkSurfaceActivation::Write(const std::string& fileName, 
+    const std::vector<double>& activationTimes)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkSurfaceActivation::Write] ";
+  MITK_INFO << msgPrefix << "File name " << fileName;
+
+  if (activationTimes.size() != m_Points.size()) {
+    MITK_ERROR << msgPrefix << "The number of activation times does not equal the number of vertices.";
+    return false;
+  }
+
+  auto array = vtkSmartPointer<vtkDoubleArray>::New();
+  array->SetName("ActivationTime");
+  array->SetNumberOfValues(activationTimes.size());
+  for (vtkIdType i = 0; i < activationTimes.size(); i++) {
+    array->SetValue(i, activationTimes[i]);
+  }
+
+  auto surface = vtkSmartPointer<vtkPolyData>::New();
+  surface->ShallowCopy(m_Surface);
+  surface->GetPointData()->AddArray(array);
+  surface->GetPointData()->SetActiveScalars("ActivationTime");
+
+  auto writer = vtkSmartPointer<vtkXMLPolyDataWriter>::New();
+  writer->SetFileName(fileName.c_str());
+  writer->SetInputData(surface);
+  return writer->Write() == 1;
+}
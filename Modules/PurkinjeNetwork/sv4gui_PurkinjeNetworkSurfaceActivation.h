@@ -0,0 +1,97 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// This class is used to compute activation times on a triangulated surface 
+// from the activation times of the end nodes of a Purkinje network.
+//
+// Activation times are the solution of the isotropic eikonal equation 
+//
+//   |grad T| = 1 / velocity
+//
+// on the surface. Sources are typically the surface vertices nearest to the 
+// network end nodes (see sv4guiPurkinjeNetworkCoupling::MapEndNodeTimes).
+//
+// The equation is solved with the fast iterative method, a parallel form of 
+// narrow band fast marching: the narrow band (active list) of vertices is 
+// updated in parallel from the current solution, vertices whose time no longer 
+// changes leave the band and add any neighbors they improve. The local update 
+// minimizes the arrival time over the edge opposite the vertex in each of its 
+// triangles so obtuse triangles need no special treatment.
+//
+// Vertex-triangle and vertex-vertex adjacency are stored in compressed sparse 
+// row (CSR) format and built once when the object is created so any number of 
+// networks can be processed for the same surface.
+
+#ifndef SV4GUI_PURKINJENETWORK_SURFACE_ACTIVATION_H
+#define SV4GUI_PURKINJENETWORK_SURFACE_ACTIVATION_H
+
+#include "sv4guiModulePurkinjeNetworkExports.h"
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <array>
+#include <string>
+#include <vector>
+
+class SV4GUIMODULEPURKINJENETWORK_EXPORT sv4guiPurkinjeNetworkSurfaceActivation
+{
+  public:
+
+    sv4guiPurkinjeNetworkSurfaceActivation(vtkPolyData* surface);
+    ~sv4guiPurkinjeNetworkSurfaceActivation();
+
+    bool ComputeActivationTimes(const std::vector<vtkIdType>& sourceVertices, const std::vector<double>& sourceTimes,
+        double velocity, std::vector<double>& activationTimes);
+
+    bool Write(const std::string& fileName, const std::vector<double>& activationTimes);
+
+    vtkIdType GetNumberOfVertices() const { return m_Points.size(); }
+
+  private:
+
+    vtkSmartPointer<vtkPolyData> m_Surface;
+
+    std::vector<std::array<double,3>> m_Points;
+    std::vector<std::array<vtkIdType,3>> m_Triangles;
+    std::vector<vtkIdType> m_TriangleOffsets;
+    std::vector<vtkIdType> m_VertexTriangles;
+    std::vector<vtkIdType> m_NeighborOffsets;
+    std::vector<vtkIdType> m_Neighbors;
+    double m_AverageEdgeLength;
+
+    void BuildAdjacency();
+    double UpdateVertex(vtkIdType vertex, const std::vector<double>& times, double velocity) const;
+    static double UpdateTriangle(const double* a, const double* b, const double* c, double timeA, double timeB,
+        double velocity);
+};
+
+#endif //SV4GUI_PURKINJENETWORK_SURFACE_ACTIVATION_H
@@ -63,6 +63,7 @@
 #include <itkRescaleIntensityImageFilter.h>
 #include <itkCollidingFrontsImageFilter.h>
 #include <itkMinimumImageFilter.h>
+#include <itkSignedMaurerDistanceMapImageFilter.h>
 
 #include <vtkMarchingCubes.h>
 #include <vtkImageCast.h>
@@ -468,6 +469,25 @@ sv4guiPurkinjeNetworkUtils::itkImPoint sv4guiPurkinjeNetworkUtils::fillHoles(sv4
   return itkImage;
 }
 
+// Compute the signed distance (in physical units) to the boundary of the region 
+// with pixel values at or above 'isovalue', negative inside the region.
+sv4guiPurkinjeNetworkUtils::itkImPoint sv4guiPurkinjeNetworkUtils::signedDistance(sv4guiPurkinjeNetworkUtils::itkImPoint image,
+  double isovalue){
+
+  auto region = binaryThreshold(image, isovalue, itk::NumericTraits<sv4guiPurkinjeNetworkUtils::itkImageType::PixelType>::max(), 
+      1.0, 0.0);
+
+  auto distance = itk::SignedMaurerDistanceMapImageFilter<sv4guiPurkinjeNetworkUtils::itkImageType, sv4guiPurkinjeNetworkUtils::itkImageType>::New();
+  distance->SetInput(region);
+  distance->SetBackgroundValue(0.0);
+  distance->SetInsideIsPositive(false);
+  distance->SetSquaredDistance(false);
+  distance->SetUseImageSpacing(true);
+  distance->Update();
+  auto itkImage = distance->GetOutput();
+  return itkImage;
+}
+
 sv4guiPurkinjeNetworkUtils::itkImPoint sv4guiPurkinjeNetworkUtils::gradientMagnitude(sv4guiPurkinjeNetworkUtils::itkImPoint image, double sigma){
   auto gradientFilter = itk::GradientMagnitudeRecursiveGaussianImageFilter<sv4guiPurkinjeNetworkUtils::itkImageType, sv4guiPurkinjeNetworkUtils::itkImageType>::New();
 
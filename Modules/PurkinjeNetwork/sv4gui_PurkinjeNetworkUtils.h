@@ -96,6 +96,7 @@ public:
     static itkImPoint smooth(itkImPoint image, double sigma);
     static itkImPoint anisotropicSmooth(itkImPoint image, int iterations, double timeStep, double conductance);
     static itkImPoint fillHoles(itkImPoint image, double foregroundValue);
+    static itkImPoint signedDistance(itkImPoint image, double isovalue);
 
     static itkImPoint editImage(itkImPoint image,
       int ox, int oy, int oz, int l, int w, int h, double replaceValue);
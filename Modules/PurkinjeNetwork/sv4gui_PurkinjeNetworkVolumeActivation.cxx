@@ -0,0 +1,814 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sv4gui_PurkinjeNetworkVolumeActivation.h"
+
+#include <mitkLogMacros.h>
+
+#include <vtkCellData.h>
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkIdList.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+#include <vtkXMLUnstructuredGridWriter.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <utility>
+
+sv4guiPurkinjeNetworkVolumeActivation::sv4guiPurkinjeNetworkVolumeActivation(vtkUnstructuredGrid* mesh, int blockSize) :
+    m_Mesh(mesh), m_AverageEdgeLength(0.0), m_Slowness2(0.0)
+{
+  BuildBlocks(blockSize);
+}
+
+sv4guiPurkinjeNetworkVolumeActivation::~sv4guiPurkinjeNetworkVolumeActivation()
+{
+}
+
+//-----------
+// GetMethod
+//-----------
+// Get the conduction method from its name: 'none', 'isotropic' or 'anisotropic'.
+
+bool sv4guiPurkinjeNetworkVolumeActivation::GetMethod(const std::string& name, Method& method)
+{
+  if (name == "" || name == "none") {
+    method = Method::None;
+  } else if (name == "isotropic") {
+    method = Method::Isotropic;
+  } else if (name == "anisotropic") {
+    method = Method::Anisotropic;
+  } else {
+    MITK_ERROR << "[sv4guiPurkinjeNetworkVolumeActivation::GetMethod] Unknown volume activation method '" << name << "'.";
+    return false;
+  }
+  return true;
+}
+
+//-------------
+// BuildBlocks
+//-------------
+// Divide the mesh nodes into spatial blocks of about 'blockSize' nodes and 
+// store node data in block order.
+//
+// Nodes are binned on a uniform grid and bins are ordered along a Morton 
+// (Z-order) curve so consecutive bins are close in space. Blocks are formed 
+// from runs of consecutive bins. Cells that are not tetrahedra are ignored.
+
+void sv4guiPurkinjeNetworkVolumeActivation::BuildBlocks(int blockSize)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkVolumeActivation::BuildBlocks] ";
+
+  if ((m_Mesh == nullptr) || (m_Mesh->GetNumberOfPoints() == 0)) {
+    m_BlockOffsets.assign(1, 0);
+    return;
+  }
+
+  vtkIdType numPoints = m_Mesh->GetNumberOfPoints();
+  blockSize = std::max(blockSize, 1);
+
+  std::vector<std::array<double,3>> points(numPoints);
+  double bounds[6] = { 1e300, -1e300, 1e300, -1e300, 1e300, -1e300 };
+  for (vtkIdType i = 0; i < numPoints; i++) {
+    m_Mesh->GetPoint(i, points[i].data());
+    for (int k = 0; k < 3; k++) {
+      bounds[2*k] = std::min(bounds[2*k], points[i][k]);
+      bounds[2*k+1] = std::max(bounds[2*k+1], points[i][k]);
+    }
+  }
+
+  // Bin the nodes using about eight bins per block.
+  //
+  const int maxBins = 1024;
+  double volume = 1.0;
+  for (int k = 0; k < 3; k++) {
+    volume *= std::max(bounds[2*k+1] - bounds[2*k], 1e-12);
+  }
+  double numBins = 8.0 * std::max(numPoints / blockSize, vtkIdType(1));
+  double binSize = std::cbrt(volume / numBins);
+
+  auto getCode = [&](const std::array<double,3>& point) {
+    uint64_t code = 0;
+    for (int k = 0; k < 3; k++) {
+      uint64_t bin = std::min(static_cast<int>((point[k] - bounds[2*k]) / binSize), maxBins-1);
+      for (int bit = 0; bit < 10; bit++) {
+        code |= ((bin >> bit) & 1) << (3*bit + k);
+      }
+    }
+    return code;
+  };
+
+  std::vector<std::pair<uint64_t,vtkIdType>> codes(numPoints);
+  auto computeCodes = [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; i++) {
+      codes[i] = std::make_pair(getCode(points[i]), i);
+    }
+  };
+  vtkSMPTools::For(0, numPoints, computeCodes);
+  std::sort(codes.begin(), codes.end());
+
+  // Renumber nodes in bin order and form blocks from whole bins.
+  //
+  m_NodeMap.resize(numPoints);
+  m_Points.resize(numPoints);
+  m_NodeBlocks.resize(numPoints);
+  m_BlockOffsets.assign(1, 0);
+
+  for (vtkIdType i = 0; i < numPoints; i++) {
+    auto node = codes[i].second;
+    m_NodeMap[node] = i;
+    m_Points[i] = points[node];
+    bool newBin = (i == 0) || (codes[i].first != codes[i-1].first);
+    if (newBin && (i - m_BlockOffsets.back() >= blockSize)) {
+      m_BlockOffsets.push_back(i);
+    }
+    m_NodeBlocks[i] = m_BlockOffsets.size() - 1;
+  }
+  m_BlockOffsets.push_back(numPoints);
+  int numBlocks = m_BlockOffsets.size() - 1;
+
+  // Tetrahedra.
+  //
+  auto cellPoints = vtkSmartPointer<vtkIdList>::New();
+  vtkIdType numCells = m_Mesh->GetNumberOfCells();
+  m_Tetrahedra.clear();
+  m_Tetrahedra.reserve(numCells);
+  m_TetrahedronCells.clear();
+  m_TetrahedronCells.reserve(numCells);
+
+  for (vtkIdType i = 0; i < numCells; i++) {
+    if (m_Mesh->GetCellType(i) != VTK_TETRA) {
+      continue;
+    }
+    m_Mesh->GetCellPoints(i, cellPoints);
+    m_Tetrahedra.push_back({m_NodeMap[cellPoints->GetId(0)], m_NodeMap[cellPoints->GetId(1)], 
+        m_NodeMap[cellPoints->GetId(2)], m_NodeMap[cellPoints->GetId(3)]});
+    m_TetrahedronCells.push_back(i);
+  }
+  MITK_INFO << msgPrefix << "Number of nodes " << numPoints << "  tetrahedra " << m_Tetrahedra.size() << 
+      "  blocks " << numBlocks;
+
+  // Node tetrahedra.
+  //
+  m_TetrahedronOffsets.assign(numPoints+1, 0);
+  for (const auto& tetrahedron : m_Tetrahedra) {
+    for (auto node : tetrahedron) {
+      m_TetrahedronOffsets[node+1] += 1;
+    }
+  }
+  for (vtkIdType i = 0; i < numPoints; i++) {
+    m_TetrahedronOffsets[i+1] += m_TetrahedronOffsets[i];
+  }
+
+  m_NodeTetrahedra.resize(m_TetrahedronOffsets[numPoints]);
+  std::vector<vtkIdType> position(m_TetrahedronOffsets.begin(), m_TetrahedronOffsets.end()-1);
+  for (vtkIdType i = 0; i < m_Tetrahedra.size(); i++) {
+    for (auto node : m_Tetrahedra[i]) {
+      m_NodeTetrahedra[position[node]++] = i;
+    }
+  }
+
+  // Node neighbors, each node has at most three neighbors per tetrahedron.
+  //
+  std::vector<vtkIdType> numNeighbors(numPoints);
+  std::vector<vtkIdType> neighbors(3*m_NodeTetrahedra.size());
+
+  auto findNeighbors = [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; i++) {
+      auto first = neighbors.begin() + 3*m_TetrahedronOffsets[i];
+      auto last = first;
+      for (vtkIdType j = m_TetrahedronOffsets[i]; j < m_TetrahedronOffsets[i+1]; j++) {
+        for (auto node : m_Tetrahedra[m_NodeTetrahedra[j]]) {
+          if (node != i) {
+            *last++ = node;
+          }
+        }
+      }
+      std::sort(first, last);
+      numNeighbors[i] = std::unique(first, last) - first;
+    }
+  };
+  vtkSMPTools::For(0, numPoints, findNeighbors);
+
+  m_NeighborOffsets.assign(numPoints+1, 0);
+  for (vtkIdType i = 0; i < numPoints; i++) {
+    m_NeighborOffsets[i+1] = m_NeighborOffsets[i] + numNeighbors[i];
+  }
+
+  // Copy neighbors, sum edge lengths and find block neighbors.
+  //
+  m_Neighbors.resize(m_NeighborOffsets[numPoints]);
+  std::vector<std::pair<int,int>> blockPairs;
+  double edgeLengthSum = 0.0;
+
+  for (vtkIdType i = 0; i < numPoints; i++) {
+    auto first = neighbors.begin() + 3*m_TetrahedronOffsets[i];
+    std::copy(first, first + numNeighbors[i], m_Neighbors.begin() + m_NeighborOffsets[i]);
+    for (vtkIdType j = 0; j < numNeighbors[i]; j++) {
+      const auto& p1 = m_Points[i];
+      const auto& p2 = m_Points[first[j]];
+      edgeLengthSum += std::sqrt((p2[0]-p1[0])*(p2[0]-p1[0]) + (p2[1]-p1[1])*(p2[1]-p1[1]) + 
+          (p2[2]-p1[2])*(p2[2]-p1[2]));
+      if (m_NodeBlocks[i] != m_NodeBlocks[first[j]]) {
+        blockPairs.push_back(std::make_pair(m_NodeBlocks[i], m_NodeBlocks[first[j]]));
+      }
+    }
+  }
+
+  if (m_Neighbors.size() != 0) {
+    m_AverageEdgeLength = edgeLengthSum / m_Neighbors.size();
+  }
+
+  std::sort(blockPairs.begin(), blockPairs.end());
+  blockPairs.erase(std::unique(blockPairs.begin(), blockPairs.end()), blockPairs.end());
+
+  m_BlockNeighborOffsets.assign(numBlocks+1, 0);
+  m_BlockNeighbors.resize(blockPairs.size());
+  for (int i = 0; i < blockPairs.size(); i++) {
+    m_BlockNeighborOffsets[blockPairs[i].first+1] += 1;
+    m_BlockNeighbors[i] = blockPairs[i].second;
+  }
+  for (int i = 0; i < numBlocks; i++) {
+    m_BlockNeighborOffsets[i+1] += m_BlockNeighborOffsets[i];
+  }
+}
+
+//-------------
+// SetVelocity
+//-------------
+// Set an isotropic conduction velocity.
+
+bool sv4guiPurkinjeNetworkVolumeActivation::SetVelocity(double velocity)
+{
+  if (velocity <= 0.0) {
+    MITK_ERROR << "[sv4guiPurkinjeNetworkVolumeActivation::SetVelocity] The velocity must be positive.";
+    return false;
+  }
+
+  m_Slowness2 = 1.0 / (velocity * velocity);
+  m_Metrics.clear();
+  return true;
+}
+
+//-------------
+// SetVelocity
+//-------------
+// Set anisotropic conduction velocities along and across the fiber 
+// directions given by the 'fiberArrayName' cell data array.
+//
+// Cells with a zero fiber direction are isotropic with the fiber velocity.
+
+bool sv4guiPurkinjeNetworkVolumeActivation::SetVelocity(double fiberVelocity, double crossFiberVelocity, 
+    const std::string& fiberArrayName)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkVolumeActivation::SetVelocity] ";
+
+  if ((fiberVelocity <= 0.0) || (crossFiberVelocity <= 0.0)) {
+    MITK_ERROR << msgPrefix << "The velocities must be positive.";
+    return false;
+  }
+
+  auto fibers = m_Mesh->GetCellData()->GetArray(fiberArrayName.c_str());
+  if ((fibers == nullptr) || (fibers->GetNumberOfComponents() != 3)) {
+    MITK_ERROR << msgPrefix << "The mesh does not have a '" << fiberArrayName << "' fiber direction cell data array.";
+    return false;
+  }
+  MITK_INFO << msgPrefix << "Fiber velocity " << fiberVelocity << "  cross-fiber velocity " << crossFiberVelocity;
+
+  double fiberSlowness2 = 1.0 / (fiberVelocity * fiberVelocity);
+  double crossSlowness2 = 1.0 / (crossFiberVelocity * crossFiberVelocity);
+  m_Slowness2 = fiberSlowness2;
+  m_Metrics.resize(m_Tetrahedra.size());
+
+  for (vtkIdType i = 0; i < m_Tetrahedra.size(); i++) {
+    double f[3];
+    fibers->GetTuple(m_TetrahedronCells[i], f);
+    double length = std::sqrt(f[0]*f[0] + f[1]*f[1] + f[2]*f[2]);
+    auto& m = m_Metrics[i];
+
+    if (length == 0.0) {
+      m = { fiberSlowness2, fiberSlowness2, fiberSlowness2, 0.0, 0.0, 0.0 };
+      continue;
+    }
+
+    for (int k = 0; k < 3; k++) {
+      f[k] /= length;
+    }
+    double b = fiberSlowness2 - crossSlowness2;
+    m = { crossSlowness2 + b*f[0]*f[0], crossSlowness2 + b*f[1]*f[1], crossSlowness2 + b*f[2]*f[2], 
+          b*f[0]*f[1], b*f[1]*f[2], b*f[0]*f[2] };
+  }
+
+  return true;
+}
+
+//------------------------
+// ComputeActivationTimes
+//------------------------
+// Compute the activation time of each mesh node.
+//
+// Arguments:
+//   sourceNodes - The mesh nodes where activation starts.
+//   sourceTimes - The activation time at each source node.
+//
+// Output:
+//   activationTimes - The activation time of each mesh node, nodes that can't be 
+//     reached from a source are set to -1.
+
+bool sv4guiPurkinjeNetworkVolumeActivation::ComputeActivationTimes(const std::vector<vtkIdType>& sourceNodes, 
+    const std::vector<double>& sourceTimes, std::vector<double>& activationTimes)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkVolumeActivation::ComputeActivationTimes] ";
+  MITK_INFO << msgPrefix << "Number of sources " << sourceNodes.size();
+
+  vtkIdType numPoints = m_Points.size();
+  int numBlocks = GetNumberOfBlocks();
+
+  if (sourceNodes.size() != sourceTimes.size()) {
+    MITK_ERROR << msgPrefix << "The number of source nodes and source times differ.";
+    return false;
+  }
+
+  if (m_Slowness2 <= 0.0) {
+    MITK_ERROR << msgPrefix << "No velocity has been set.";
+    return false;
+  }
+
+  for (auto node : sourceNodes) {
+    if ((node < 0) || (node >= numPoints)) {
+      MITK_ERROR << msgPrefix << "Source node " << node << " is out of range.";
+      return false;
+    }
+  }
+
+  auto startTime = std::chrono::steady_clock::now();
+  const double infinity = std::numeric_limits<double>::infinity();
+  double edgeTime = m_AverageEdgeLength * std::sqrt(m_Slowness2);
+
+  State state;
+  state.tolerance = 1e-6 * edgeTime;
+  state.times.assign(numPoints, infinity);
+  state.blockTimes.assign(numPoints, infinity);
+  state.changed.assign(numPoints, 0);
+  state.newChanged.assign(numPoints, 0);
+  state.pending.assign(numPoints, 0);
+
+  std::vector<char> isActive(numBlocks, 0);
+  std::vector<int> activeBlocks, previousBlocks;
+  std::vector<double> blockPendingTimes(numBlocks, infinity);
+
+  auto activate = [&](int block) {
+    if (!isActive[block]) {
+      isActive[block] = 1;
+      activeBlocks.push_back(block);
+    }
+  };
+
+  // The blocks containing the sources and their neighbors are active first.
+  //
+  double minSourceTime = infinity;
+  for (int i = 0; i < sourceNodes.size(); i++) {
+    auto node = m_NodeMap[sourceNodes[i]];
+    state.times[node] = std::min(state.times[node], sourceTimes[i]);
+    state.changed[node] = 1;
+    minSourceTime = std::min(minSourceTime, sourceTimes[i]);
+    activate(m_NodeBlocks[node]);
+    for (vtkIdType j = m_NeighborOffsets[node]; j < m_NeighborOffsets[node+1]; j++) {
+      activate(m_NodeBlocks[m_Neighbors[j]]);
+    }
+  }
+  previousBlocks = activeBlocks;
+
+  // The band advances the travel time of an average edge each iteration, 
+  // wider bands need fewer iterations but update nodes more often.
+  double bandWidth = edgeTime;
+  state.bandLimit = minSourceTime + bandWidth;
+
+  std::vector<char> blockChanged;
+  int numIterations = 0;
+  long numBlockUpdates = 0;
+
+  while (true) {
+    // Activate the blocks with pending nodes inside the band, advance the 
+    // band to the earliest pending node if there are no active blocks.
+    //
+    double minPendingTime = infinity;
+    for (int block = 0; block < numBlocks; block++) {
+      if (blockPendingTimes[block] <= state.bandLimit) {
+        activate(block);
+      }
+      minPendingTime = std::min(minPendingTime, blockPendingTimes[block]);
+    }
+
+    if (activeBlocks.size() == 0) {
+      if (minPendingTime == infinity) {
+        break;
+      }
+      state.bandLimit = minPendingTime + bandWidth;
+      continue;
+    }
+
+    numIterations += 1;
+    numBlockUpdates += activeBlocks.size();
+    int numActive = activeBlocks.size();
+    blockChanged.resize(numActive);
+
+    auto updateBlocks = [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType i = begin; i < end; i++) {
+        int block = activeBlocks[i];
+        blockChanged[i] = UpdateBlock(block, state, blockPendingTimes[block]);
+      }
+    };
+    vtkSMPTools::For(0, numActive, updateBlocks);
+
+    // Clear the flags of the previous iteration.
+    for (auto block : previousBlocks) {
+      std::fill(state.changed.begin() + m_BlockOffsets[block], state.changed.begin() + m_BlockOffsets[block+1], 0);
+    }
+    state.changed.swap(state.newChanged);
+
+    // Copy the new times of the blocks that changed and activate the 
+    // blocks with neighbors of the changed nodes.
+    //
+    previousBlocks.swap(activeBlocks);
+    activeBlocks.clear();
+    for (auto block : previousBlocks) {
+      isActive[block] = 0;
+    }
+
+    for (int i = 0; i < numActive; i++) {
+      if (!blockChanged[i]) {
+        continue;
+      }
+      int block = previousBlocks[i];
+      for (vtkIdType node = m_BlockOffsets[block]; node < m_BlockOffsets[block+1]; node++) {
+        state.times[node] = state.blockTimes[node];
+        if (!state.changed[node]) {
+          continue;
+        }
+        for (vtkIdType j = m_NeighborOffsets[node]; j < m_NeighborOffsets[node+1]; j++) {
+          int neighborBlock = m_NodeBlocks[m_Neighbors[j]];
+          if (neighborBlock != block) {
+            activate(neighborBlock);
+          }
+        }
+      }
+    }
+
+    state.bandLimit += bandWidth;
+  }
+
+  activationTimes.resize(numPoints);
+  int numUnreached = 0;
+  for (vtkIdType i = 0; i < numPoints; i++) {
+    double time = state.times[m_NodeMap[i]];
+    if (time == infinity) {
+      time = -1.0;
+      numUnreached += 1;
+    }
+    activationTimes[i] = time;
+  }
+
+  std::chrono::duration<double> elapsedTime = std::chrono::steady_clock::now() - startTime;
+  MITK_INFO << msgPrefix << "Number of iterations " << numIterations << "  block updates " << numBlockUpdates << 
+      "  time " << elapsedTime.count() << " s";
+
+  if (numUnreached != 0) {
+    MITK_WARN << msgPrefix << numUnreached << " nodes were not reached from a source.";
+  }
+
+  return true;
+}
+
+//-------------
+// UpdateBlock
+//-------------
+// Update the times of the nodes in a block until they converge.
+//
+// The nodes with a neighbor that changed in the previous iteration are updated 
+// first, nodes whose time changes add their neighbors in the block to the list 
+// of nodes to update. The times of the block nodes are updated in 'blockTimes', 
+// the times of other nodes are read from 'times'.
+//
+// Changes are only propagated from nodes with times inside the band, nodes with 
+// later times are pending until the band reaches them. This limits the number 
+// of times a node is updated before the front arrives. 
+//
+// Nodes whose time changed and was propagated are flagged in 'newChanged'. 
+// Returns true if any time changed, 'pendingTime' is set to the earliest 
+// time of the pending nodes in the block.
+
+bool sv4guiPurkinjeNetworkVolumeActivation::UpdateBlock(int block, State& state, double& pendingTime) const
+{
+  vtkIdType first = m_BlockOffsets[block];
+  vtkIdType last = m_BlockOffsets[block+1];
+  std::copy(state.times.begin() + first, state.times.begin() + last, state.blockTimes.begin() + first);
+
+  std::vector<char> inList(last - first, 0);
+  std::deque<vtkIdType> list;
+  bool blockChanged = false;
+
+  auto propagate = [&](vtkIdType node) {
+    state.pending[node] = 0;
+    state.newChanged[node] = 1;
+    blockChanged = true;
+    for (vtkIdType j = m_NeighborOffsets[node]; j < m_NeighborOffsets[node+1]; j++) {
+      auto neighbor = m_Neighbors[j];
+      if ((neighbor >= first) && (neighbor < last) && !inList[neighbor-first]) {
+        inList[neighbor-first] = 1;
+        list.push_back(neighbor);
+      }
+    }
+  };
+
+  for (vtkIdType node = first; node < last; node++) {
+    for (vtkIdType j = m_NeighborOffsets[node]; j < m_NeighborOffsets[node+1]; j++) {
+      if (state.changed[m_Neighbors[j]]) {
+        inList[node-first] = 1;
+        list.push_back(node);
+        break;
+      }
+    }
+  }
+
+  // Pending nodes now inside the band.
+  for (vtkIdType node = first; node < last; node++) {
+    if (state.pending[node] && (state.blockTimes[node] <= state.bandLimit)) {
+      propagate(node);
+    }
+  }
+
+  while (!list.empty()) {
+    auto node = list.front();
+    list.pop_front();
+    inList[node-first] = 0;
+
+    double time = UpdateNode(node, block, state.times, state.blockTimes);
+    if (time >= state.blockTimes[node]) {
+      continue;
+    }
+
+    bool significant = (time < state.blockTimes[node] - state.tolerance);
+    state.blockTimes[node] = time;
+    if (!significant) {
+      continue;
+    }
+
+    if (time <= state.bandLimit) {
+      propagate(node);
+    } else {
+      state.pending[node] = 1;
+      blockChanged = true;
+    }
+  }
+
+  pendingTime = std::numeric_limits<double>::infinity();
+  for (vtkIdType node = first; node < last; node++) {
+    if (state.pending[node]) {
+      pendingTime = std::min(pendingTime, state.blockTimes[node]);
+    }
+  }
+
+  return blockChanged;
+}
+
+//------------
+// UpdateNode
+//------------
+// Compute the arrival time at a node from the times at the other 
+// nodes of its tetrahedra.
+
+double sv4guiPurkinjeNetworkVolumeActivation::UpdateNode(vtkIdType node, int block, const std::vector<double>& times, 
+    const std::vector<double>& blockTimes) const
+{
+  double time = std::numeric_limits<double>::infinity();
+  const double* p[3];
+  double t[3];
+
+  for (vtkIdType j = m_TetrahedronOffsets[node]; j < m_TetrahedronOffsets[node+1]; j++) {
+    auto tetrahedron = m_NodeTetrahedra[j];
+    int n = 0;
+    for (auto faceNode : m_Tetrahedra[tetrahedron]) {
+      if (faceNode == node) {
+        continue;
+      }
+      p[n] = m_Points[faceNode].data();
+      t[n] = (m_NodeBlocks[faceNode] == block) ? blockTimes[faceNode] : times[faceNode];
+      n += 1;
+    }
+    time = std::min(time, UpdateFace(tetrahedron, m_Points[node].data(), p, t));
+  }
+
+  return time;
+}
+
+//------------
+// UpdateFace
+//------------
+// Compute the arrival time at node x of a tetrahedron from the times 
+// at the nodes of the opposite face.
+//
+// The wave reaches x from a point p = p0 + l1 (p1 - p0) + l2 (p2 - p0) 
+// on the face with the time at p linearly interpolated from the times 
+// at the face nodes. The arrival time 
+//
+//   T(l) = t0 + l . d + |x - p|_M,   d = (t1 - t0, t2 - t0) 
+//
+// is convex in l so its minimum is either at the stationary point inside 
+// the face, on a face edge or at a face node.
+
+double sv4guiPurkinjeNetworkVolumeActivation::UpdateFace(vtkIdType tetrahedron, const double* x, const double* p[3],
+    const double t[3]) const
+{
+  const double infinity = std::numeric_limits<double>::infinity();
+  if ((t[0] == infinity) && (t[1] == infinity) && (t[2] == infinity)) {
+    return infinity;
+  }
+
+  // Face nodes.
+  //
+  double w[3][3], w2[3];
+  double time = infinity;
+  for (int i = 0; i < 3; i++) {
+    for (int k = 0; k < 3; k++) {
+      w[i][k] = x[k] - p[i][k];
+    }
+    if (t[i] != infinity) {
+      w2[i] = Dot(tetrahedron, w[i], w[i]);
+      time = std::min(time, t[i] + std::sqrt(w2[i]));
+    }
+  }
+
+  // Face edges.
+  //
+  const int edges[3][2] = { {0,1}, {1,2}, {0,2} };
+  double u[3][3];
+  for (int i = 0; i < 3; i++) {
+    int a = edges[i][0];
+    int b = edges[i][1];
+    for (int k = 0; k < 3; k++) {
+      u[i][k] = w[a][k] - w[b][k];
+    }
+    if ((t[a] != infinity) && (t[b] != infinity)) {
+      time = std::min(time, UpdateEdge(tetrahedron, w[a], u[i], w2[a], t[a], t[b]));
+    }
+  }
+
+  if ((t[0] == infinity) || (t[1] == infinity) || (t[2] == infinity)) {
+    return time;
+  }
+
+  // Face interior, with G = U^T M U and g = U^T M w the stationary point 
+  // is l = G^-1 (g - |x - p|_M d).
+  //
+  const double* u1 = u[0];
+  const double* u2 = u[2];
+  double g11 = Dot(tetrahedron, u1, u1);
+  double g12 = Dot(tetrahedron, u1, u2);
+  double g22 = Dot(tetrahedron, u2, u2);
+  double det = g11*g22 - g12*g12;
+  if (det <= 1e-12 * g11 * g22) {
+    return time;
+  }
+
+  double g1 = Dot(tetrahedron, u1, w[0]);
+  double g2 = Dot(tetrahedron, u2, w[0]);
+  double d1 = t[1] - t[0];
+  double d2 = t[2] - t[0];
+
+  double dGd = (g22*d1*d1 - 2.0*g12*d1*d2 + g11*d2*d2) / det;
+  double r2 = w2[0] - (g22*g1*g1 - 2.0*g12*g1*g2 + g11*g2*g2) / det;
+  if ((dGd >= 1.0) || (r2 <= 0.0)) {
+    return time;
+  }
+
+  double distance = std::sqrt(r2 / (1.0 - dGd));
+  double b1 = g1 - distance * d1;
+  double b2 = g2 - distance * d2;
+  double l1 = (g22*b1 - g12*b2) / det;
+  double l2 = (g11*b2 - g12*b1) / det;
+  if ((l1 <= 0.0) || (l2 <= 0.0) || (l1 + l2 >= 1.0)) {
+    return time;
+  }
+
+  return std::min(time, t[0] + l1*d1 + l2*d2 + distance);
+}
+
+//------------
+// UpdateEdge
+//------------
+// Compute the arrival time at node x from the interior of the 
+// edge from node a to node b, see UpdateFace().
+//
+// Arguments:
+//   w - The vector from a to x.
+//   u - The vector from a to b.
+//   ww - The squared length of w.
+//
+// Returns infinity if the minimum is not inside the edge.
+
+double sv4guiPurkinjeNetworkVolumeActivation::UpdateEdge(vtkIdType tetrahedron, const double* w, const double* u, 
+    double ww, double timeA, double timeB) const
+{
+  double uu = Dot(tetrahedron, u, u);
+  double uw = Dot(tetrahedron, u, w);
+  double k = -(timeB - timeA);
+  double h2 = ww - uw*uw / uu;
+  if ((k*k >= uu) || (h2 <= 0.0)) {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  double r = k * std::sqrt(h2 * uu / (uu - k*k));
+  double s = (r + uw) / uu;
+  if ((s <= 0.0) || (s >= 1.0)) {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  return timeA + s * (timeB - timeA) + std::sqrt(r*r / uu + h2);
+}
+
+//-----
+// Dot
+//-----
+// Compute the inner product u^T M v using the metric of a tetrahedron.
+
+double sv4guiPurkinjeNetworkVolumeActivation::Dot(vtkIdType tetrahedron, const double* u, const double* v) const
+{
+  if (m_Metrics.size() == 0) {
+    return m_Slowness2 * (u[0]*v[0] + u[1]*v[1] + u[2]*v[2]);
+  }
+
+  const auto& m = m_Metrics[tetrahedron];
+  return u[0] * (m[0]*v[0] + m[3]*v[1] + m[5]*v[2]) + 
+         u[1] * (m[3]*v[0] + m[1]*v[1] + m[4]*v[2]) + 
+         u[2] * (m[5]*v[0] + m[4]*v[1] + m[2]*v[2]);
+}
+
+//-------
+// Write
+//-------
+// Write the mesh with activation times as point data named 
+// 'ActivationTime' to a VTK .vtu file.
+
+bool sv4guiPurkinjeNetworkVolumeActivation::Write(const std::string& fileName, 
+    const std::vector<double>& activationTimes)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkVolumeActivation::Write] ";
+  MITK_INFO << msgPrefix << "File name " << fileName;
+
+  if (activationTimes.size() != m_Points.size()) {
+    MITK_ERROR << msgPrefix << "The number of activation times does not equal the number of nodes.";
+    return false;
+  }
+
+  auto array = vtkSmartPointer<vtkDoubleArray>::New();
+  array->SetName("ActivationTime");
+  array->SetNumberOfValues(activationTimes.size());
+  for (vtkIdType i = 0; i < activationTimes.size(); i++) {
+    array->SetValue(i, activationTimes[i]);
+  }
+
+  auto mesh = vtkSmartPointer<vtkUnstructuredGrid>::New();
+  mesh->ShallowCopy(m_Mesh);
+  mesh->GetPointData()->AddArray(array);
+  mesh->GetPointData()->SetActiveScalars("ActivationTime");
+
+  auto writer = vtkSmartPointer<vtkXMLUnstructuredGridWriter>::New();
+  writer->SetFileName(fileName.c_str());
+  writer->SetInputData(mesh);
+  return writer->Write() == 1;
+}
@@ -0,0 +1,141 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// This class is used to compute activation times in a tetrahedral volume mesh 
+// (e.g. Meshes/myocardium.vtu) from the activation times of the end nodes of a 
+// Purkinje network.
+//
+// Activation times are the solution of the eikonal equation 
+//
+//   sqrt(grad T . D grad T) = 1
+//
+// where D = v^2 I for isotropic conduction with velocity v. For anisotropic 
+// conduction 
+//
+//   D = vc^2 I + (vf^2 - vc^2) f f^T
+//
+// with velocity vf along the fiber direction f (cell data) and vc across fibers.
+// Sources are typically the mesh nodes nearest to the network end nodes (see 
+// sv4guiPurkinjeNetworkCoupling::MapEndNodeTimes).
+//
+// The equation is solved with a block fast iterative method. Mesh nodes are 
+// renumbered so nodes in the same spatial block are contiguous. Active blocks 
+// are updated in parallel: each block updates the nodes affected by changes in 
+// the previous iteration until its times converge, reading the times of nodes 
+// in other blocks from the previous iteration. Blocks with neighbors of nodes 
+// whose times changed are active in the next iteration. Changes only propagate 
+// from nodes with times below a band limit that advances each iteration so 
+// nodes are not repeatedly updated ahead of the front. The local update minimizes the arrival time over the 
+// face opposite the node in each of its tetrahedra using the metric D^-1.
+
+#ifndef SV4GUI_PURKINJENETWORK_VOLUME_ACTIVATION_H
+#define SV4GUI_PURKINJENETWORK_VOLUME_ACTIVATION_H
+
+#include "sv4guiModulePurkinjeNetworkExports.h"
+
+#include <vtkSmartPointer.h>
+#include <vtkUnstructuredGrid.h>
+
+#include <array>
+#include <string>
+#include <vector>
+
+class SV4GUIMODULEPURKINJENETWORK_EXPORT sv4guiPurkinjeNetworkVolumeActivation
+{
+  public:
+
+    enum class Method { None, Isotropic, Anisotropic };
+
+    sv4guiPurkinjeNetworkVolumeActivation(vtkUnstructuredGrid* mesh, int blockSize=512);
+    ~sv4guiPurkinjeNetworkVolumeActivation();
+
+    static bool GetMethod(const std::string& name, Method& method);
+
+    bool SetVelocity(double velocity);
+    bool SetVelocity(double fiberVelocity, double crossFiberVelocity, const std::string& fiberArrayName="FIB_DIR");
+
+    bool ComputeActivationTimes(const std::vector<vtkIdType>& sourceNodes, const std::vector<double>& sourceTimes,
+        std::vector<double>& activationTimes);
+
+    bool Write(const std::string& fileName, const std::vector<double>& activationTimes);
+
+    vtkIdType GetNumberOfNodes() const { return m_Points.size(); }
+    int GetNumberOfBlocks() const { return m_BlockOffsets.size() - 1; }
+
+  private:
+
+    vtkSmartPointer<vtkUnstructuredGrid> m_Mesh;
+
+    // Node data is stored in block order, m_NodeMap gives the 
+    // block order index of each mesh node.
+    std::vector<vtkIdType> m_NodeMap;
+    std::vector<std::array<double,3>> m_Points;
+    std::vector<std::array<vtkIdType,4>> m_Tetrahedra;
+    std::vector<vtkIdType> m_TetrahedronCells;
+    std::vector<vtkIdType> m_TetrahedronOffsets;
+    std::vector<vtkIdType> m_NodeTetrahedra;
+    std::vector<vtkIdType> m_NeighborOffsets;
+    std::vector<vtkIdType> m_Neighbors;
+    double m_AverageEdgeLength;
+
+    std::vector<vtkIdType> m_BlockOffsets;
+    std::vector<int> m_NodeBlocks;
+    std::vector<int> m_BlockNeighborOffsets;
+    std::vector<int> m_BlockNeighbors;
+
+    // Metric D^-1, a single scalar for isotropic conduction or the six 
+    // components (xx,yy,zz,xy,yz,xz) for each tetrahedron. 
+    double m_Slowness2;
+    std::vector<std::array<double,6>> m_Metrics;
+
+    // The solution state, during an iteration each block only writes 
+    // blockTimes, newChanged and pending for its own nodes.
+    struct State {
+      std::vector<double> times;
+      std::vector<double> blockTimes;
+      std::vector<char> changed;
+      std::vector<char> newChanged;
+      std::vector<char> pending;
+      double bandLimit;
+      double tolerance;
+    };
+
+    void BuildBlocks(int blockSize);
+    bool UpdateBlock(int block, State& state, double& pendingTime) const;
+    double UpdateNode(vtkIdType node, int block, const std::vector<double>& times, 
+        const std::vector<double>& blockTimes) const;
+    double UpdateFace(vtkIdType tetrahedron, const double* x, const double* p[3], const double t[3]) const;
+    double UpdateEdge(vtkIdType tetrahedron, const double* w, const double* u, double ww, double timeA, 
+        double timeB) const;
+    double Dot(vtkIdType tetrahedron, const double* u, const double* v) const;
+};
+
+#endif //SV4GUI_PURKINJENETWORK_VOLUME_ACTIVATION_H
@@ -44,8 +44,6 @@ sv4guiPurkinjeNetwork1DContainer::sv4guiPurkinjeNetwork1DContainer()
   hoverPoint.push_back(0.0);
   hoverPoint.push_back(0.0);
   hoverPoint.push_back(0.0);
-  m_NewSurfaceNetworkMesh = true;
-  m_SurfaceNetworkMesh = nullptr;
 }
 
 sv4guiPurkinjeNetwork1DContainer::sv4guiPurkinjeNetwork1DContainer(const sv4guiPurkinjeNetwork1DContainer& other)
@@ -69,29 +67,155 @@ sv4guiPurkinjeNetwork1DContainer::~sv4guiPurkinjeNetwork1DContainer(){
 
 };
 
-//-------------------------------
-// Get/Set NewSurfaceNetworkMesh
-//-------------------------------
+//------------
+// SetNetwork
+//------------
+// Set the network.
 
-bool sv4guiPurkinjeNetwork1DContainer::IsNewSurfaceNetworkMesh()
+void sv4guiPurkinjeNetwork1DContainer::SetNetwork(const sv4guiPurkinjeNetworkGraph& network)
 {
-  return m_NewSurfaceNetworkMesh;
+  m_Network = network;
+  if (!m_Network.HaveAdjacency()) {
+    m_Network.BuildAdjacency();
+  }
+  m_NetworkID += 1;
+  UpdateNetworkData();
 }
-void sv4guiPurkinjeNetwork1DContainer::SetNewSurfaceNetworkMesh(bool value)
+
+//-------------
+// ApplyChange
+//-------------
+// Apply or undo an edit of the network.
+
+void sv4guiPurkinjeNetwork1DContainer::ApplyChange(const sv4guiPurkinjeNetworkGraph::Change& change, bool undo)
 {
-  m_NewSurfaceNetworkMesh = value;
+  m_Network.ApplyChange(change, undo);
+  if (!m_Network.HaveAdjacency()) {
+    m_Network.BuildAdjacency();
+  }
+  UpdateNetworkData();
 }
 
+//------------------
+// ExecuteOperation
+//------------------
+// Apply or undo a network edit, see sv4gui_PurkinjeNetworkOperation.h.
 
-sv4guiMesh* sv4guiPurkinjeNetwork1DContainer::GetSurfaceNetworkMesh()
+void sv4guiPurkinjeNetwork1DContainer::ExecuteOperation(mitk::Operation* operation)
 {
-  return m_SurfaceNetworkMesh;
+  std::string msgPrefix = "[sv4guiPurkinjeNetwork1DContainer::ExecuteOperation] ";
+
+  auto networkOperation = dynamic_cast<sv4guiPurkinjeNetworkOperation*>(operation);
+  if (networkOperation == nullptr) {
+    MITK_ERROR << msgPrefix << "No valid network operation.";
+    return;
+  }
+
+  auto type = operation->GetOperationType();
+  if ((type != sv4guiPurkinjeNetworkOperation::OpAPPLYCHANGE) && (type != sv4guiPurkinjeNetworkOperation::OpUNDOCHANGE)) {
+    MITK_WARN << msgPrefix << "Unknown operation type " << type;
+    return;
+  }
+
+  if (networkOperation->GetNetworkID() != m_NetworkID) {
+    MITK_WARN << msgPrefix << "The network has been replaced since the edit, the operation is ignored.";
+    return;
+  }
+
+  ApplyChange(*networkOperation->GetChange(), type == sv4guiPurkinjeNetworkOperation::OpUNDOCHANGE);
+  InvokeEvent(sv4guiPurkinjeNetwork1DChangeEvent());
+
+  mitk::OperationEndEvent endevent(operation);
+  ((const itk::Object*)this)->InvokeEvent(endevent);
 }
 
-void sv4guiPurkinjeNetwork1DContainer::SetSurfaceNetworkMesh(sv4guiMesh* mesh)
+//-------------------
+// UpdateNetworkData
+//-------------------
+// Update the data derived from the network.
+//
+// The network is also stored as vtkPolyData with one polyline per branch
+// for rendering. The branch of each segment is stored to identify picked
+// network elements.
+//
+// The branches are extracted again from the whole network, also after 
+// a local edit, so the cost is linear in the size of the network.
+
+void sv4guiPurkinjeNetwork1DContainer::UpdateNetworkData()
 {
-  m_SurfaceNetworkMesh = mesh;
-  m_NewSurfaceNetworkMesh = true;
+  m_Network.ExtractBranches(m_Branches);
+  m_Network.GetBranchGenerations(m_Branches, m_BranchGenerations);
+  m_SegmentBranches.assign(m_Network.GetNumberOfSegments(), -1);
+  m_SegmentBranchPositions.assign(m_Network.GetNumberOfSegments(), -1);
+  for (int i = 0; i < m_Branches.size(); i++) {
+    const auto& segments = m_Branches[i].segments;
+    for (int j = 0; j < segments.size(); j++) {
+      m_SegmentBranches[segments[j]] = i;
+      m_SegmentBranchPositions[segments[j]] = j;
+    }
+  }
+
+  m_NetworkPolyData = m_Network.CreateBranchPolyData(m_Branches, m_BranchGenerations);
+  m_SegmentTreeValid = false;
+  m_SelectedNetworkElement = NetworkElement();
+  Modified();
+}
+
+vtkSmartPointer<vtkPolyData> sv4guiPurkinjeNetwork1DContainer::GetNetworkPolyData()
+{
+  return m_NetworkPolyData;
+}
+
+//----------------
+// GetSegmentTree
+//----------------
+// Get the segment tree of the network, building it if the network has changed.
+
+const sv4guiPurkinjeNetworkSegmentTree& sv4guiPurkinjeNetwork1DContainer::GetSegmentTree()
+{
+  if (!m_SegmentTreeValid) {
+    m_SegmentTree.Build(m_Network);
+    m_SegmentTreeValid = true;
+  }
+  return m_SegmentTree;
+}
+
+//--------------------
+// FindNetworkElement
+//--------------------
+// Find the network element picked by the line segment [start,end], the 
+// line through the cursor from the near to the far clipping plane.
+//
+// The segment within 'tolerance' of the line that is closest to 'start' is
+// picked using the segment tree.
+
+bool sv4guiPurkinjeNetwork1DContainer::FindNetworkElement(const double start[3], const double end[3], 
+    double tolerance, NetworkElement& element)
+{
+  element = NetworkElement();
+
+  int segment;
+  double param, distance;
+  if (!GetSegmentTree().FindFirstSegmentNearLine(start, end, tolerance, segment, param, distance)) {
+    return false;
+  }
+
+  const auto& nodes = m_Network.GetNodes();
+  const auto& segmentNodes = m_Network.GetSegments()[segment];
+  const auto& p1 = nodes[segmentNodes[0]];
+  const auto& p2 = nodes[segmentNodes[1]];
+  for (int j = 0; j < 3; j++) {
+    element.point[j] = p1[j] + param * (p2[j] - p1[j]);
+  }
+
+  element.segment = segment;
+  element.node = (param < 0.5) ? segmentNodes[0] : segmentNodes[1];
+  element.branch = m_SegmentBranches[segment];
+  element.branchSegment = m_SegmentBranchPositions[segment];
+  if (element.branch != -1) {
+    element.generation = m_BranchGenerations[element.branch];
+  }
+  return true;
 }
 
 void sv4guiPurkinjeNetwork1DContainer::addStartSeed(double x, double y, double z)
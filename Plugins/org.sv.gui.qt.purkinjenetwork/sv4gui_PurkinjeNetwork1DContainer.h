@@ -35,12 +35,28 @@
 #include <iostream>
 #include <vector>
 #include "mitkBaseData.h"
+#include <itkEventObject.h>
 #include "sv4gui_Mesh.h"
+#include "sv4gui_PurkinjeNetworkGraph.h"
+#include "sv4gui_PurkinjeNetworkOperation.h"
+#include "sv4gui_PurkinjeNetworkSegmentTree.h"
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
 
 class sv4guiPurkinjeNetwork1DContainer : public mitk::BaseData {
 
   public:
 
+    // A network element found by picking.
+    struct NetworkElement {
+      int branch = -1;           // Branch index, the polyline cell in GetNetworkPolyData().
+      int segment = -1;          // Network segment index.
+      int branchSegment = -1;    // Position of the segment along the branch.
+      int generation = -1;       // Branch generation.
+      int node = -1;             // Segment node closest to the picked point.
+      double point[3] = {0.0, 0.0, 0.0};
+    };
+
     mitkClassMacro(sv4guiPurkinjeNetwork1DContainer, mitk::BaseData);
     itkFactorylessNewMacro(Self)
     itkCloneMacro(Self)
@@ -66,10 +82,20 @@ class sv4guiPurkinjeNetwork1DContainer : public mitk::BaseData {
 
     std::vector<double> hoverPoint = std::vector<double>();
 
-    void SetSurfaceNetworkMesh(sv4guiMesh* mesh);
-    sv4guiMesh* GetSurfaceNetworkMesh();
-    bool IsNewSurfaceNetworkMesh();
-    void SetNewSurfaceNetworkMesh(bool value);
+    void SetNetwork(const sv4guiPurkinjeNetworkGraph& network);
+    const sv4guiPurkinjeNetworkGraph& GetNetwork() const { return m_Network; }
+    void ApplyChange(const sv4guiPurkinjeNetworkGraph::Change& change, bool undo=false);
+    unsigned long GetNetworkID() const { return m_NetworkID; }
+    virtual void ExecuteOperation(mitk::Operation* operation) override;
+    vtkSmartPointer<vtkPolyData> GetNetworkPolyData();
+    const sv4guiPurkinjeNetworkSegmentTree& GetSegmentTree();
+
+    const std::vector<sv4guiPurkinjeNetworkGraph::Branch>& GetBranches() const { return m_Branches; }
+    const std::vector<int>& GetBranchGenerations() const { return m_BranchGenerations; }
+
+    bool FindNetworkElement(const double start[3], const double end[3], double tolerance, NetworkElement& element);
+    void SetSelectedNetworkElement(const NetworkElement& element) { m_SelectedNetworkElement = element; }
+    const NetworkElement& GetSelectedNetworkElement() const { return m_SelectedNetworkElement; }
 
 protected:
 
@@ -82,9 +108,32 @@ private:
 
   std::vector< std::vector<double> > m_startSeeds;
   std::vector< std::vector< std::vector<double> > > m_endSeeds;
-  sv4guiMesh* m_SurfaceNetworkMesh;
-  bool m_NewSurfaceNetworkMesh;
+  sv4guiPurkinjeNetworkGraph m_Network;
+  vtkSmartPointer<vtkPolyData> m_NetworkPolyData;
+
+  // Changed each time the network is replaced so edits of a previous 
+  // network are not applied to it.
+  unsigned long m_NetworkID = 0;
+
+  // The segment tree is built on demand when the network changes.
+  sv4guiPurkinjeNetworkSegmentTree m_SegmentTree;
+  bool m_SegmentTreeValid = false;
+
+  // Branches and the branch and position along it of each segment, -1 for 
+  // segments that are not part of a branch.
+  std::vector<sv4guiPurkinjeNetworkGraph::Branch> m_Branches;
+  std::vector<int> m_BranchGenerations;
+  std::vector<int> m_SegmentBranches;
+  std::vector<int> m_SegmentBranchPositions;
+
+  NetworkElement m_SelectedNetworkElement;
+
+  void UpdateNetworkData();
 
 };
 
+itkEventMacro( sv4guiPurkinjeNetwork1DEvent, itk::AnyEvent);
+itkEventMacro( sv4guiPurkinjeNetwork1DSelectElementEvent, sv4guiPurkinjeNetwork1DEvent);
+itkEventMacro( sv4guiPurkinjeNetwork1DChangeEvent, sv4guiPurkinjeNetwork1DEvent);
+
 #endif //SV4GUI_PURKINJENETWORK_1D_CONTAINER_H
@@ -34,7 +34,12 @@
 #include "vtkPolyDataMapper.h"
 #include "vtkSphereSource.h"
 #include "vtkCubeSource.h"
-#include <vtkDataSetMapper.h>
+
+#include "mitkRenderingManager.h"
+
+#include <vtkCellData.h>
+#include <vtkIdList.h>
+#include <vtkIntArray.h>
 
 sv4guiPurkinjeNetwork1DMapper::sv4guiPurkinjeNetwork1DMapper()
 {
@@ -84,50 +89,184 @@ void sv4guiPurkinjeNetwork1DMapper::GenerateDataForRenderer(mitk::BaseRenderer*
     return;
   }
 
-  // [DaveP] Do we need to remove?
-  // local_storage->m_PropAssembly->GetParts()->RemoveAllItems();
-
   // Show network mesh.
   //
-  auto surfaceNetwork = mesh->GetSurfaceNetworkMesh();
-  auto newMesh = mesh->IsNewSurfaceNetworkMesh();
-
-  if ((surfaceNetwork != nullptr) && newMesh) {
-    local_storage->m_PropAssembly->GetParts()->RemoveAllItems();
-    //MITK_INFO << msgPrefix << "Have surface network data ";
-    auto volumeMesh = surfaceNetwork->GetVolumeMesh();
-    if (volumeMesh == nullptr) {
-        MITK_WARN << "No volume mesh.";
-        return;
-     }
-    //MITK_INFO << msgPrefix << "Have volume mesh.";
-    vtkSmartPointer<vtkDataSetMapper> meshMapper = vtkSmartPointer<vtkDataSetMapper>::New();
-    meshMapper->SetInputData(volumeMesh);
-    vtkSmartPointer<vtkActor> polyMeshActor = vtkSmartPointer<vtkActor>::New();
-    polyMeshActor->SetMapper(meshMapper);
-    polyMeshActor->GetProperty()->SetColor(0.8,0,0);
-    polyMeshActor->GetProperty()->SetLineWidth(1.5);
-    local_storage->m_PropAssembly->AddPart(polyMeshActor);
+  // The network actor of this renderer is recreated only when the 
+  // shared render data has changed.
+  //
+  if (!updateRenderData(mesh)) {
+    local_storage->m_PropAssembly->VisibilityOff();
+    return;
+  }
+
+  if (local_storage->m_RenderDataMTime != m_RenderDataMTime) {
+    for (auto& actor : local_storage->m_LevelActors) {
+      local_storage->m_PropAssembly->RemovePart(actor);
+    }
+    local_storage->m_LevelActors.clear();
+
+    for (auto& levelData : m_NetworkLevels) {
+      vtkSmartPointer<vtkOpenGLPolyDataMapper> meshMapper = vtkSmartPointer<vtkOpenGLPolyDataMapper>::New();
+      meshMapper->SetInputData(levelData);
+      meshMapper->ScalarVisibilityOff();
+      vtkSmartPointer<vtkActor> polyMeshActor = vtkSmartPointer<vtkActor>::New();
+      polyMeshActor->SetMapper(meshMapper);
+      polyMeshActor->GetProperty()->SetColor(0.8,0,0);
+      polyMeshActor->GetProperty()->SetLineWidth(1.5);
+      local_storage->m_PropAssembly->AddPart(polyMeshActor);
+      local_storage->m_LevelActors.push_back(polyMeshActor);
+    }
+    local_storage->m_RenderDataMTime = m_RenderDataMTime;
+  }
+
+  // Select the level of detail to show. 
+  //
+  // The rendering manager renders at LOD 0 while the view is being 
+  // interacted with and then requests a refinement render at a higher 
+  // LOD, so the coarsest level is shown during interaction and full 
+  // detail is restored when it stops.
+  //
+  int level = 0;
+  if (mitk::RenderingManager::GetInstance()->GetNextLOD(renderer) == 0) {
+    level = local_storage->m_LevelActors.size() - 1;
+  }
+
+  for (int i = 0; i < local_storage->m_LevelActors.size(); i++) {
+    local_storage->m_LevelActors[i]->SetVisibility(i == level);
   }
 
-  mesh->SetNewSurfaceNetworkMesh(false);
   local_storage->m_PropAssembly->VisibilityOn();
 }
 
+//------------------
+// updateRenderData
+//------------------
+// Update the network render data shared by all renderers.
+//
+// The data is only updated when the modification time of the container 
+// changes, which happens when a new network is set. 
+//
+// A pyramid of coarser levels is created for large networks. Each level 
+// keeps every 4th node of the polylines of the previous level and drops 
+// the branches of the highest remaining generations. Levels are added until 
+// the number of segments is below m_InteractiveNumSegments so the cost of 
+// rendering during interaction does not depend on the size of the network.
+//
+bool sv4guiPurkinjeNetwork1DMapper::updateRenderData(sv4guiPurkinjeNetwork1DContainer* mesh)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetwork1DMapper::updateRenderData] ";
+
+  if (mesh->GetMTime() == m_RenderDataMTime) {
+    return m_NetworkLevels.size() != 0;
+  }
+  m_RenderDataMTime = mesh->GetMTime();
+  m_NetworkLevels.clear();
+
+  auto network = mesh->GetNetworkPolyData();
+  if (network == nullptr) {
+    return false;
+  }
+  m_NetworkLevels.push_back(network);
+
+  int maxGeneration = 0;
+  auto generations = vtkIntArray::SafeDownCast(network->GetCellData()->GetArray("BranchGeneration"));
+  if (generations != nullptr) {
+    for (vtkIdType i = 0; i < generations->GetNumberOfTuples(); i++) {
+      maxGeneration = std::max(maxGeneration, generations->GetValue(i));
+    }
+  }
+  int generationStep = std::max(1, (maxGeneration + 1) / m_MaxNumLevels);
+
+  // The number of segments of polylines, each cell stores its number of points
+  // followed by its point IDs.
+  auto numSegments = [](vtkPolyData* polyData) -> vtkIdType {
+    auto lines = polyData->GetLines();
+    return lines->GetNumberOfConnectivityEntries() - 2*lines->GetNumberOfCells();
+  };
+
+  auto levelData = network;
+  int stride = 1;
+  int generation = maxGeneration;
+
+  while ((numSegments(levelData) > m_InteractiveNumSegments) && (m_NetworkLevels.size() < m_MaxNumLevels)) {
+    stride *= 4;
+    generation = std::max(0, generation - generationStep);
+    levelData = createLevel(network, stride, generation);
+    m_NetworkLevels.push_back(levelData);
+  }
+
+  MITK_INFO << msgPrefix << "Number of levels of detail: " << m_NetworkLevels.size();
+  return true;
+}
+
+//-------------
+// createLevel
+//-------------
+// Create a coarse level of the network.
+//
+// Branches with a generation larger than 'maxGeneration' are removed and every 
+// 'stride' node is kept along the remaining branch polylines. The end nodes of 
+// branches are always kept so the level remains connected. The level shares 
+// the points of the network.
+//
+vtkSmartPointer<vtkPolyData> 
+sv4guiPurkinjeNetwork1DMapper::createLevel(vtkPolyData* network, int stride, int maxGeneration)
+{
+  auto generations = vtkIntArray::SafeDownCast(network->GetCellData()->GetArray("BranchGeneration"));
+  auto lines = vtkSmartPointer<vtkCellArray>::New();
+  auto cellIds = vtkSmartPointer<vtkIdList>::New();
+  auto levelIds = vtkSmartPointer<vtkIdList>::New();
+
+  for (vtkIdType cellId = 0; cellId < network->GetNumberOfCells(); cellId++) {
+    if ((generations != nullptr) && (generations->GetValue(cellId) > maxGeneration)) {
+      continue;
+    }
+    network->GetCellPoints(cellId, cellIds);
+    vtkIdType numIds = cellIds->GetNumberOfIds();
+    if (numIds < 2) {
+      continue;
+    }
+    levelIds->Reset();
+    for (vtkIdType i = 0; i < numIds - 1; i += stride) {
+      levelIds->InsertNextId(cellIds->GetId(i));
+    }
+    levelIds->InsertNextId(cellIds->GetId(numIds-1));
+    lines->InsertNextCell(levelIds);
+  }
+
+  auto levelData = vtkSmartPointer<vtkPolyData>::New();
+  levelData->SetPoints(network->GetPoints());
+  levelData->SetLines(lines);
+  return levelData;
+}
+
+//--------------
+// IsLODEnabled
+//--------------
+// Level of detail rendering is enabled when coarser levels have been created.
+//
+bool sv4guiPurkinjeNetwork1DMapper::IsLODEnabled(mitk::BaseRenderer* renderer) const
+{
+  return m_NetworkLevels.size() > 1;
+}
+
 void sv4guiPurkinjeNetwork1DMapper::ResetMapper(mitk::BaseRenderer* renderer)
 {
   LocalStorage *ls = m_LSH.GetLocalStorage(renderer);
   ls->m_PropAssembly->VisibilityOff();
 }
 
+//------------
+// GetVtkProp
+//------------
+// Get the prop assembly for a renderer. It is updated by GenerateDataForRenderer().
+//
 vtkProp* sv4guiPurkinjeNetwork1DMapper::GetVtkProp(mitk::BaseRenderer* renderer)
 {
   if (renderer == nullptr) {
     return nullptr;
   }
   //MITK_INFO << "[sv4guiPurkinjeNetwork1DMapper::GetVtkProp] ";
-  ResetMapper(renderer);
-  GenerateDataForRenderer(renderer);
   LocalStorage *ls = m_LSH.GetLocalStorage(renderer);
   return ls->m_PropAssembly;
 }
@@ -46,7 +46,11 @@
 #include <vtkActor.h>
 #include <vtkSmartPointer.h>
 #include <vtkActor.h>
+#include <vtkPolyData.h>
 #include <string>
+#include <vector>
+
+class sv4guiPurkinjeNetwork1DContainer;
 
 class sv4guiPurkinjeNetwork1DMapper : public mitk::VtkMapper
 {
@@ -61,13 +65,18 @@ public:
     {
     public:
         vtkSmartPointer<vtkAssembly> m_PropAssembly;
+        // One actor per level of detail, level 0 is full detail.
+        std::vector<vtkSmartPointer<vtkActor>> m_LevelActors;
+        unsigned long m_RenderDataMTime;
         LocalStorage() {
             m_PropAssembly = vtkSmartPointer<vtkAssembly>::New();
+            m_RenderDataMTime = 0;
         }
         ~LocalStorage() { }
     };
 
     virtual vtkProp *GetVtkProp(mitk::BaseRenderer *renderer) override;
+    virtual bool IsLODEnabled(mitk::BaseRenderer* renderer) const override;
 
     mitk::LocalStorageHandler<LocalStorage> m_LSH;
 
@@ -85,6 +94,20 @@ protected:
     virtual ~sv4guiPurkinjeNetwork1DMapper();
     virtual void GenerateDataForRenderer(mitk::BaseRenderer* renderer) override;
     virtual void ResetMapper( mitk::BaseRenderer* renderer ) override;
+
+    bool updateRenderData(sv4guiPurkinjeNetwork1DContainer* mesh);
+    vtkSmartPointer<vtkPolyData> createLevel(vtkPolyData* network, int stride, int maxGeneration);
+
+    // Render data shared by all renderers, rebuilt when the container is modified.
+    //
+    // m_NetworkLevels[0] is the full network, the following levels are 
+    // increasingly coarse and are shown while the view is being interacted with.
+    std::vector<vtkSmartPointer<vtkPolyData>> m_NetworkLevels;
+    unsigned long m_RenderDataMTime = 0;
+
+    // The number of segments below which no coarser level is created.
+    static const vtkIdType m_InteractiveNumSegments = 50000;
+    static const int m_MaxNumLevels = 4;
 };
 
 #endif /* SV4GUIPURKINJENETWORK_NETWORK_MAPPER_H */
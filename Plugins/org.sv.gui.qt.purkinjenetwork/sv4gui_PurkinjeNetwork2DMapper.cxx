@@ -0,0 +1,239 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sv4gui_PurkinjeNetwork2DMapper.h"
+#include "sv4gui_PurkinjeNetwork1DContainer.h"
+
+#include "mitkPlaneGeometry.h"
+
+#if VTK_MAJOR_VERSION == 6
+    #include <vtkPainterPolyDataMapper.h>
+#else
+    #include <vtkOpenGLPolyDataMapper.h>
+#endif
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkProperty.h>
+
+#include <cmath>
+
+sv4guiPurkinjeNetwork2DMapper::sv4guiPurkinjeNetwork2DMapper()
+{
+}
+
+sv4guiPurkinjeNetwork2DMapper::~sv4guiPurkinjeNetwork2DMapper()
+{
+}
+
+//-------------------------
+// GenerateDataForRenderer
+//-------------------------
+// Generate the network slice displayed in the renderer.
+//
+// The slab half-width is half of the slice thickness so each segment is 
+// shown in the slices it passes through. 
+//
+void sv4guiPurkinjeNetwork2DMapper::GenerateDataForRenderer(mitk::BaseRenderer* renderer)
+{
+  mitk::DataNode* node = GetDataNode();
+  if (node == nullptr) {
+    return;
+  }
+  LocalStorage* local_storage = m_LSH.GetLocalStorage(renderer);
+  if (local_storage == nullptr) {
+    return;
+  }
+
+  bool visible = true;
+  node->GetVisibility(visible, renderer, "visible");
+  if (!visible) {
+    local_storage->m_PropAssembly->VisibilityOff();
+    return;
+  }
+
+  auto network = static_cast<sv4guiPurkinjeNetwork1DContainer*>(node->GetData());
+  const mitk::PlaneGeometry* planeGeometry = renderer->GetCurrentWorldPlaneGeometry();
+  if ((network == nullptr) || (planeGeometry == nullptr) || (network->GetNetwork().GetNumberOfSegments() == 0)) {
+    local_storage->m_PropAssembly->VisibilityOff();
+    return;
+  }
+
+  double origin[3], normal[3];
+  auto planeOrigin = planeGeometry->GetOrigin();
+  auto planeNormal = planeGeometry->GetNormal();
+  double norm = std::sqrt(planeNormal[0]*planeNormal[0] + planeNormal[1]*planeNormal[1] + planeNormal[2]*planeNormal[2]);
+  if (norm == 0.0) {
+    local_storage->m_PropAssembly->VisibilityOff();
+    return;
+  }
+  for (int i = 0; i < 3; i++) {
+    origin[i] = planeOrigin[i];
+    normal[i] = planeNormal[i] / norm;
+  }
+
+  double distance = 0.5 * planeGeometry->GetExtentInMM(2);
+  if (distance <= 0.0) {
+    distance = 0.5;
+  }
+
+  auto sliceData = getSliceData(network, origin, normal, distance);
+
+  if (local_storage->m_SliceData != sliceData) {
+    if (local_storage->m_SliceActor == nullptr) {
+      auto mapper = vtkSmartPointer<vtkOpenGLPolyDataMapper>::New();
+      mapper->ScalarVisibilityOff();
+      auto actor = vtkSmartPointer<vtkActor>::New();
+      actor->SetMapper(mapper);
+      actor->GetProperty()->SetColor(0.8,0,0);
+      actor->GetProperty()->SetLineWidth(1.5);
+      actor->GetProperty()->SetPointSize(5.0);
+      local_storage->m_PropAssembly->AddPart(actor);
+      local_storage->m_SliceActor = actor;
+      local_storage->m_SliceMapper = mapper;
+    }
+    local_storage->m_SliceMapper->SetInputData(sliceData);
+    local_storage->m_SliceData = sliceData;
+  }
+
+  local_storage->m_PropAssembly->VisibilityOn();
+}
+
+//--------------
+// getSliceData
+//--------------
+// Get the network slice for a plane from the cache, creating it if needed.
+//
+vtkSmartPointer<vtkPolyData> sv4guiPurkinjeNetwork2DMapper::getSliceData(sv4guiPurkinjeNetwork1DContainer* network, 
+    const double origin[3], const double normal[3], double distance)
+{
+  if (network->GetMTime() != m_SliceCacheMTime) {
+    m_SliceCache.clear();
+    m_SliceCacheMTime = network->GetMTime();
+  }
+
+  double offset = normal[0]*origin[0] + normal[1]*origin[1] + normal[2]*origin[2];
+  const double scale = 1.0e6;
+  SliceKey key = { std::llround(scale*normal[0]), std::llround(scale*normal[1]), std::llround(scale*normal[2]), 
+                   std::llround(scale*offset), std::llround(scale*distance) };
+
+  auto it = m_SliceCache.find(key);
+  if (it != m_SliceCache.end()) {
+    return it->second;
+  }
+
+  if (m_SliceCache.size() >= m_MaxNumCachedSlices) {
+    m_SliceCache.clear();
+  }
+
+  auto sliceData = createSliceData(network, origin, normal, distance);
+  m_SliceCache[key] = sliceData;
+  return sliceData;
+}
+
+//-----------------
+// createSliceData
+//-----------------
+// Create the network slice for a plane.
+//
+// Segments within 'distance' of the plane are projected onto it and drawn 
+// as lines, segments crossing the plane add a vertex at the crossing point.
+//
+vtkSmartPointer<vtkPolyData> sv4guiPurkinjeNetwork2DMapper::createSliceData(sv4guiPurkinjeNetwork1DContainer* network, 
+    const double origin[3], const double normal[3], double distance)
+{
+  const auto& graph = network->GetNetwork();
+  const auto& nodes = graph.GetNodes();
+  const auto& graphSegments = graph.GetSegments();
+
+  std::vector<int> segments;
+  network->GetSegmentTree().FindSegmentsNearPlane(origin, normal, distance, segments);
+
+  auto points = vtkSmartPointer<vtkPoints>::New();
+  auto lines = vtkSmartPointer<vtkCellArray>::New();
+  auto verts = vtkSmartPointer<vtkCellArray>::New();
+
+  for (auto segment : segments) {
+    const auto& p1 = nodes[graphSegments[segment][0]];
+    const auto& p2 = nodes[graphSegments[segment][1]];
+    double dist1 = 0.0, dist2 = 0.0;
+    for (int j = 0; j < 3; j++) {
+      dist1 += normal[j] * (p1[j] - origin[j]);
+      dist2 += normal[j] * (p2[j] - origin[j]);
+    }
+
+    double q1[3], q2[3];
+    for (int j = 0; j < 3; j++) {
+      q1[j] = p1[j] - dist1 * normal[j];
+      q2[j] = p2[j] - dist2 * normal[j];
+    }
+    vtkIdType id1 = points->InsertNextPoint(q1);
+    vtkIdType id2 = points->InsertNextPoint(q2);
+    lines->InsertNextCell(2);
+    lines->InsertCellPoint(id1);
+    lines->InsertCellPoint(id2);
+
+    if ((dist1 * dist2 <= 0.0) && (dist1 != dist2)) {
+      double t = dist1 / (dist1 - dist2);
+      double crossing[3];
+      for (int j = 0; j < 3; j++) {
+        crossing[j] = q1[j] + t * (q2[j] - q1[j]);
+      }
+      verts->InsertNextCell(1);
+      verts->InsertCellPoint(points->InsertNextPoint(crossing));
+    }
+  }
+
+  auto sliceData = vtkSmartPointer<vtkPolyData>::New();
+  sliceData->SetPoints(points);
+  sliceData->SetLines(lines);
+  sliceData->SetVerts(verts);
+  return sliceData;
+}
+
+void sv4guiPurkinjeNetwork2DMapper::ResetMapper(mitk::BaseRenderer* renderer)
+{
+  LocalStorage *ls = m_LSH.GetLocalStorage(renderer);
+  ls->m_PropAssembly->VisibilityOff();
+}
+
+//------------
+// GetVtkProp
+//------------
+// Get the prop assembly for a renderer. It is updated by GenerateDataForRenderer().
+//
+vtkProp* sv4guiPurkinjeNetwork2DMapper::GetVtkProp(mitk::BaseRenderer* renderer)
+{
+  if (renderer == nullptr) {
+    return nullptr;
+  }
+  LocalStorage *ls = m_LSH.GetLocalStorage(renderer);
+  return ls->m_PropAssembly;
+}
@@ -0,0 +1,108 @@
+/* Copyright (c) Stanford University, The Regents of the University of
+ *               California, and others.
+ *
+ * All Rights Reserved.
+ *
+ * See Copyright-SimVascular.txt for additional details.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// This mapper displays the 1D network in the 2D slice views.
+//
+// The network segments within a slab around the slice plane are found using 
+// the network segment tree and are projected onto the plane. The points where 
+// segments cross the plane are shown as points. 
+//
+// Slices are cached by plane position so scrolling back to a slice does not 
+// query the segment tree again. The cache is shared by all renderers and is 
+// cleared when the network changes.
+
+#ifndef SV4GUIPURKINJENETWORK_2D_MAPPER_H
+#define SV4GUIPURKINJENETWORK_2D_MAPPER_H
+
+#include "mitkVtkMapper.h"
+#include "mitkBaseRenderer.h"
+#include "mitkLocalStorageHandler.h"
+
+#include <vtkActor.h>
+#include <vtkAssembly.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataMapper.h>
+#include <vtkSmartPointer.h>
+
+#include <array>
+#include <map>
+
+class sv4guiPurkinjeNetwork1DContainer;
+
+class sv4guiPurkinjeNetwork2DMapper : public mitk::VtkMapper
+{
+public:
+
+    mitkClassMacro(sv4guiPurkinjeNetwork2DMapper, mitk::VtkMapper);
+
+    itkFactorylessNewMacro(Self)
+    itkCloneMacro(Self)
+
+    class LocalStorage : public mitk::Mapper::BaseLocalStorage
+    {
+    public:
+        vtkSmartPointer<vtkAssembly> m_PropAssembly;
+        vtkSmartPointer<vtkActor> m_SliceActor;
+        vtkSmartPointer<vtkPolyDataMapper> m_SliceMapper;
+        vtkSmartPointer<vtkPolyData> m_SliceData;
+        LocalStorage() {
+            m_PropAssembly = vtkSmartPointer<vtkAssembly>::New();
+        }
+        ~LocalStorage() { }
+    };
+
+    virtual vtkProp *GetVtkProp(mitk::BaseRenderer *renderer) override;
+
+    mitk::LocalStorageHandler<LocalStorage> m_LSH;
+
+protected:
+
+    sv4guiPurkinjeNetwork2DMapper();
+
+    virtual ~sv4guiPurkinjeNetwork2DMapper();
+    virtual void GenerateDataForRenderer(mitk::BaseRenderer* renderer) override;
+    virtual void ResetMapper( mitk::BaseRenderer* renderer ) override;
+
+    vtkSmartPointer<vtkPolyData> getSliceData(sv4guiPurkinjeNetwork1DContainer* network, 
+        const double origin[3], const double normal[3], double distance);
+
+    vtkSmartPointer<vtkPolyData> createSliceData(sv4guiPurkinjeNetwork1DContainer* network, 
+        const double origin[3], const double normal[3], double distance);
+
+    // Slices are identified by their quantized normal, plane offset and slab distance.
+    typedef std::array<long long,5> SliceKey;
+    std::map<SliceKey, vtkSmartPointer<vtkPolyData>> m_SliceCache;
+    unsigned long m_SliceCacheMTime = 0;
+
+    static const int m_MaxNumCachedSlices = 512;
+};
+
+#endif /* SV4GUIPURKINJENETWORK_2D_MAPPER_H */
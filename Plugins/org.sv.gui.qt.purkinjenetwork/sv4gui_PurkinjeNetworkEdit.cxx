@@ -62,23 +62,31 @@
 
 #include <QmitkStdMultiWidgetEditor.h>
 #include <mitkNodePredicateDataType.h>
+#include <mitkOperationEvent.h>
 #include <mitkUndoController.h>
 #include <mitkSliceNavigationController.h>
 #include <mitkProgressBar.h>
 #include <mitkStatusBar.h>
+#include <mitkSurface.h>
 
 #include <usModuleRegistry.h>
 
 #include <vtkProperty.h>
+#include <vtkPointData.h>
+#include <vtkXMLPolyDataReader.h>
 #include <vtkXMLUnstructuredGridReader.h>
 
 #include "sv4gui_PurkinjeNetworkIO.h"
 
 #include <QMessageBox>
+#include <QAbstractSpinBox>
+#include <QComboBox>
 #include <QInputDialog>
 #include <QFileDialog>
+#include <QDir>
 
 #include <iostream>
+#include <memory>
 using namespace std;
 
 const QString sv4guiPurkinjeNetworkEdit::EXTENSION_ID = "org.sv.views.purkinjenetwork";
@@ -93,6 +101,9 @@ sv4guiPurkinjeNetworkEdit::sv4guiPurkinjeNetworkEdit() : ui(new Ui::sv4guiPurkin
   m_MeshMapper = nullptr;
   m_MeshSelectFaceObserverTag = -1;
   m_MeshSelectStartPointObserverTag = -1;
+  m_NetworkSelectElementObserverTag = -1;
+  m_NetworkChangeObserverTag = -1;
+  m_ParameterChangeObserverTag = -1;
   m_ModelFolderNode = nullptr; 
   m_Parent = nullptr;
   m_PurkinjeNetworkNode = nullptr;
@@ -152,8 +163,30 @@ void sv4guiPurkinjeNetworkEdit::CreateQtPartControl(QWidget* parent )
     connect(ui->secondPointZLineEdit, SIGNAL(returnPressed()), this, SLOT(MeshSurfaceSecondPoint()));
 
     connect(ui->buttonCreateNetwork, SIGNAL(clicked()), this, SLOT(CreateNetwork()));
+    connect(ui->buttonCompleteNetwork, SIGNAL(clicked()), this, SLOT(CompleteNetwork()));
+    connect(ui->buttonPreviewNetwork, SIGNAL(clicked()), this, SLOT(PreviewNetwork()));
+    connect(ui->buttonRegrowBranch, SIGNAL(clicked()), this, SLOT(RegrowBranch()));
+    connect(ui->buttonRemoveBranch, SIGNAL(clicked()), this, SLOT(RemoveBranch()));
+    connect(ui->buttonMoveNode, SIGNAL(clicked()), this, SLOT(MoveNode()));
+    connect(ui->numBranchGenSpinBox, SIGNAL(editingFinished()), this, SLOT(UpdatePreview()));
+    connect(ui->avgBranchLengthSpinBox, SIGNAL(editingFinished()), this, SLOT(UpdatePreview()));
+    connect(ui->branchAngleSpinBox, SIGNAL(editingFinished()), this, SLOT(UpdatePreview()));
+    connect(ui->repulsiveParameterSpinBox, SIGNAL(editingFinished()), this, SLOT(UpdatePreview()));
+    connect(ui->branchSegLengthSpinBox, SIGNAL(editingFinished()), this, SLOT(UpdatePreview()));
     connect(ui->networkCheckBox, SIGNAL(clicked(bool)), this, SLOT(showNetwork(bool)));
 
+    // Record parameter edits made by the user. Setting widget values from 
+    // code does not emit these signals.
+    for (auto spinBox : parent->findChildren<QAbstractSpinBox*>()) {
+      connect(spinBox, SIGNAL(editingFinished()), this, SLOT(RecordParameterChange()));
+    }
+    for (auto comboBox : parent->findChildren<QComboBox*>()) {
+      if (comboBox != ui->selectMeshComboBox) {
+        connect(comboBox, SIGNAL(activated(int)), this, SLOT(RecordParameterChange()));
+      }
+    }
+    connect(ui->activationSourcesLineEdit, SIGNAL(editingFinished()), this, SLOT(RecordParameterChange()));
+
     m_Interface = new sv4guiDataNodeOperationInterface();
 
     if (m_init){
@@ -202,11 +235,22 @@ void sv4guiPurkinjeNetworkEdit::CreateQtPartControl(QWidget* parent )
         m_1DMapper->m_box = false;
         m_1DNode->SetMapper(mitk::BaseRenderer::Standard3D, m_1DMapper);
 
+        m_2DMapper = sv4guiPurkinjeNetwork2DMapper::New();
+        m_2DMapper->SetDataNode(node);
+        m_1DNode->SetMapper(mitk::BaseRenderer::Standard2D, m_2DMapper);
+
         // Create interactor to select mesh point.
         m_MeshInteractor = sv4guiPurkinjeNetworkInteractor::New();
         m_MeshInteractor->LoadStateMachine("meshInteraction.xml", us::ModuleRegistry::GetModule("sv4guiModulePurkinjeNetwork"));
         m_MeshInteractor->SetEventConfig("meshConfig.xml", us::ModuleRegistry::GetModule("sv4guiModulePurkinjeNetwork"));
         m_MeshInteractor->SetDataNode(meshNode);
+        m_MeshInteractor->SetNetworkContainer(m_1DContainer);
+
+        // Store the initial parameter values.
+        m_NetworkParameters = sv4guiPurkinjeNetwork::New();
+        for (const auto& param : GetRecordedParameters()) {
+          m_NetworkParameters->SetProp(param.first, param.second);
+        }
 
         // Set visibility of Model data node.
         mitk::DataNode::Pointer model_folder_node = GetDataStorage()->GetNamedNode("Models");
@@ -493,14 +537,11 @@ void sv4guiPurkinjeNetworkEdit::SetMeshInformation()
     MITK_INFO << msgPrefix << "Number of model faces " << faces.size();
     for (const auto& face : faces) { 
       MITK_INFO << msgPrefix << "Face id " << face->id << " name '" << face->name << "'";
-      int faceID = modelElement->GetFaceIdentifierFromInnerSolid(face->id);
-      vtkSmartPointer<vtkPolyData> facePolyData = vtkSmartPointer<vtkPolyData>::New();
-      PlyDtaUtils_GetFacePolyData(geom, &faceID, facePolyData);
-      MITK_INFO << msgPrefix << "   Num tri  " << facePolyData->GetNumberOfCells();
-      MITK_INFO << msgPrefix << "   Face ptr " << facePolyData;
     }
 
+    // Partition the surface mesh into faces, shared with the mesh mapper.
     m_MeshContainer->SetModelFaces(faces);
+    m_MeshContainer->GetFacesPolyData();
   }
 
   mitk::RenderingManager::GetInstance()->RequestUpdateAll();
@@ -522,6 +563,22 @@ mitk::DataNode::Pointer sv4guiPurkinjeNetworkEdit::GetMeshFolderDataNode()
   return meshFolderNode;
 }
 
+// ------------------
+//  GetImageFileName 
+// ------------------
+// Get the name of the first image file (.vti or .mha) in the project 
+// Images directory. An empty string is returned if there are no images.
+
+std::string sv4guiPurkinjeNetworkEdit::GetImageFileName(const std::string& projPath)
+{
+  QDir imageDir(QString::fromStdString(projPath) + "/Images");
+  auto files = imageDir.entryList(QStringList() << "*.vti" << "*.mha", QDir::Files, QDir::Name);
+  if (files.isEmpty()) {
+    return "";
+  }
+  return imageDir.filePath(files[0]).toStdString();
+}
+
 // -----------------------
 //  GetModelFolderDataNode 
 // -----------------------
@@ -583,7 +640,307 @@ mitk::DataNode::Pointer sv4guiPurkinjeNetworkEdit::getProjectNode()
 //
 void sv4guiPurkinjeNetworkEdit::CreateNetwork()
 {
-  std::string msgPrefix = "[sv4guiPurkinjeNetworkEdit::CreateNetwork] ";
+  GenerateNetwork(GenerateMode::Create);
+}
+
+//-----------------
+// CompleteNetwork 
+//-----------------
+// Grow the remaining branch generations of a network whose 
+// generation was stopped by the time budget.
+//
+void sv4guiPurkinjeNetworkEdit::CompleteNetwork()
+{
+  GenerateNetwork(GenerateMode::Complete);
+}
+
+//----------------
+// PreviewNetwork 
+//----------------
+// Grow a coarse preview of a Purkinje Network on a decimated surface.
+//
+void sv4guiPurkinjeNetworkEdit::PreviewNetwork()
+{
+  GenerateNetwork(GenerateMode::Preview);
+}
+
+//--------------
+// RegrowBranch 
+//--------------
+// Remove the subtree below the selected network branch and regrow it 
+// using the current growth parameters. 
+//
+void sv4guiPurkinjeNetworkEdit::RegrowBranch()
+{
+  EditBranch(EditMode::Regrow);
+}
+
+//--------------
+// RemoveBranch 
+//--------------
+// Remove the selected network branch and the subtree below it.
+//
+void sv4guiPurkinjeNetworkEdit::RemoveBranch()
+{
+  EditBranch(EditMode::Remove);
+}
+
+//------------
+// EditBranch 
+//------------
+// Edit the network at the selected branch.
+//
+// Only the nodes and segments of the subtree below the branch are 
+// changed. The edit is stored as the change made to the network and 
+// can be undone and redone using the MITK undo controller.
+//
+void sv4guiPurkinjeNetworkEdit::EditBranch(EditMode mode)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkEdit::EditBranch] ";
+  MITK_INFO << msgPrefix; 
+
+  auto element = m_1DContainer->GetSelectedNetworkElement();
+  if (element.branch == -1) {
+    QMessageBox::warning(m_Parent, "No network branch selected", 
+        "A network branch must be selected. Press N with the cursor over a branch to select it.");
+    return;
+  }
+
+  if (!m_MeshContainer->HaveSelectedFace()) {
+    QMessageBox::warning(m_Parent, "No mesh face selected", "A mesh face must be selected.");
+    return;
+  }
+  auto faceName = m_MeshContainer->GetSelectedFaceName();
+  MITK_INFO << msgPrefix << "Face name " << faceName << "  branch " << element.branch;
+
+  if ((m_NetworkFaceName != "") && (faceName != m_NetworkFaceName)) {
+    QMessageBox::warning(m_Parent, "Purkinje Network Tool", 
+        "The network was generated for the face " + QString::fromStdString(m_NetworkFaceName) + ".");
+    return;
+  }
+
+  std::array<double,3> firstPoint, secondPoint;
+  m_MeshContainer->GetNetworkPoints(firstPoint, secondPoint);
+  sv4guiPurkinjeNetworkModel pnetModel(faceName, firstPoint, secondPoint);
+  auto params = GetParametersFromGui();
+  pnetModel.SetParameters(params);
+  SetModelMesh(pnetModel);
+
+  auto change = std::make_shared<sv4guiPurkinjeNetworkGraph::Change>();
+  const auto& network = m_1DContainer->GetNetwork();
+  const auto& branch = m_1DContainer->GetBranches()[element.branch];
+  std::string description;
+  bool status;
+  if (mode == EditMode::Regrow) {
+    description = "Regrow Branch";
+    status = pnetModel.RegrowBranch(network, m_1DContainer->GetSegmentTree(), branch, *change);
+  } else {
+    description = "Remove Branch";
+    status = pnetModel.RemoveBranch(network, branch, *change);
+  }
+
+  if (!status) {
+    QMessageBox::warning(QApplication::activeWindow(), "Purkinje Network Tool", "Editing the network branch failed.");
+    return;
+  }
+
+  ExecuteNetworkChange(change, description);
+}
+
+//----------
+// MoveNode 
+//----------
+// Move the node of the selected network branch closest to the cursor 
+// to the picked surface point. 
+//
+// Only the position of the node is changed, the move can be undone 
+// and redone using the MITK undo controller.
+//
+void sv4guiPurkinjeNetworkEdit::MoveNode()
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkEdit::MoveNode] ";
+  MITK_INFO << msgPrefix; 
+
+  auto element = m_1DContainer->GetSelectedNetworkElement();
+  if (element.node == -1) {
+    QMessageBox::warning(m_Parent, "No network node selected", 
+        "A network node must be selected. Press N with the cursor near the node to select it.");
+    return;
+  }
+
+  if (!m_MeshContainer->PickedPointIsValid()) {
+    QMessageBox::warning(m_Parent, "No surface point picked", 
+        "A point on the selected mesh face must be picked. Press Ctrl and the left mouse button to pick a point.");
+    return;
+  }
+
+  auto pickedPoint = m_MeshContainer->GetPickedPoint();
+  sv4guiPurkinjeNetworkGraph::Point point = {pickedPoint[0], pickedPoint[1], pickedPoint[2]};
+  MITK_INFO << msgPrefix << "Node " << element.node << "  point " << point[0] << " " << point[1] << " " << point[2];
+
+  auto change = std::make_shared<sv4guiPurkinjeNetworkGraph::Change>();
+  m_1DContainer->GetNetwork().CreateMoveNodeChange(element.node, point, *change);
+  ExecuteNetworkChange(change, "Move Node");
+}
+
+//----------------------
+// ExecuteNetworkChange 
+//----------------------
+// Apply a network edit and add it to the MITK undo controller.
+//
+void sv4guiPurkinjeNetworkEdit::ExecuteNetworkChange(std::shared_ptr<sv4guiPurkinjeNetworkGraph::Change> change, 
+    const std::string& description)
+{
+  // The grown tree kept for completing the network no longer matches 
+  // the edited network.
+  m_IncompleteNetworkFaceName = "";
+  ui->buttonCompleteNetwork->setEnabled(false);
+
+  // The do and undo operations share the change.
+  mitk::OperationEvent::IncCurrObjectEventId();
+  auto networkID = m_1DContainer->GetNetworkID();
+  auto doOp = new sv4guiPurkinjeNetworkOperation(sv4guiPurkinjeNetworkOperation::OpAPPLYCHANGE, change, networkID);
+  auto undoOp = new sv4guiPurkinjeNetworkOperation(sv4guiPurkinjeNetworkOperation::OpUNDOCHANGE, change, networkID);
+  auto operationEvent = new mitk::OperationEvent(m_1DContainer, doOp, undoOp, description);
+  mitk::UndoController::GetCurrentUndoModel()->SetOperationEvent(operationEvent);
+  m_1DContainer->ExecuteOperation(doOp);
+}
+
+//-----------------------
+// RecordParameterChange 
+//-----------------------
+// Record the parameter values edited in the GUI.
+//
+// The old and new values of the edited parameters are stored so the edit 
+// can be undone and redone using the MITK undo controller.
+//
+void sv4guiPurkinjeNetworkEdit::RecordParameterChange()
+{
+  if (m_NetworkParameters.IsNull()) {
+    return;
+  }
+
+  std::map<std::string, std::string> oldParams, newParams;
+  for (const auto& param : GetRecordedParameters()) {
+    auto value = m_NetworkParameters->GetProp(param.first);
+    if (value != param.second) {
+      oldParams[param.first] = value;
+      newParams[param.first] = param.second;
+    }
+  }
+
+  if (newParams.size() == 0) {
+    return;
+  }
+
+  mitk::OperationEvent::IncCurrObjectEventId();
+  auto doOp = new sv4guiPurkinjeNetworkOperation(sv4guiPurkinjeNetworkOperation::OpSETPROPS, oldParams, newParams);
+  auto undoOp = new sv4guiPurkinjeNetworkOperation(sv4guiPurkinjeNetworkOperation::OpUNDOPROPS, oldParams, newParams);
+  auto operationEvent = new mitk::OperationEvent(m_NetworkParameters, doOp, undoOp, "Edit Parameters");
+  mitk::UndoController::GetCurrentUndoModel()->SetOperationEvent(operationEvent);
+  m_NetworkParameters->ExecuteOperation(doOp);
+}
+
+//-----------------------
+// GetRecordedParameters 
+//-----------------------
+// Get the parameter values from the GUI whose edits are recorded. 
+//
+// The network points are picked on the surface and are not recorded.
+//
+std::map<std::string, std::string> sv4guiPurkinjeNetworkEdit::GetRecordedParameters()
+{
+  sv4guiPurkinjeNetworkModelParamNames paramNames;
+  auto params = GetParametersFromGui();
+  params.erase(paramNames.FirstPoint);
+  params.erase(paramNames.SecondPoint);
+  return params;
+}
+
+//-------------------
+// SaveNetworkChange 
+//-------------------
+// Write the edited network to the files it was loaded from and recompute 
+// the outputs derived from it.
+//
+// A generated network is written as the grown network NAME_xyz/ien/endnodes.txt 
+// and processed again by the model: activation times, ordering, partitions, 
+// coupling and coverage are recomputed from the edited network and NAME.vtu 
+// is rewritten. A preview network is only written.
+//
+void sv4guiPurkinjeNetworkEdit::SaveNetworkChange()
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkEdit::SaveNetworkChange] ";
+  MITK_INFO << msgPrefix << "Network file " << m_NetworkFileName;
+
+  if (m_NetworkFileName == "") {
+    return;
+  }
+
+  const auto& network = m_1DContainer->GetNetwork();
+  auto filePrefix = m_NetworkFileName.substr(0, m_NetworkFileName.rfind(".vtu"));
+
+  if (!network.Write(filePrefix)) {
+    QMessageBox::warning(QApplication::activeWindow(), "Purkinje Network Tool", "Writing the edited network failed.");
+    return;
+  }
+
+  if (m_NetworkFaceName == "") {
+    network.WriteVtu(m_NetworkFileName);
+    return;
+  }
+
+  // The model needs the surface of the face the network was generated for.
+  if (!m_MeshContainer->HaveSelectedFace() || (m_MeshContainer->GetSelectedFaceName() != m_NetworkFaceName)) {
+    MITK_WARN << msgPrefix << "The face " << m_NetworkFaceName << " is not selected, only the network is written.";
+    network.WriteVtu(m_NetworkFileName);
+    return;
+  }
+
+  std::array<double,3> firstPoint, secondPoint;
+  m_MeshContainer->GetNetworkPoints(firstPoint, secondPoint);
+  sv4guiPurkinjeNetworkModel pnetModel(m_NetworkFaceName, firstPoint, secondPoint);
+  auto params = GetParametersFromGui();
+  pnetModel.SetParameters(params);
+  SetModelMesh(pnetModel);
+
+  if (!pnetModel.ProcessNetwork(m_NetworkOutputPath)) {
+    QMessageBox::warning(QApplication::activeWindow(), "Purkinje Network Tool", "Processing the edited network failed.");
+    return;
+  }
+
+  if (pnetModel.surfaceActivationFileName != "") {
+    LoadSurfaceScalars(pnetModel.surfaceActivationFileName, "ActivationTime", "Surface Activation", 
+        m_SurfaceActivationNode);
+  }
+
+  if (pnetModel.coverageFileName != "") {
+    LoadSurfaceScalars(pnetModel.coverageFileName, "NetworkDistance", "Network Coverage", m_CoverageNode);
+  }
+}
+
+//--------------------
+// UpdatePreview 
+//--------------------
+// Regenerate the preview network when a growth parameter has been 
+// edited and automatic preview is enabled.
+//
+void sv4guiPurkinjeNetworkEdit::UpdatePreview()
+{
+  if (ui->autoPreviewCheckBox->isChecked()) {
+    GenerateNetwork(GenerateMode::Preview);
+  }
+}
+
+//-----------------
+// GenerateNetwork 
+//-----------------
+// Generate a Purkinje Network, complete the last network generated 
+// for the selected face or generate a coarse preview network.
+//
+void sv4guiPurkinjeNetworkEdit::GenerateNetwork(GenerateMode mode)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkEdit::GenerateNetwork] ";
   MITK_INFO << msgPrefix; 
 
   // Check that a face is selected.
@@ -595,6 +952,11 @@ void sv4guiPurkinjeNetworkEdit::CreateNetwork()
   auto faceName = m_MeshContainer->GetSelectedFaceName();
   MITK_INFO << msgPrefix << "Face name " << faceName;
 
+  if ((mode == GenerateMode::Complete) && (faceName != m_IncompleteNetworkFaceName)) {
+    QMessageBox::warning(m_Parent, "Purkinje Network Tool", "The network of the selected face has all of its branch generations.");
+    return;
+  }
+
   // Get the network start point and second point defining 
   // the direction of the initial segment.
   if (!m_MeshContainer->HaveNetworkPoints()) {
@@ -619,14 +981,35 @@ void sv4guiPurkinjeNetworkEdit::CreateNetwork()
   pnetModel.SetParameters(params);
 
   SetModelMesh(pnetModel);
+  pnetModel.imageFileName = GetImageFileName(projPath);
   auto outputPath = projPath + "/" + m_StoreDir.toStdString() + "/";
-  auto status = pnetModel.GenerateNetwork(outputPath);
+  bool status;
+  if (mode == GenerateMode::Preview) {
+    status = pnetModel.GeneratePreview(outputPath);
+  } else if (mode == GenerateMode::Complete) {
+    status = pnetModel.CompleteNetwork(outputPath);
+  } else {
+    status = pnetModel.GenerateNetwork(outputPath);
+  }
 
   if (!status) { 
     QMessageBox::warning(QApplication::activeWindow(), "Purkinje Network Tool", "The Purkinje network generation failed.");
     return;
   }
 
+  // The preview replaces the tree stored for completing a network
+  // so a previous incomplete network can no longer be completed.
+  if (mode == GenerateMode::Preview) {
+    m_IncompleteNetworkFaceName = "";
+    ui->buttonCompleteNetwork->setEnabled(false);
+    LoadNetwork(pnetModel.previewNetworkFileName);
+    m_NetworkFaceName = "";
+    return;
+  }
+
+  m_IncompleteNetworkFaceName = pnetModel.networkComplete ? "" : faceName;
+  ui->buttonCompleteNetwork->setEnabled(!pnetModel.networkComplete);
+
   // Read output files.
   //
   // Node coordinates file.
@@ -656,10 +1039,36 @@ void sv4guiPurkinjeNetworkEdit::CreateNetwork()
   QString msg = "A Purkinje network has been successfully generated.\n";
   msg += "Number of segments: " + QString::number(numElems) + "\n";
   msg += "Number of nodes: " + QString::number(numNodes) + "\n";
+  if (!pnetModel.networkComplete) {
+    msg += "\nThe time budget expired before all branch generations were grown.\n";
+    msg += "Select Complete Network to grow the remaining generations.\n";
+  }
+  if (pnetModel.coverageReport != "") {
+    msg += "\n" + QString::fromStdString(pnetModel.coverageReport);
+  }
   QMessageBox::information(NULL, "Purkinje Network Tool", msg); 
 
+  // Show the calibrated parameters used to generate the network.
+  if (pnetModel.calibratedParameterFileName != "") {
+    ReadParameters(pnetModel.calibratedParameterFileName);
+    RecordParameterChange();
+  }
+
   // Read the generated network (1D elements).
   LoadNetwork(pnetModel.networkFileName);
+  m_NetworkFaceName = faceName;
+  m_NetworkOutputPath = outputPath;
+
+  // Read the surface mesh activation times.
+  if (pnetModel.surfaceActivationFileName != "") {
+    LoadSurfaceScalars(pnetModel.surfaceActivationFileName, "ActivationTime", "Surface Activation", 
+        m_SurfaceActivationNode);
+  }
+
+  // Read the surface mesh distances to the network.
+  if (pnetModel.coverageFileName != "") {
+    LoadSurfaceScalars(pnetModel.coverageFileName, "NetworkDistance", "Network Coverage", m_CoverageNode);
+  }
 
 }
 
@@ -704,6 +1113,66 @@ std::map<std::string, std::string> sv4guiPurkinjeNetworkEdit::GetParametersFromG
   auto repulsiveParameter = std::to_string(ui->repulsiveParameterSpinBox->value());
   params.insert(pair<std::string,std::string>(paramNames.RepulsiveParameter, repulsiveParameter));
 
+  auto resampleElementSize = std::to_string(ui->resampleElementSizeSpinBox->value());
+  params.insert(pair<std::string,std::string>(paramNames.ResampleElementSize, resampleElementSize));
+
+  auto nodeOrdering = ui->nodeOrderingComboBox->currentText().toStdString();
+  params.insert(pair<std::string,std::string>(paramNames.NodeOrdering, nodeOrdering));
+
+  auto numPartitions = std::to_string(ui->numPartitionsSpinBox->value());
+  params.insert(pair<std::string,std::string>(paramNames.NumPartitions, numPartitions));
+
+  auto conductionVelocity = std::to_string(ui->conductionVelocitySpinBox->value());
+  params.insert(pair<std::string,std::string>(paramNames.ConductionVelocity, conductionVelocity));
+
+  auto activationSources = ui->activationSourcesLineEdit->text().trimmed().toStdString();
+  params.insert(pair<std::string,std::string>(paramNames.ActivationSources, activationSources));
+
+  auto myocardialVelocity = std::to_string(ui->myocardialVelocitySpinBox->value());
+  params.insert(pair<std::string,std::string>(paramNames.MyocardialVelocity, myocardialVelocity));
+
+  auto volumeActivation = ui->volumeActivationComboBox->currentText().toStdString();
+  params.insert(pair<std::string,std::string>(paramNames.VolumeActivation, volumeActivation));
+
+  auto crossFiberVelocity = std::to_string(ui->crossFiberVelocitySpinBox->value());
+  params.insert(pair<std::string,std::string>(paramNames.CrossFiberVelocity, crossFiberVelocity));
+
+  auto coverageDistance = std::to_string(ui->coverageDistanceSpinBox->value());
+  params.insert(pair<std::string,std::string>(paramNames.CoverageDistance, coverageDistance));
+
+  auto calibrationMetric = ui->calibrationMetricComboBox->currentText().toStdString();
+  params.insert(pair<std::string,std::string>(paramNames.CalibrationMetric, calibrationMetric));
+
+  auto calibrationTarget = std::to_string(ui->calibrationTargetSpinBox->value());
+  params.insert(pair<std::string,std::string>(paramNames.CalibrationTarget, calibrationTarget));
+
+  auto calibrationEvaluations = std::to_string(ui->calibrationEvaluationsSpinBox->value());
+  params.insert(pair<std::string,std::string>(paramNames.CalibrationEvaluations, calibrationEvaluations));
+
+  auto cableSimulationTime = std::to_string(ui->cableSimulationTimeSpinBox->value());
+  params.insert(pair<std::string,std::string>(paramNames.CableSimulationTime, cableSimulationTime));
+
+  auto timeBudget = std::to_string(ui->timeBudgetSpinBox->value());
+  params.insert(pair<std::string,std::string>(paramNames.TimeBudget, timeBudget));
+
+  auto previewReduction = std::to_string(ui->previewReductionSpinBox->value());
+  params.insert(pair<std::string,std::string>(paramNames.PreviewReduction, previewReduction));
+
+  auto surfaceMapping = ui->surfaceMappingComboBox->currentText().toStdString();
+  params.insert(pair<std::string,std::string>(paramNames.SurfaceMapping, surfaceMapping));
+
+  auto imageIsovalue = std::to_string(ui->imageIsovalueSpinBox->value());
+  params.insert(pair<std::string,std::string>(paramNames.ImageIsovalue, imageIsovalue));
+
+  auto growthAlgorithm = ui->growthAlgorithmComboBox->currentText().toStdString();
+  params.insert(pair<std::string,std::string>(paramNames.GrowthAlgorithm, growthAlgorithm));
+
+  auto attractorSpacing = std::to_string(ui->attractorSpacingSpinBox->value());
+  params.insert(pair<std::string,std::string>(paramNames.AttractorSpacing, attractorSpacing));
+
+  auto pmjCoupling = ui->pmjCouplingComboBox->currentText().toStdString();
+  params.insert(pair<std::string,std::string>(paramNames.PmjCoupling, pmjCoupling));
+
   return params;
 }
 
@@ -713,26 +1182,93 @@ std::map<std::string, std::string> sv4guiPurkinjeNetworkEdit::GetParametersFromG
 void sv4guiPurkinjeNetworkEdit::SetModelMesh(sv4guiPurkinjeNetworkModel& model)
 {
   model.meshPolyData = m_MeshContainer->GetSelectedFacePolyData();
+
+  auto mesh = m_MeshContainer->GetSurfaceMesh();
+  if (mesh != nullptr) {
+    model.volumeMesh = mesh->GetVolumeMesh();
+  }
 }
 
 // Read a Purkinje network file.
 //
 // The network is represented as an unstructured mesh of 1D elements.
-// The elements are stored in a VTK .vtu format file.
+// The elements are stored in a VTK .vtu format file. The network is 
+// displayed as polylines, one per branch.
 //
-sv4guiMesh* sv4guiPurkinjeNetworkEdit::LoadNetwork(std::string fileName)
+bool sv4guiPurkinjeNetworkEdit::LoadNetwork(std::string fileName)
 {
   MITK_INFO << "[sv4guiPurkinjeNetworkEdit::LoadNetwork] ";
   MITK_INFO << "[sv4guiPurkinjeNetworkEdit::LoadNetwork] Read surface network " << fileName;
-  m_SurfaceNetworkMesh = new sv4guiMesh();
-  m_SurfaceNetworkMesh->ReadVolumeFile(fileName);
-  m_1DContainer->SetSurfaceNetworkMesh(m_SurfaceNetworkMesh);
+  sv4guiPurkinjeNetworkGraph network;
+  if (!network.ReadVtu(fileName)) {
+    return false;
+  }
+  network.BuildAdjacency();
+  m_1DContainer->SetNetwork(network);
+  m_NetworkFileName = fileName;
+  ui->buttonRegrowBranch->setEnabled(false);
+  ui->buttonRemoveBranch->setEnabled(false);
+  ui->buttonMoveNode->setEnabled(false);
 
   if (ui->networkCheckBox->isChecked()) {
     showNetwork(true);
   } else {
     showNetwork(false);
   }
+
+  return true;
+}
+
+//--------------------
+// LoadSurfaceScalars
+//--------------------
+// Read a surface mesh with values stored as point data named 'arrayName' 
+// and display it colored by those values.
+//
+// The surface is displayed using a 'nodeName' node under the 
+// 'Purkinje-Network' node.
+
+void sv4guiPurkinjeNetworkEdit::LoadSurfaceScalars(const std::string& fileName, const std::string& arrayName, 
+    const std::string& nodeName, mitk::DataNode::Pointer& node)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkEdit::LoadSurfaceScalars] ";
+  MITK_INFO << msgPrefix << "Read " << arrayName << " surface " << fileName;
+
+  auto reader = vtkSmartPointer<vtkXMLPolyDataReader>::New();
+  reader->SetFileName(fileName.c_str());
+  reader->Update();
+  vtkSmartPointer<vtkPolyData> polyData = reader->GetOutput();
+
+  auto values = polyData->GetPointData()->GetArray(arrayName.c_str());
+  if (values == nullptr) {
+    MITK_WARN << msgPrefix << "No " << arrayName << " values in " << fileName;
+    return;
+  }
+  double range[2];
+  values->GetRange(range);
+  polyData->GetPointData()->SetActiveScalars(arrayName.c_str());
+
+  auto surface = mitk::Surface::New();
+  surface->SetVtkPolyData(polyData);
+
+  if (node.IsNull()) {
+    node = mitk::DataNode::New();
+    node->SetName(nodeName);
+    auto parentNode = GetDataStorage()->GetNamedNode("Purkinje-Network");
+    if (parentNode) {
+      GetDataStorage()->Add(node, parentNode);
+    } else {
+      GetDataStorage()->Add(node);
+    }
+  }
+
+  node->SetData(surface);
+  node->SetBoolProperty("scalar visibility", true);
+  node->SetFloatProperty("ScalarsRangeMinimum", range[0]);
+  node->SetFloatProperty("ScalarsRangeMaximum", range[1]);
+  node->SetVisibility(true);
+
+  mitk::RenderingManager::GetInstance()->RequestUpdateAll();
 }
 
 void sv4guiPurkinjeNetworkEdit::SelectMesh()
@@ -853,54 +1389,8 @@ void sv4guiPurkinjeNetworkEdit::LoadParameters()
           return;
       }
 
-      // Read file.
-      MITK_INFO << "[sv4guiPurkinjeNetworkEdit::LoadParameters] Read paramaers " << m_ParameterFileName.toStdString();
-      std::ifstream inFile(m_ParameterFileName.toStdString());
-      std::string line;
-      std::string name, v1, v2, v3;
-      double point[3];
-      sv4guiPurkinjeNetworkModelParamNames paramNames;
-
-      while (std::getline(inFile, line)) {
-        std::stringstream ss(line);
-        ss >> name;
-        std::cout << " name " << name << std::endl;
-        if (name == paramNames.FirstPoint) {
-          ss >> v1 >> v2 >> v3;
-          std::cout << " 1st v1 " << v1 << std::endl;
-          std::cout << " 1st v2 " << v2 << std::endl;
-          std::cout << " 1st v3 " << v3 << std::endl;
-          point[0] = std::stod(v1);
-          point[1] = std::stod(v2);
-          point[2] = std::stod(v3);
-          m_MeshContainer->SetFirstNetworkPoint(point);
-          ui->startPointXLineEdit->setText(QString::fromStdString(v1));
-          ui->startPointYLineEdit->setText(QString::fromStdString(v2));
-          ui->startPointZLineEdit->setText(QString::fromStdString(v3));
-        } else if (name == paramNames.SecondPoint) {
-          ss >> v1 >> v2 >> v3;
-          std::cout << " 2nd v1 " << v1 << std::endl;
-          std::cout << " 2nd v2 " << v2 << std::endl;
-          std::cout << " 2nd v3 " << v3 << std::endl;
-          point[0] = std::stod(v1);
-          point[1] = std::stod(v2);
-          point[2] = std::stod(v3);
-          m_MeshContainer->SetSecondNetworkPoint(point);
-          ui->secondPointXLineEdit->setText(QString::fromStdString(v1));
-          ui->secondPointYLineEdit->setText(QString::fromStdString(v2));
-          ui->secondPointZLineEdit->setText(QString::fromStdString(v3));
-        } else if (name == paramNames.NumBranchGenerations) {
-          ss >> v1;
-          ui->numBranchGenSpinBox->setValue(std::stoi(v1));
-        } else if (name == paramNames.AvgBranchLength) {
-          ss >> v1;
-          ui->avgBranchLengthSpinBox->setValue(std::stod(v1));
-        } else if (name == paramNames.BranchSegLength) {
-          ss >> v1;
-          ui->branchSegLengthSpinBox->setValue(std::stod(v1));
-        }
-      }
-      inFile.close();
+      ReadParameters(m_ParameterFileName.toStdString());
+      RecordParameterChange();
   }
 
   catch(...) {
@@ -908,6 +1398,132 @@ void sv4guiPurkinjeNetworkEdit::LoadParameters()
   }
 }
 
+//----------------
+// ReadParameters
+//----------------
+// Read parameters from a file and set their values in the GUI.
+
+void sv4guiPurkinjeNetworkEdit::ReadParameters(const std::string& fileName)
+{
+  MITK_INFO << "[sv4guiPurkinjeNetworkEdit::ReadParameters] Read parameters " << fileName;
+  std::ifstream inFile(fileName);
+  SetParameters(inFile);
+  inFile.close();
+}
+
+//---------------
+// SetParameters
+//---------------
+// Set parameter values in the GUI from 'name value' lines.
+
+void sv4guiPurkinjeNetworkEdit::SetParameters(std::istream& in)
+{
+  std::string line;
+  std::string name, v1, v2, v3;
+  double point[3];
+  sv4guiPurkinjeNetworkModelParamNames paramNames;
+
+  while (std::getline(in, line)) {
+    std::stringstream ss(line);
+    ss >> name;
+    if (name == paramNames.FirstPoint) {
+      ss >> v1 >> v2 >> v3;
+      point[0] = std::stod(v1);
+      point[1] = std::stod(v2);
+      point[2] = std::stod(v3);
+      m_MeshContainer->SetFirstNetworkPoint(point);
+      ui->startPointXLineEdit->setText(QString::fromStdString(v1));
+      ui->startPointYLineEdit->setText(QString::fromStdString(v2));
+      ui->startPointZLineEdit->setText(QString::fromStdString(v3));
+    } else if (name == paramNames.SecondPoint) {
+      ss >> v1 >> v2 >> v3;
+      point[0] = std::stod(v1);
+      point[1] = std::stod(v2);
+      point[2] = std::stod(v3);
+      m_MeshContainer->SetSecondNetworkPoint(point);
+      ui->secondPointXLineEdit->setText(QString::fromStdString(v1));
+      ui->secondPointYLineEdit->setText(QString::fromStdString(v2));
+      ui->secondPointZLineEdit->setText(QString::fromStdString(v3));
+    } else if (name == paramNames.NumBranchGenerations) {
+      ss >> v1;
+      ui->numBranchGenSpinBox->setValue(std::stoi(v1));
+    } else if (name == paramNames.AvgBranchLength) {
+      ss >> v1;
+      ui->avgBranchLengthSpinBox->setValue(std::stod(v1));
+    } else if (name == paramNames.BranchAngle) {
+      ss >> v1;
+      ui->branchAngleSpinBox->setValue(std::stod(v1));
+    } else if (name == paramNames.RepulsiveParameter) {
+      ss >> v1;
+      ui->repulsiveParameterSpinBox->setValue(std::stod(v1));
+    } else if (name == paramNames.BranchSegLength) {
+      ss >> v1;
+      ui->branchSegLengthSpinBox->setValue(std::stod(v1));
+    } else if (name == paramNames.ResampleElementSize) {
+      ss >> v1;
+      ui->resampleElementSizeSpinBox->setValue(std::stod(v1));
+    } else if (name == paramNames.NodeOrdering) {
+      ss >> v1;
+      ui->nodeOrderingComboBox->setCurrentText(QString::fromStdString(v1));
+    } else if (name == paramNames.NumPartitions) {
+      ss >> v1;
+      ui->numPartitionsSpinBox->setValue(std::stoi(v1));
+    } else if (name == paramNames.ConductionVelocity) {
+      ss >> v1;
+      ui->conductionVelocitySpinBox->setValue(std::stod(v1));
+    } else if (name == paramNames.ActivationSources) {
+      v1 = "";
+      ss >> v1;
+      ui->activationSourcesLineEdit->setText(QString::fromStdString(v1));
+    } else if (name == paramNames.MyocardialVelocity) {
+      ss >> v1;
+      ui->myocardialVelocitySpinBox->setValue(std::stod(v1));
+    } else if (name == paramNames.VolumeActivation) {
+      ss >> v1;
+      ui->volumeActivationComboBox->setCurrentText(QString::fromStdString(v1));
+    } else if (name == paramNames.CrossFiberVelocity) {
+      ss >> v1;
+      ui->crossFiberVelocitySpinBox->setValue(std::stod(v1));
+    } else if (name == paramNames.CoverageDistance) {
+      ss >> v1;
+      ui->coverageDistanceSpinBox->setValue(std::stod(v1));
+    } else if (name == paramNames.CalibrationMetric) {
+      ss >> v1;
+      ui->calibrationMetricComboBox->setCurrentText(QString::fromStdString(v1));
+    } else if (name == paramNames.CalibrationTarget) {
+      ss >> v1;
+      ui->calibrationTargetSpinBox->setValue(std::stod(v1));
+    } else if (name == paramNames.CalibrationEvaluations) {
+      ss >> v1;
+      ui->calibrationEvaluationsSpinBox->setValue(std::stoi(v1));
+    } else if (name == paramNames.CableSimulationTime) {
+      ss >> v1;
+      ui->cableSimulationTimeSpinBox->setValue(std::stod(v1));
+    } else if (name == paramNames.TimeBudget) {
+      ss >> v1;
+      ui->timeBudgetSpinBox->setValue(std::stod(v1));
+    } else if (name == paramNames.PreviewReduction) {
+      ss >> v1;
+      ui->previewReductionSpinBox->setValue(std::stod(v1));
+    } else if (name == paramNames.SurfaceMapping) {
+      ss >> v1;
+      ui->surfaceMappingComboBox->setCurrentText(QString::fromStdString(v1));
+    } else if (name == paramNames.ImageIsovalue) {
+      ss >> v1;
+      ui->imageIsovalueSpinBox->setValue(std::stod(v1));
+    } else if (name == paramNames.GrowthAlgorithm) {
+      ss >> v1;
+      ui->growthAlgorithmComboBox->setCurrentText(QString::fromStdString(v1));
+    } else if (name == paramNames.AttractorSpacing) {
+      ss >> v1;
+      ui->attractorSpacingSpinBox->setValue(std::stod(v1));
+    } else if (name == paramNames.PmjCoupling) {
+      ss >> v1;
+      ui->pmjCouplingComboBox->setCurrentText(QString::fromStdString(v1));
+    }
+  }
+}
+
 //------------------
 // ExportParameters
 //------------------
@@ -1044,6 +1660,33 @@ void sv4guiPurkinjeNetworkEdit::AddObservers()
     command->SetCallbackFunction(this, &sv4guiPurkinjeNetworkEdit::UpdateStartPointSelection);
     m_MeshSelectStartPointObserverTag = m_MeshContainer->AddObserver(sv4guiPurkinjeNetworkMeshSelectStartPointFaceEvent(), command);
   }
+
+  // Connect selecting a network element event. 
+  //
+  MITK_INFO << msgprefix << "Connect selecting a network element event";
+  if ((m_NetworkSelectElementObserverTag == -1) && m_1DContainer.IsNotNull()) {
+    itk::SimpleMemberCommand<sv4guiPurkinjeNetworkEdit>::Pointer command = itk::SimpleMemberCommand<sv4guiPurkinjeNetworkEdit>::New();
+    command->SetCallbackFunction(this, &sv4guiPurkinjeNetworkEdit::UpdateNetworkElementSelection);
+    m_NetworkSelectElementObserverTag = m_1DContainer->AddObserver(sv4guiPurkinjeNetwork1DSelectElementEvent(), command);
+  }
+
+  // Connect editing the network event, also invoked by undo and redo. 
+  //
+  MITK_INFO << msgprefix << "Connect editing the network event";
+  if ((m_NetworkChangeObserverTag == -1) && m_1DContainer.IsNotNull()) {
+    itk::SimpleMemberCommand<sv4guiPurkinjeNetworkEdit>::Pointer command = itk::SimpleMemberCommand<sv4guiPurkinjeNetworkEdit>::New();
+    command->SetCallbackFunction(this, &sv4guiPurkinjeNetworkEdit::UpdateNetworkChange);
+    m_NetworkChangeObserverTag = m_1DContainer->AddObserver(sv4guiPurkinjeNetwork1DChangeEvent(), command);
+  }
+
+  // Connect editing the parameters event, also invoked by undo and redo. 
+  //
+  MITK_INFO << msgprefix << "Connect editing the parameters event";
+  if ((m_ParameterChangeObserverTag == -1) && m_NetworkParameters.IsNotNull()) {
+    itk::SimpleMemberCommand<sv4guiPurkinjeNetworkEdit>::Pointer command = itk::SimpleMemberCommand<sv4guiPurkinjeNetworkEdit>::New();
+    command->SetCallbackFunction(this, &sv4guiPurkinjeNetworkEdit::UpdateParameterChange);
+    m_ParameterChangeObserverTag = m_NetworkParameters->AddObserver(sv4guiPurkinjeNetworkPropsEvent(), command);
+  }
   MITK_INFO << msgprefix << "Done! ";
 }
 
@@ -1070,6 +1713,52 @@ void sv4guiPurkinjeNetworkEdit::UpdateFaceSelection()
   ui->secondPointZLineEdit->setText(" ");
 }
 
+//-------------------------------
+// UpdateNetworkElementSelection
+//-------------------------------
+// Enable editing a branch when a network branch is selected.
+//
+void sv4guiPurkinjeNetworkEdit::UpdateNetworkElementSelection()
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkEdit::UpdateNetworkElementSelection] ";
+  const auto& element = m_1DContainer->GetSelectedNetworkElement();
+  MITK_INFO << msgPrefix << "Branch " << element.branch << "  segment " << element.segment << "  generation " 
+      << element.generation << "  node " << element.node;
+  ui->buttonRegrowBranch->setEnabled(element.branch != -1);
+  ui->buttonRemoveBranch->setEnabled(element.branch != -1);
+  ui->buttonMoveNode->setEnabled(element.node != -1);
+}
+
+//---------------------
+// UpdateNetworkChange
+//---------------------
+// Save the network and update the display when the network has been 
+// edited, undone or redone. The branch selection is cleared by the edit.
+//
+void sv4guiPurkinjeNetworkEdit::UpdateNetworkChange()
+{
+  ui->buttonRegrowBranch->setEnabled(false);
+  ui->buttonRemoveBranch->setEnabled(false);
+  ui->buttonMoveNode->setEnabled(false);
+  SaveNetworkChange();
+  mitk::RenderingManager::GetInstance()->RequestUpdateAll();
+}
+
+//-----------------------
+// UpdateParameterChange
+//-----------------------
+// Set the GUI widgets from the parameter values when the parameters 
+// have been edited, undone or redone.
+//
+void sv4guiPurkinjeNetworkEdit::UpdateParameterChange()
+{
+  std::stringstream ss;
+  for (const auto& param : m_NetworkParameters->GetProps()) {
+    ss << param.first << " " << param.second << "\n";
+  }
+  SetParameters(ss);
+}
+
 //---------------------------
 // UpdateStartPointSelection
 //---------------------------
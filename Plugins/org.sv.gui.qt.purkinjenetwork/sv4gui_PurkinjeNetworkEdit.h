@@ -39,10 +39,12 @@
 #include "sv4gui_LocalTableDelegate.h"
 #include "sv4gui_Mesh.h"
 #include "sv4gui_ProjectManager.h"
+#include "sv4gui_PurkinjeNetwork.h"
 #include "sv4gui_PurkinjeNetworkMeshContainer.h"
 #include "sv4gui_PurkinjeNetworkMeshMapper.h"
 #include "sv4gui_PurkinjeNetwork1DContainer.h"
 #include "sv4gui_PurkinjeNetwork1DMapper.h"
+#include "sv4gui_PurkinjeNetwork2DMapper.h"
 #include "sv4gui_PurkinjeNetworkInteractor.h"
 #include "sv4gui_PurkinjeNetworkModel.h"
 
@@ -79,6 +81,13 @@ public slots:
     void ExportParameters();
     void SelectMesh();
     void CreateNetwork();
+    void CompleteNetwork();
+    void PreviewNetwork();
+    void RegrowBranch();
+    void RemoveBranch();
+    void MoveNode();
+    void RecordParameterChange();
+    void UpdatePreview();
     void MeshSurfaceName();
     void MeshSurfaceStartPoint();
     void MeshSurfaceSecondPoint();
@@ -87,6 +96,9 @@ public slots:
 
     void UpdateFaceSelection();
     void UpdateStartPointSelection();
+    void UpdateNetworkElementSelection();
+    void UpdateNetworkChange();
+    void UpdateParameterChange();
 
     //void ShowModel(bool checked = false);
 
@@ -137,9 +149,28 @@ protected:
 
     sv4guiPurkinjeNetwork1DContainer::Pointer m_1DContainer;
     sv4guiPurkinjeNetwork1DMapper::Pointer m_1DMapper;
+    sv4guiPurkinjeNetwork2DMapper::Pointer m_2DMapper;
     mitk::DataNode::Pointer m_1DNode;
 
-    sv4guiMesh* LoadNetwork(std::string fileName);
+    mitk::DataNode::Pointer m_SurfaceActivationNode;
+    mitk::DataNode::Pointer m_CoverageNode;
+
+    // The parameter values stored as props, edits are recorded as 
+    // operations on it so they can be undone.
+    sv4guiPurkinjeNetwork::Pointer m_NetworkParameters;
+
+    bool LoadNetwork(std::string fileName);
+    enum class GenerateMode { Create, Complete, Preview };
+    void GenerateNetwork(GenerateMode mode);
+    enum class EditMode { Regrow, Remove };
+    void EditBranch(EditMode mode);
+    void ExecuteNetworkChange(std::shared_ptr<sv4guiPurkinjeNetworkGraph::Change> change, const std::string& description);
+    void SaveNetworkChange();
+    void ReadParameters(const std::string& fileName);
+    void SetParameters(std::istream& in);
+    std::map<std::string, std::string> GetRecordedParameters();
+    void LoadSurfaceScalars(const std::string& fileName, const std::string& arrayName, const std::string& nodeName,
+        mitk::DataNode::Pointer& node);
 
 private:
 
@@ -149,6 +180,13 @@ private:
     sv4guiMesh* m_SurfaceNetworkMesh;
 
     QString m_ParameterFileName;
+    std::string m_IncompleteNetworkFaceName;
+
+    // The loaded network file, and the face and output path it was generated 
+    // for. The face name is empty for a preview network.
+    std::string m_NetworkFileName;
+    std::string m_NetworkFaceName;
+    std::string m_NetworkOutputPath;
 
     sv4guiProjectManager svProj;
     mitk::DataNode::Pointer m_ProjFolderNode;
@@ -163,9 +201,13 @@ private:
     sv4guiMesh* GetDataNodeMesh();
     mitk::DataNode::Pointer GetMeshFolderDataNode();
     mitk::DataNode::Pointer GetModelFolderDataNode();
+    std::string GetImageFileName(const std::string& projPath);
 
     long m_MeshSelectFaceObserverTag;
     long m_MeshSelectStartPointObserverTag;
+    long m_NetworkSelectElementObserverTag;
+    long m_NetworkChangeObserverTag;
+    long m_ParameterChangeObserverTag;
 };
 
 #endif // SV4GUI_PURKINJENETWORKEDIT_H
@@ -45,8 +45,12 @@
 
 #include <mitkVtkPropRenderer.h>
 
+#include <vtkCamera.h>
 #include <vtkCellPicker.h>
+#include <vtkCellData.h>
+#include <vtkDataArray.h>
 #include <vtkIdList.h>
+#include <vtkRenderer.h>
 
 #include "sv_polydatasolid_utils.h"
 
@@ -66,6 +70,7 @@ void sv4guiPurkinjeNetworkInteractor::ConnectActionsAndFunctions()
   CONNECT_FUNCTION("get_position", GetPosition);
   CONNECT_FUNCTION("select_point", SelectPoint);
   CONNECT_FUNCTION("select_single_face",SelectSingleFace);
+  CONNECT_FUNCTION("select_network_element",SelectNetworkElement);
 }
 
 //-------------
@@ -139,7 +144,7 @@ void sv4guiPurkinjeNetworkInteractor::AddStart(mitk::StateMachineAction*,
 // The select event is generated by pressing the 'S' key in the 
 // graphics window.
 //
-// The select event tries to select the face actors (geometry) stored in the 
+// The select event tries to select the surface actor (geometry) stored in the 
 // sv4guiPurkinjeNetworkMeshMapper object using vtkCellPicker with the current 
 // cursor 2D position 'm_CurrentPickedDisplayPoint'.
 
@@ -160,13 +165,12 @@ void sv4guiPurkinjeNetworkInteractor::SelectSingleFace(mitk::StateMachineAction*
     return;
   }
 
-  // Get the face actors (geometry) we want to select.
-  std::vector<vtkSmartPointer<vtkActor>> faceActors = mapper->GetFaceActors(renderer);
-  if (faceActors.size() == 0) { 
-    MITK_INFO << msgPrefix << "Number of face actore is 0"; 
+  // Get the surface actor (geometry) we want to select.
+  vtkSmartPointer<vtkActor> surfaceActor = mapper->GetSurfaceActor(renderer);
+  if (surfaceActor == nullptr) { 
+    MITK_INFO << msgPrefix << "No surface actor"; 
     return;
   }
-  MITK_INFO << msgPrefix << "Number of face actors " << faceActors.size(); 
   auto meshNode = mapper->GetDataNode();
   auto meshContainer = dynamic_cast<sv4guiPurkinjeNetworkMeshContainer*>(meshNode->GetData());
 
@@ -175,15 +179,11 @@ void sv4guiPurkinjeNetworkInteractor::SelectSingleFace(mitk::StateMachineAction*
 
   // Create a vtkCellPicker object to determine the closest geomety under the cursor.
   //
-  // Attempt to pick the face actors in the pick list and the current cursor
+  // Attempt to pick the surface actor in the pick list and the current cursor
   // position stored in 'm_CurrentPickedDisplayPoint'.
   //
   vtkSmartPointer<vtkCellPicker> cellPicker = vtkSmartPointer<vtkCellPicker>::New();
-  
-  for (const auto& face : faceActors) {
-    //face->GetProperty()->GetColor(rgb);
-    cellPicker->AddPickList(face);
-  }
+  cellPicker->AddPickList(surfaceActor);
 
   // Execute the pick operation.
   cellPicker->PickFromListOn();
@@ -191,9 +191,15 @@ void sv4guiPurkinjeNetworkInteractor::SelectSingleFace(mitk::StateMachineAction*
       renderer->GetVtkRenderer());
   cellPicker->PickFromListOff();
 
-  // Get the face selected.
-  vtkPolyData* selectedFacePolyData = (vtkPolyData*)cellPicker->GetDataSet();
-  if (selectedFacePolyData == nullptr) {
+  // Get the face selected from the face index of the picked cell.
+  vtkDataSet* pickedDataSet = cellPicker->GetDataSet();
+  vtkIdType pickedCellId = cellPicker->GetCellId();
+  vtkDataArray* faceIndexes = nullptr;
+  if ((pickedDataSet != nullptr) && (pickedCellId >= 0)) {
+    faceIndexes = pickedDataSet->GetCellData()->GetArray(sv4guiPurkinjeNetworkMeshContainer::FaceIndexArrayName);
+  }
+
+  if (faceIndexes == nullptr) {
     meshContainer->ResetNetworkPoints();
     // Trigger events to unset selected face and point. 
     meshContainer->InvokeEvent( sv4guiPurkinjeNetworkMeshSelectFaceEvent() );
@@ -201,34 +207,89 @@ void sv4guiPurkinjeNetworkInteractor::SelectSingleFace(mitk::StateMachineAction*
     return;
   }
 
-  // Determine which face was selected.
-  //
-  // Faces are matched using pointers to their poly data.
-  //
-  int selectedFaceIndex = -1;
-  meshContainer->SetSelectedFaceIndex(selectedFaceIndex);
-  meshContainer->SetSelectedFaceName("");
   meshContainer->ResetNetworkPoints();
   std::vector<sv4guiModelElement::svFace*> modelFaces = meshContainer->GetModelFaces();
-  std::vector<vtkSmartPointer<vtkPolyData>> facesPolyData = mapper->GetFacePolyData(renderer);
-
-  for (int i = 0; i < facesPolyData.size(); ++i) {
-    auto polyData = facesPolyData[i];
-    auto face = modelFaces[i];
-    if (polyData == selectedFacePolyData) {
-      selectedFaceIndex = i;
-      MITK_INFO << msgPrefix << "Select face '" << face->name << "'"; 
-      meshContainer->SetSelectedFaceName(face->name);
-      meshContainer->SetSelectedFaceIndex(selectedFaceIndex);
-      meshContainer->SetSelectedFacePolyData(polyData);
-      break;
-    }
+  int selectedFaceIndex = static_cast<int>(faceIndexes->GetTuple1(pickedCellId));
+
+  if ((selectedFaceIndex >= 0) && (selectedFaceIndex < modelFaces.size())) {
+    auto face = modelFaces[selectedFaceIndex];
+    MITK_INFO << msgPrefix << "Select face '" << face->name << "'"; 
+    meshContainer->SetSelectedFaceName(face->name);
+    meshContainer->SetSelectedFaceIndex(selectedFaceIndex);
+    meshContainer->SetSelectedFacePolyData(meshContainer->GetFacePolyData(selectedFaceIndex));
   }
 
   // Trigger an event to highlight selected face. 
   meshContainer->InvokeEvent( sv4guiPurkinjeNetworkMeshSelectFaceEvent() );
 }
 
+//----------------------
+// SelectNetworkElement
+//----------------------
+// Process a network element select event.
+//
+// The select event is generated by pressing the 'N' key in the 
+// graphics window.
+//
+// The network segment under the cursor is found using the segment tree of 
+// the network container with the line through the cursor from the near to 
+// the far clipping plane. The pick tolerance is m_NetworkPickPixels pixels 
+// measured at the depth of the camera focal point.
+
+void sv4guiPurkinjeNetworkInteractor::SelectNetworkElement(mitk::StateMachineAction*, 
+    mitk::InteractionEvent* interactionEvent)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkInteractor::SelectNetworkElement] ";
+
+  if (m_NetworkContainer.IsNull() || (m_NetworkContainer->GetNetwork().GetNumberOfSegments() == 0)) {
+    return;
+  }
+
+  mitk::BaseRenderer* renderer = interactionEvent->GetSender();
+  if ((renderer == nullptr) || (renderer->GetVtkRenderer() == nullptr)) {
+    return;
+  }
+  vtkRenderer* vtkRenderer = renderer->GetVtkRenderer();
+
+  auto displayToWorld = [vtkRenderer](double x, double y, double z, double world[3]) {
+    vtkRenderer->SetDisplayPoint(x, y, z);
+    vtkRenderer->DisplayToWorld();
+    double* point = vtkRenderer->GetWorldPoint();
+    for (int j = 0; j < 3; j++) {
+      world[j] = point[j] / point[3];
+    }
+  };
+
+  double focalPoint[3];
+  vtkRenderer->GetActiveCamera()->GetFocalPoint(focalPoint);
+  vtkRenderer->SetWorldPoint(focalPoint[0], focalPoint[1], focalPoint[2], 1.0);
+  vtkRenderer->WorldToDisplay();
+  double focalDepth = vtkRenderer->GetDisplayPoint()[2];
+
+  double x = m_CurrentPickedDisplayPoint[0];
+  double y = m_CurrentPickedDisplayPoint[1];
+  double start[3], end[3], point1[3], point2[3];
+  displayToWorld(x, y, 0.0, start);
+  displayToWorld(x, y, 1.0, end);
+  displayToWorld(x, y, focalDepth, point1);
+  displayToWorld(x + m_NetworkPickPixels, y, focalDepth, point2);
+
+  double tolerance = 0.0;
+  for (int j = 0; j < 3; j++) {
+    tolerance += (point2[j] - point1[j]) * (point2[j] - point1[j]);
+  }
+  tolerance = sqrt(tolerance);
+
+  sv4guiPurkinjeNetwork1DContainer::NetworkElement element;
+  if (m_NetworkContainer->FindNetworkElement(start, end, tolerance, element)) {
+    MITK_INFO << msgPrefix << "Select branch " << element.branch << "  segment " << element.segment 
+              << "  generation " << element.generation << "  node " << element.node; 
+  }
+
+  m_NetworkContainer->SetSelectedNetworkElement(element);
+  m_NetworkContainer->InvokeEvent( sv4guiPurkinjeNetwork1DSelectElementEvent() );
+}
+
 //------------
 // GetPosition
 //------------
@@ -33,6 +33,7 @@
 #define sv4guiPurkinjeNetworkINTERACTOR_H
 
 #include "sv4gui_PurkinjeNetworkMeshContainer.h"
+#include "sv4gui_PurkinjeNetwork1DContainer.h"
 //#include "sv4gui_PurkinjeNetworkEdit.h"
 
 //#include <itkEventObject.h>
@@ -46,6 +47,12 @@ public:
   itkCloneMacro(Self)
   double m_seedRadius = 0.5;
 
+  // The network container used to pick network elements.
+  void SetNetworkContainer(sv4guiPurkinjeNetwork1DContainer* container) { m_NetworkContainer = container; }
+
+  // The distance in pixels from the cursor within which network elements are picked.
+  double m_NetworkPickPixels = 5.0;
+
 protected:
   sv4guiPurkinjeNetworkInteractor();
   ~sv4guiPurkinjeNetworkInteractor();
@@ -56,6 +63,7 @@ protected:
 
   virtual void SelectPoint(mitk::StateMachineAction*, mitk::InteractionEvent*);
   virtual void SelectSingleFace(mitk::StateMachineAction*, mitk::InteractionEvent*);
+  virtual void SelectNetworkElement(mitk::StateMachineAction*, mitk::InteractionEvent*);
 
   void GetPosition(mitk::StateMachineAction*, mitk::InteractionEvent* interactionEvent);
 
@@ -65,6 +73,7 @@ private:
   mitk::Point3D m_currentPickedPoint;
   int m_currentStartSeed = -1;
   mitk::Point2D m_CurrentPickedDisplayPoint;
+  sv4guiPurkinjeNetwork1DContainer::Pointer m_NetworkContainer;
 };
 
 // Define classes for events.
@@ -32,10 +32,22 @@
 #include "sv4gui_PurkinjeNetworkMeshContainer.h"
 #include "math.h"
 
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkIdList.h>
+#include <vtkIntArray.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+
+#include <map>
+
 #include <berryIPreferencesService.h>
 #include <berryIPreferences.h>
 #include <berryPlatform.h>
 
+// The name of the surface cell data array storing the face index of each cell.
+const char* sv4guiPurkinjeNetworkMeshContainer::FaceIndexArrayName = "FaceIndex";
+
 //-------------
 // Constructor
 //-------------
@@ -48,6 +60,10 @@ sv4guiPurkinjeNetworkMeshContainer::sv4guiPurkinjeNetworkMeshContainer()
   hoverPoint.push_back(0.0);
   hoverPoint.push_back(0.0);
   hoverPoint.push_back(0.0);
+  m_SurfaceMesh = nullptr;
+  m_ModelElement = nullptr;
+  m_PartitionSurface = nullptr;
+  m_PartitionSurfaceMTime = 0;
   m_SelectedFaceIndex = -1;
   m_NewPickedPoint = false;
   m_ValidPickedPoint = false;
@@ -75,6 +91,8 @@ sv4guiPurkinjeNetworkMeshContainer::~sv4guiPurkinjeNetworkMeshContainer(){
 void sv4guiPurkinjeNetworkMeshContainer::SetSurfaceMesh(sv4guiMesh* surfaceMesh)
 {
   m_SurfaceMesh = surfaceMesh;
+  m_PartitionSurface = nullptr;
+  Modified();
 }
 
 sv4guiMesh* sv4guiPurkinjeNetworkMeshContainer::GetSurfaceMesh()
@@ -84,9 +102,12 @@ sv4guiMesh* sv4guiPurkinjeNetworkMeshContainer::GetSurfaceMesh()
 
 void sv4guiPurkinjeNetworkMeshContainer::SetModelFaces(std::vector<sv4guiModelElement::svFace*>& faces)
 {
+  m_ModelFaces.clear();
+  m_PartitionSurface = nullptr;
   for (const auto& face : faces) {
     m_ModelFaces.emplace_back(face);
   }
+  Modified();
 }
 
 std::vector<sv4guiModelElement::svFace*> sv4guiPurkinjeNetworkMeshContainer::GetModelFaces()
@@ -95,6 +116,187 @@ std::vector<sv4guiModelElement::svFace*> sv4guiPurkinjeNetworkMeshContainer::Get
   return tmp;
 }
 
+//------------------
+// GetFacesPolyData
+//------------------
+// Get the surface mesh of each model face, in model face order.
+//
+// The faces are extracted from the surface mesh in a single pass and
+// cached until the surface mesh or model faces change, so all of the 
+// consumers share the same face polydata.
+
+std::vector<vtkSmartPointer<vtkPolyData>> sv4guiPurkinjeNetworkMeshContainer::GetFacesPolyData()
+{
+  UpdateFacePartition();
+  return m_FacesPolyData;
+}
+
+vtkSmartPointer<vtkPolyData> sv4guiPurkinjeNetworkMeshContainer::GetFacePolyData(int faceIndex)
+{
+  UpdateFacePartition();
+  if ((faceIndex < 0) || (faceIndex >= m_FacesPolyData.size())) {
+    return nullptr;
+  }
+  return m_FacesPolyData[faceIndex];
+}
+
+//-----------------
+// GetFacePointIds
+//-----------------
+// Get the surface mesh point ID of each point of a face.
+
+const std::vector<vtkIdType>& sv4guiPurkinjeNetworkMeshContainer::GetFacePointIds(int faceIndex)
+{
+  static const std::vector<vtkIdType> noPointIds;
+  UpdateFacePartition();
+  if ((faceIndex < 0) || (faceIndex >= m_FacesPointIds.size())) {
+    return noPointIds;
+  }
+  return m_FacesPointIds[faceIndex];
+}
+
+//-----------------
+// GetFacesSurface
+//-----------------
+// Get the surface mesh with a 'FaceIndex' cell data array giving the 
+// model face index of each cell. Cells not on a model face are given 
+// the number of model faces.
+//
+// The surface is a shallow copy so the surface mesh is not modified.
+
+vtkSmartPointer<vtkPolyData> sv4guiPurkinjeNetworkMeshContainer::GetFacesSurface()
+{
+  UpdateFacePartition();
+  return m_FacesSurface;
+}
+
+//---------------------
+// UpdateFacePartition
+//---------------------
+// Split the surface mesh into model faces using its 'ModelFaceID' cell data.
+//
+// Cells are first bucketed by face in one pass over the surface. The points 
+// of each face are then numbered in the order they are first used by its cells. 
+// The cost is O(cells + points) independent of the number of faces.
+
+void sv4guiPurkinjeNetworkMeshContainer::UpdateFacePartition()
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkMeshContainer::UpdateFacePartition] ";
+
+  if ((m_SurfaceMesh == nullptr) || (m_ModelElement == nullptr)) {
+    m_FacesPolyData.clear();
+    m_FacesPointIds.clear();
+    m_FacesSurface = nullptr;
+    return;
+  }
+
+  vtkPolyData* surface = m_SurfaceMesh->GetSurfaceMesh().GetPointer();
+  if ((surface == m_PartitionSurface) && (surface != nullptr) && (surface->GetMTime() == m_PartitionSurfaceMTime)) {
+    return;
+  }
+
+  auto numFaces = m_ModelFaces.size();
+  m_FacesPolyData.assign(numFaces, nullptr);
+  m_FacesPointIds.assign(numFaces, std::vector<vtkIdType>());
+  m_FacesSurface = nullptr;
+  m_PartitionSurface = surface;
+  if (surface == nullptr) {
+    return;
+  }
+  m_PartitionSurfaceMTime = surface->GetMTime();
+
+  // Map model face IDs to face indexes.
+  std::map<int,int> faceIndexes;
+  for (int i = 0; i < numFaces; i++) {
+    faceIndexes[m_ModelElement->GetFaceIdentifierFromInnerSolid(m_ModelFaces[i]->id)] = i;
+  }
+
+  auto faceIDs = surface->GetCellData()->GetArray("ModelFaceID");
+  if (faceIDs == nullptr) {
+    MITK_WARN << msgPrefix << "The surface mesh has no 'ModelFaceID' cell data.";
+    return;
+  }
+
+  // Bucket cells by face.
+  auto numCells = surface->GetNumberOfCells();
+  std::vector<int> cellFace(numCells, -1);
+  std::vector<vtkIdType> faceCellStart(numFaces+1, 0);
+  for (vtkIdType i = 0; i < numCells; i++) {
+    auto it = faceIndexes.find(static_cast<int>(faceIDs->GetTuple1(i)));
+    if (it != faceIndexes.end()) {
+      cellFace[i] = it->second;
+      faceCellStart[it->second+1] += 1;
+    }
+  }
+  for (int i = 0; i < numFaces; i++) {
+    faceCellStart[i+1] += faceCellStart[i];
+  }
+
+  // Store the face index of each cell for rendering and picking.
+  auto faceIndexArray = vtkSmartPointer<vtkIntArray>::New();
+  faceIndexArray->SetName(FaceIndexArrayName);
+  faceIndexArray->SetNumberOfValues(numCells);
+  for (vtkIdType i = 0; i < numCells; i++) {
+    faceIndexArray->SetValue(i, (cellFace[i] == -1) ? numFaces : cellFace[i]);
+  }
+  m_FacesSurface = vtkSmartPointer<vtkPolyData>::New();
+  m_FacesSurface->ShallowCopy(surface);
+  m_FacesSurface->GetCellData()->AddArray(faceIndexArray);
+  std::vector<vtkIdType> faceCells(faceCellStart[numFaces]);
+  std::vector<vtkIdType> next(faceCellStart.begin(), faceCellStart.end()-1);
+  for (vtkIdType i = 0; i < numCells; i++) {
+    if (cellFace[i] != -1) {
+      faceCells[next[cellFace[i]]++] = i;
+    }
+  }
+
+  // Create the polydata for each face. The surface to face point map is
+  // reset using the face point IDs so it is only initialized once.
+  auto surfacePointData = surface->GetPointData();
+  auto surfaceCellData = surface->GetCellData();
+  std::vector<vtkIdType> pointMap(surface->GetNumberOfPoints(), -1);
+  auto cellPoints = vtkSmartPointer<vtkIdList>::New();
+  auto facePoints = vtkSmartPointer<vtkIdList>::New();
+
+  for (int face = 0; face < numFaces; face++) {
+    auto numFaceCells = faceCellStart[face+1] - faceCellStart[face];
+    auto& pointIds = m_FacesPointIds[face];
+    auto polyData = vtkSmartPointer<vtkPolyData>::New();
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    auto polys = vtkSmartPointer<vtkCellArray>::New();
+    polyData->GetCellData()->CopyAllocate(surfaceCellData, numFaceCells);
+
+    for (vtkIdType j = faceCellStart[face]; j < faceCellStart[face+1]; j++) {
+      auto cellId = faceCells[j];
+      surface->GetCellPoints(cellId, cellPoints);
+      facePoints->SetNumberOfIds(cellPoints->GetNumberOfIds());
+      for (vtkIdType k = 0; k < cellPoints->GetNumberOfIds(); k++) {
+        auto id = cellPoints->GetId(k);
+        if (pointMap[id] == -1) {
+          pointMap[id] = pointIds.size();
+          pointIds.push_back(id);
+        }
+        facePoints->SetId(k, pointMap[id]);
+      }
+      auto newCellId = polys->InsertNextCell(facePoints);
+      polyData->GetCellData()->CopyData(surfaceCellData, cellId, newCellId);
+    }
+
+    points->SetNumberOfPoints(pointIds.size());
+    polyData->GetPointData()->CopyAllocate(surfacePointData, pointIds.size());
+    for (vtkIdType j = 0; j < pointIds.size(); j++) {
+      points->SetPoint(j, surface->GetPoint(pointIds[j]));
+      polyData->GetPointData()->CopyData(surfacePointData, pointIds[j], j);
+      pointMap[pointIds[j]] = -1;
+    }
+
+    polyData->SetPoints(points);
+    polyData->SetPolys(polys);
+    m_FacesPolyData[face] = polyData;
+    MITK_INFO << msgPrefix << "Face '" << m_ModelFaces[face]->name << "' num tri " << numFaceCells;
+  }
+}
+
 //------------------------
 // Get/Set Network Points 
 //------------------------
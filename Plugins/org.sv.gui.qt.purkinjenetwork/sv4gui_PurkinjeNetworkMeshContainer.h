@@ -64,6 +64,12 @@ class sv4guiPurkinjeNetworkMeshContainer : public mitk::BaseData {
     void SetModelFaces(std::vector<sv4guiModelElement::svFace*>& faces);
     std::vector<sv4guiModelElement::svFace*> GetModelFaces();
 
+    std::vector<vtkSmartPointer<vtkPolyData>> GetFacesPolyData();
+    vtkSmartPointer<vtkPolyData> GetFacePolyData(int faceIndex);
+    const std::vector<vtkIdType>& GetFacePointIds(int faceIndex);
+    vtkSmartPointer<vtkPolyData> GetFacesSurface();
+    static const char* FaceIndexArrayName;
+
     void SetSurfaceNetwork(sv4guiMesh* surfaceNetwork);
     sv4guiMesh* GetSurfaceNetwork();
 
@@ -74,7 +80,7 @@ class sv4guiPurkinjeNetworkMeshContainer : public mitk::BaseData {
     bool HaveNewPickedPoint(bool reset = false);
     bool HaveNewNetworkPoints(bool reset = false);
 
-    void SetModelElement(sv4guiModelElement* modelElement) { m_ModelElement = modelElement; }
+    void SetModelElement(sv4guiModelElement* modelElement) { m_ModelElement = modelElement; m_PartitionSurface = nullptr; Modified(); }
     sv4guiModelElement* GetModelElement() { return m_ModelElement; }
 
     void SetSelectedFaceIndex(int index);
@@ -119,6 +125,14 @@ private:
   bool m_NewNetworkPoints;
   bool m_ValidPickedPoint;
 
+  // The surface mesh partitioned by model face.
+  void UpdateFacePartition();
+  vtkPolyData* m_PartitionSurface;
+  unsigned long m_PartitionSurfaceMTime;
+  std::vector<vtkSmartPointer<vtkPolyData>> m_FacesPolyData;
+  std::vector<std::vector<vtkIdType>> m_FacesPointIds;
+  vtkSmartPointer<vtkPolyData> m_FacesSurface;
+
   bool m_FirstPointDefined;
   bool m_SecondPointDefined;
   std::array<double,3> m_FirstPoint;
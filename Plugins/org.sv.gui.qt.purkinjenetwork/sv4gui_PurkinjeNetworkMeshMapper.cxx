@@ -35,7 +35,7 @@
 #include "vtkSphereSource.h"
 #include "vtkCubeSource.h"
 #include <vtkDataSetMapper.h>
-#include <vtkCellLocator.h>
+#include <vtkIdList.h>
 
 #include "sv_polydatasolid_utils.h"
 
@@ -67,11 +67,9 @@ sv4guiPurkinjeNetworkMeshMapper::~sv4guiPurkinjeNetworkMeshMapper()
 //   - translate, 
 //   - pick.
 //
-// [TODO:DaveP] Why is this called all the time? 
-//
-//  When just clicking in the graphics window it is called 22 times! 
-//
-//  This is also leaking memory.
+// The surface render data is shared by all renderers and is only rebuilt 
+// when the mesh container is modified, so most calls just update the 
+// selected face color and picked point.
 //
 void sv4guiPurkinjeNetworkMeshMapper::GenerateDataForRenderer(mitk::BaseRenderer* renderer)
 {
@@ -111,91 +109,40 @@ void sv4guiPurkinjeNetworkMeshMapper::GenerateDataForRenderer(mitk::BaseRenderer
   // Show surface mesh.
   //
   auto surfaceMesh = meshContainer->GetSurfaceMesh();
-  auto modelFaces = meshContainer->GetModelFaces();
-  sv4guiModelElement* modelElement = meshContainer->GetModelElement();
   int selectedFaceIndex = meshContainer->GetSelectedFaceIndex();
   //MITK_INFO << msgPrefix << "##### selectedFaceIndex: " << selectedFaceIndex; 
 
-  if (surfaceMesh != NULL && m_newMesh) {
-    MITK_INFO << msgPrefix << ">>>>>>>> new mesh <<<<<<<<<< "; 
-    auto polyMesh = surfaceMesh->GetSurfaceMesh();
-    vtkPolyData* geom = polyMesh.GetPointer();
-    if (geom == nullptr) {
-      MITK_WARN << msgPrefix << "No model faces associated with mesh.";
-      return;
-    }
-
-    // Determine a reasonable pick sphere radius.
-    double avgr = 0;
-    double r, dx, dy, dz;
-    int numTri = 0;
-    for (vtkIdType i = 0; i < geom->GetNumberOfCells(); i++) {
-      vtkCell* cell = geom->GetCell(0);
-      vtkTriangle* triangle = dynamic_cast<vtkTriangle*>(cell);
-      double p0[3], p1[3], p2[3];
-      triangle->GetPoints()->GetPoint(0, p0);
-      triangle->GetPoints()->GetPoint(1, p1);
-      triangle->GetPoints()->GetPoint(2, p2);
-      dx = p0[0] - p1[0];
-      dy = p0[1] - p1[1];
-      dz = p0[2] - p1[2];
-      r = sqrt(dx*dx + dy*dy + dz*dz);
-      avgr += r;
-      numTri += 1;
-      if (i == 50) {
-        break;
-      }
-    }
-    m_pickRadius = (avgr / numTri) / 10.0;
-
-    // Create face actors to display show mesh faces.
-    //
-    m_newMesh = false;
-
-    for (const auto& face : modelFaces) {
-      int faceID = modelElement->GetFaceIdentifierFromInnerSolid(face->id);
-      vtkSmartPointer<vtkPolyData> facePolyData = vtkSmartPointer<vtkPolyData>::New();
-      PlyDtaUtils_GetFacePolyData(geom, &faceID, facePolyData);
-
-      vtkSmartPointer<vtkOpenGLPolyDataMapper> faceMapper = vtkSmartPointer<vtkOpenGLPolyDataMapper>::New();
-      faceMapper->SetInputData(facePolyData);
-      faceMapper->ScalarVisibilityOff();  // Turn off mapping of scalar data, otherwise can't set color.
-
-      vtkSmartPointer<vtkActor> faceActor= vtkSmartPointer<vtkActor>::New();
-      faceActor->SetMapper(faceMapper);
-      faceActor->GetProperty()->SetEdgeColor(0.0, 0.0, 0.0);
-      faceActor->GetProperty()->SetEdgeVisibility(1);
-      faceActor->GetProperty()->SetLineWidth(0.5);
-
-      local_storage->m_PropAssembly->AddPart(faceActor);
-      local_storage->m_FaceActors.push_back(faceActor);
-      local_storage->m_FacePolyData.push_back(facePolyData);
-    }
-
-  // Set color and enable picking of selected surface.
-  //
-  // [TODO:DaveP] I'm not sure what to do here. Faces need to be
-  // pickable to select faces and points.
+  // Create the actor showing the mesh faces for this renderer if the 
+  // shared render data has changed.
   //
-  } else {
-    //MITK_INFO << msgPrefix << "##### set selected face color "; 
-    std::vector<vtkSmartPointer<vtkActor>> faceActors = GetFaceActors(renderer);
-    for (int i = 0; i < faceActors.size(); ++i) { 
-      if (selectedFaceIndex == i) { 
-        faceActors[i]->GetProperty()->SetColor(1.0, 1.0, 0.0);
-        //faceActors[i]->PickableOn();
-      } else { 
-        faceActors[i]->GetProperty()->SetColor(1.0, 1.0, 1.0);
-        //faceActors[i]->PickableOff();
-      }
-      /*
-      if (selectedFaceIndex == -1) {
-        faceActors[i]->PickableOn();
-      }
-      */
+  if ((surfaceMesh != NULL) && updateRenderData(meshContainer) && 
+      (local_storage->m_RenderDataMTime != m_RenderDataMTime)) {
+    if (local_storage->m_SurfaceActor != nullptr) {
+      local_storage->m_PropAssembly->RemovePart(local_storage->m_SurfaceActor);
     }
+
+    vtkSmartPointer<vtkOpenGLPolyDataMapper> surfaceMapper = vtkSmartPointer<vtkOpenGLPolyDataMapper>::New();
+    surfaceMapper->SetInputData(m_FacesSurface);
+    surfaceMapper->SetScalarModeToUseCellFieldData();
+    surfaceMapper->SelectColorArray(sv4guiPurkinjeNetworkMeshContainer::FaceIndexArrayName);
+    surfaceMapper->SetLookupTable(m_FaceLookupTable);
+    surfaceMapper->UseLookupTableScalarRangeOn();
+    surfaceMapper->ScalarVisibilityOn();
+
+    vtkSmartPointer<vtkActor> surfaceActor = vtkSmartPointer<vtkActor>::New();
+    surfaceActor->SetMapper(surfaceMapper);
+    surfaceActor->GetProperty()->SetEdgeColor(0.0, 0.0, 0.0);
+    surfaceActor->GetProperty()->SetEdgeVisibility(1);
+    surfaceActor->GetProperty()->SetLineWidth(0.5);
+
+    local_storage->m_PropAssembly->AddPart(surfaceActor);
+    local_storage->m_SurfaceActor = surfaceActor;
+    local_storage->m_RenderDataMTime = m_RenderDataMTime;
   }
 
+  // Set the color of the selected face.
+  highlightFace(selectedFaceIndex);
+
   bool reset = true; // Reset have new picked point to false.
 
   // If no face is selected then don't process a picked point.
@@ -217,24 +164,9 @@ void sv4guiPurkinjeNetworkMeshMapper::GenerateDataForRenderer(mitk::BaseRenderer
     MITK_INFO << msgPrefix << "Picked point: " << point[0] << "  " << point[1] << "  " << point[2]; 
     MITK_INFO << msgPrefix << "selectedFaceIndex: " << selectedFaceIndex;
 
-    // Get the selected face polydata.
-    //
-    auto polyMesh = surfaceMesh->GetSurfaceMesh();
-    vtkPolyData* geom = polyMesh.GetPointer();
-    vtkSmartPointer<vtkPolyData> facePolyData;
-    int faceIndex = 0;
-    for (const auto& face : modelFaces) {
-      if (selectedFaceIndex == faceIndex) { 
-        int faceID = modelElement->GetFaceIdentifierFromInnerSolid(face->id);
-        facePolyData = vtkSmartPointer<vtkPolyData>::New();
-        PlyDtaUtils_GetFacePolyData(geom, &faceID, facePolyData);
-      }
-      faceIndex += 1;
-    }
-
-    // Find closest face and move point to closest vertex on that face.
+    // Find closest face and move point to closest vertex on the selected face.
     //
-    auto validPoint = this->findClosestFace(meshContainer, facePolyData, point);
+    auto validPoint = this->findClosestFace(meshContainer, selectedFaceIndex, point);
     meshContainer->SetValidPickedPoint(validPoint);
 
     // Show picked point.
@@ -254,20 +186,156 @@ void sv4guiPurkinjeNetworkMeshMapper::GenerateDataForRenderer(mitk::BaseRenderer
   local_storage->m_PropAssembly->VisibilityOn();
 }
 
-//--------------------
-// Get/Set FaceActors
-//--------------------
+//-----------------
+// GetSurfaceActor
+//-----------------
+// Get the actor showing the mesh faces, used to pick faces.
 //
-std::vector<vtkSmartPointer<vtkActor>> sv4guiPurkinjeNetworkMeshMapper::GetFaceActors(mitk::BaseRenderer* renderer)
+vtkSmartPointer<vtkActor> sv4guiPurkinjeNetworkMeshMapper::GetSurfaceActor(mitk::BaseRenderer* renderer)
 {
   LocalStorage *ls = m_LSH.GetLocalStorage(renderer);
-  return ls->m_FaceActors;
+  return ls->m_SurfaceActor;
 }
 
-std::vector<vtkSmartPointer<vtkPolyData>> sv4guiPurkinjeNetworkMeshMapper::GetFacePolyData(mitk::BaseRenderer* renderer)
+//------------------
+// updateRenderData
+//------------------
+// Update the render data shared by all renderers.
+//
+// The data is rebuilt only when the modification time of the mesh container 
+// changes, which happens when its surface mesh or model faces are set.
+//
+// Faces are colored by the 'FaceIndex' cell data using a lookup table 
+// so selecting a face only changes the table. The last table entry
+// is used for cells not on a model face.
+//
+bool sv4guiPurkinjeNetworkMeshMapper::updateRenderData(sv4guiPurkinjeNetworkMeshContainer* mesh)
 {
-  LocalStorage *ls = m_LSH.GetLocalStorage(renderer);
-  return ls->m_FacePolyData;
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkMeshMapper::updateRenderData] ";
+
+  if (mesh->GetMTime() == m_RenderDataMTime) {
+    return m_FacesSurface != nullptr;
+  }
+  m_RenderDataMTime = mesh->GetMTime();
+  m_FacesSurface = nullptr;
+  m_FaceLookupTable = nullptr;
+
+  auto facesSurface = mesh->GetFacesSurface();
+  if ((facesSurface == nullptr) || (facesSurface->GetNumberOfCells() == 0)) {
+    MITK_WARN << msgPrefix << "No model faces associated with mesh.";
+    return false;
+  }
+  MITK_INFO << msgPrefix << ">>>>>>>> new mesh <<<<<<<<<< "; 
+
+  // Determine a reasonable pick sphere radius.
+  double avgr = 0;
+  int numTri = 0;
+  auto cellPoints = vtkSmartPointer<vtkIdList>::New();
+  for (vtkIdType i = 0; i < facesSurface->GetNumberOfCells() && i <= 50; i++) {
+    facesSurface->GetCellPoints(i, cellPoints);
+    if (cellPoints->GetNumberOfIds() < 2) {
+      continue;
+    }
+    double p0[3], p1[3];
+    facesSurface->GetPoint(cellPoints->GetId(0), p0);
+    facesSurface->GetPoint(cellPoints->GetId(1), p1);
+    avgr += sqrt((p0[0]-p1[0])*(p0[0]-p1[0]) + (p0[1]-p1[1])*(p0[1]-p1[1]) + (p0[2]-p1[2])*(p0[2]-p1[2]));
+    numTri += 1;
+  }
+  if (numTri != 0) {
+    m_pickRadius = (avgr / numTri) / 10.0;
+  }
+
+  int numFaces = mesh->GetModelFaces().size();
+  auto faceLookupTable = vtkSmartPointer<vtkLookupTable>::New();
+  faceLookupTable->SetNumberOfTableValues(numFaces+1);
+  faceLookupTable->SetTableRange(0, numFaces);
+  for (int i = 0; i <= numFaces; i++) {
+    faceLookupTable->SetTableValue(i, 1.0, 1.0, 1.0);
+  }
+  faceLookupTable->Build();
+
+  m_FacesSurface = facesSurface;
+  m_FaceLookupTable = faceLookupTable;
+  m_HighlightedFaceIndex = -1;
+  return true;
+}
+
+//---------------
+// highlightFace
+//---------------
+// Set the lookup table colors of the previous and the new selected face.
+//
+void sv4guiPurkinjeNetworkMeshMapper::highlightFace(int faceIndex)
+{
+  if ((m_FaceLookupTable == nullptr) || (faceIndex == m_HighlightedFaceIndex)) {
+    return;
+  }
+
+  auto numFaces = m_FaceLookupTable->GetNumberOfTableValues() - 1;
+  if ((m_HighlightedFaceIndex >= 0) && (m_HighlightedFaceIndex < numFaces)) {
+    m_FaceLookupTable->SetTableValue(m_HighlightedFaceIndex, 1.0, 1.0, 1.0);
+  }
+  if ((faceIndex >= 0) && (faceIndex < numFaces)) {
+    m_FaceLookupTable->SetTableValue(faceIndex, 1.0, 1.0, 0.0);
+  }
+
+  m_FaceLookupTable->Modified();
+  m_HighlightedFaceIndex = faceIndex;
+}
+
+//-----------------------
+// updateSurfaceLocators
+//-----------------------
+// Build the cell locator used to pick points on the surface mesh.
+//
+// The locator and face point maps are built once for a surface mesh and 
+// rebuilt only when the mesh is replaced or modified.
+//
+void sv4guiPurkinjeNetworkMeshMapper::updateSurfaceLocators(vtkPolyData* surface)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkMeshMapper::updateSurfaceLocators] ";
+
+  if ((surface == m_LocatorSurface) && (surface->GetMTime() == m_LocatorSurfaceMTime)) {
+    return;
+  }
+
+  MITK_INFO << msgPrefix << "Build locator for " << surface->GetNumberOfCells() << " cells.";
+  m_SurfaceCellLocator = vtkSmartPointer<vtkStaticCellLocator>::New();
+  m_SurfaceCellLocator->SetDataSet(surface);
+  m_SurfaceCellLocator->BuildLocator();
+
+  m_FacePointMaps.clear();
+  m_LocatorSurface = surface;
+  m_LocatorSurfaceMTime = surface->GetMTime();
+}
+
+//-----------------
+// getFacePointMap
+//-----------------
+// Get the map from surface point IDs to the point IDs of a face.
+//
+// The map is the inverse of the face point IDs stored with the mesh 
+// container face partition. Surface points not on the face are mapped 
+// to -1.
+//
+const std::vector<vtkIdType>& sv4guiPurkinjeNetworkMeshMapper::getFacePointMap(
+    sv4guiPurkinjeNetworkMeshContainer* mesh, int faceIndex)
+{
+  auto it = m_FacePointMaps.find(faceIndex);
+  if (it != m_FacePointMaps.end()) {
+    return it->second;
+  }
+
+  auto& pointMap = m_FacePointMaps[faceIndex];
+  pointMap.assign(m_LocatorSurface->GetNumberOfPoints(), -1);
+
+  auto& facePointIds = mesh->GetFacePointIds(faceIndex);
+  for (vtkIdType i = 0; i < facePointIds.size(); i++) {
+    pointMap[facePointIds[i]] = i;
+  }
+
+  return pointMap;
 }
 
 //-----------------
@@ -282,12 +350,15 @@ std::vector<vtkSmartPointer<vtkPolyData>> sv4guiPurkinjeNetworkMeshMapper::GetFa
 // opposite the picked point and is used to determine the direction of the
 // first segment of the purkinje network. 
 //
+// The surface locators and the map from surface to face point IDs are cached
+// so the cost of a pick does not depend on the size of the mesh. 
+//
 // [TODO:DaveP] We need to prevent selecting points on faces that are not selected. 
 // I'm not sure how to do that yet so for now check that the selected point is on 
 // the selected face.
 //
 bool sv4guiPurkinjeNetworkMeshMapper::findClosestFace(sv4guiPurkinjeNetworkMeshContainer* mesh, 
-       vtkSmartPointer<vtkPolyData> facePolyData, mitk::Point3D& point)
+       int faceIndex, mitk::Point3D& point)
 {
   std::string msgPrefix = "[sv4guiPurkinjeNetworkMeshMapper::findClosestFace] ";
   //MITK_INFO <<  msgPrefix << "========== findClosestFace ==========";
@@ -299,11 +370,10 @@ bool sv4guiPurkinjeNetworkMeshMapper::findClosestFace(sv4guiPurkinjeNetworkMeshC
 
   //MITK_INFO << msgPrefix << "Query point: " << point[0] << " " << point[1] << " " << point[2];
   auto polyMesh = surfaceMesh->GetSurfaceMesh();
-
-  // Build the cell locator.
-  vtkSmartPointer<vtkCellLocator> cellLocator = vtkSmartPointer<vtkCellLocator>::New();
-  cellLocator->SetDataSet(polyMesh);
-  cellLocator->BuildLocator();
+  if (polyMesh == nullptr) {
+    return false;
+  }
+  updateSurfaceLocators(polyMesh);
 
   // Find the closest point.
   double testPoint[3] = {point[0], point[1], point[2]};
@@ -311,38 +381,27 @@ bool sv4guiPurkinjeNetworkMeshMapper::findClosestFace(sv4guiPurkinjeNetworkMeshC
   double closestPointDist2; 
   vtkIdType cellId; 
   int subId; 
-  cellLocator->FindClosestPoint(testPoint, closestPoint, cellId, subId, closestPointDist2);
-  
-  /*
-  MITK_INFO << "Coordinates of closest point: " << closestPoint[0] << " " << closestPoint[1] << " " << closestPoint[2];
-  MITK_INFO << "Squared distance to closest point: " << closestPointDist2;
-  MITK_INFO << "CellId: " << cellId;
-  MITK_INFO << msgPrefix + "CellId: " << cellId;
-  MITK_INFO << msgPrefix + "subId: " << subId;
-  MITK_INFO << msgPrefix << "polyMesh num cells: " << polyMesh->GetNumberOfCells();
-  MITK_INFO << msgPrefix << "CellId: " << cellId;
-  */
-
-  vtkCell* cell = polyMesh->GetCell(cellId);
-  if (cell == nullptr) {
+  m_SurfaceCellLocator->FindClosestPoint(testPoint, closestPoint, cellId, subId, closestPointDist2);
+
+  if ((cellId < 0) || (polyMesh->GetCellType(cellId) != VTK_TRIANGLE)) {
     return false;
   }
 
   // Get the points on the face.
-  vtkTriangle* triangle = dynamic_cast<vtkTriangle*>(cell);
-  double pt[3], p0[3], p1[3], p2[3], minPt[3];
-  triangle->GetPoints()->GetPoint(0, p0);
-  triangle->GetPoints()->GetPoint(1, p1);
-  triangle->GetPoints()->GetPoint(2, p2);
-  vtkSmartPointer<vtkPoints> points = triangle->GetPoints();
+  auto ptIds = vtkSmartPointer<vtkIdList>::New();
+  polyMesh->GetCellPoints(cellId, ptIds);
+  double p[3][3];
+  for (int i = 0; i < 3; i++) {
+    polyMesh->GetPoint(ptIds->GetId(i), p[i]);
+  }
 
   // Find the closest face vertex.
   //
   double d, minDist = 1e9;
   int minIndex = -1;
   for (int i = 0; i < 3; i++) {
-    triangle->GetPoints()->GetPoint(i, pt);
-    d = (pt[0]-point[0])*(pt[0]-point[0]) + (pt[1]-point[1])*(pt[1]-point[1]) + (pt[2]-point[2])*(pt[2]-point[2]);
+    d = (p[i][0]-point[0])*(p[i][0]-point[0]) + (p[i][1]-point[1])*(p[i][1]-point[1]) + 
+        (p[i][2]-point[2])*(p[i][2]-point[2]);
     if (d < minDist) {
       minDist = d;
       minIndex = i;
@@ -350,27 +409,17 @@ bool sv4guiPurkinjeNetworkMeshMapper::findClosestFace(sv4guiPurkinjeNetworkMeshC
   }
 
   // Set the picked point to the closest face vertex.
-  triangle->GetPoints()->GetPoint(minIndex, minPt);
   for (int i = 0; i < 3; i++) {
-    point[i] = minPt[i];
+    point[i] = p[minIndex][i];
   }
   //MITK_INFO << msgPrefix << "Min point: " << point[0] << "  " << point[1] << "  " << point[2]; 
 
   // Check that the point is on the currently selected face.
   //
-  minDist = 1e9;
-  minIndex = -1;
-  for (vtkIdType i = 0; i < facePolyData->GetNumberOfPoints(); i++) {
-    double pt[3];
-    facePolyData->GetPoint(i,pt);
-    d = (pt[0]-point[0])*(pt[0]-point[0]) + (pt[1]-point[1])*(pt[1]-point[1]) + (pt[2]-point[2])*(pt[2]-point[2]);
-    if (d < minDist) {
-      minDist = d;
-      minIndex = i;
-    }
-  }
-  MITK_INFO << msgPrefix << "Face points min dist: " << minDist; 
-  if (minDist != 0.0) {
+  auto& facePointMap = getFacePointMap(mesh, faceIndex);
+  auto facePointID = facePointMap[ptIds->GetId(minIndex)];
+  MITK_INFO << msgPrefix << "Face point ID: " << facePointID; 
+  if (facePointID == -1) {
     return false;
   }
 
@@ -378,13 +427,7 @@ bool sv4guiPurkinjeNetworkMeshMapper::findClosestFace(sv4guiPurkinjeNetworkMeshC
   // edge oposite the closest face vertex.
   for (int i = 0; i < 3; i++) {
     m_point1[i] = point[i];
-    if (minIndex == 0) {
-      m_point2[i] = (p1[i] + p2[i]) / 2.0;
-    } else if (minIndex == 1) {
-      m_point2[i] = (p0[i] + p2[i]) / 2.0;
-    } else {
-      m_point2[i] = (p0[i] + p1[i]) / 2.0;
-    }
+    m_point2[i] = (p[(minIndex+1)%3][i] + p[(minIndex+2)%3][i]) / 2.0;
   }
 
   return true;
@@ -396,11 +439,17 @@ void sv4guiPurkinjeNetworkMeshMapper::ResetMapper(mitk::BaseRenderer* renderer)
   ls->m_PropAssembly->VisibilityOff();
 }
 
+//------------
+// GetVtkProp
+//------------
+// Get the prop assembly for a renderer. 
+//
+// The prop assembly is updated by GenerateDataForRenderer() when the 
+// renderer updates its mappers, not each time the prop is requested.
+//
 vtkProp* sv4guiPurkinjeNetworkMeshMapper::GetVtkProp(mitk::BaseRenderer* renderer)
 {
   //MITK_INFO << "[sv4guiPurkinjeNetworkMeshMapper::GetVtkProp] ";
-  ResetMapper(renderer);
-  GenerateDataForRenderer(renderer);
   LocalStorage *ls = m_LSH.GetLocalStorage(renderer);
   return ls->m_PropAssembly;
 }
@@ -49,7 +49,11 @@
 #include <vtkActor.h>
 #include <vtkSmartPointer.h>
 #include <vtkActor.h>
+#include <vtkLookupTable.h>
+#include <vtkStaticCellLocator.h>
+#include <map>
 #include <string>
+#include <vector>
 
 class sv4guiPurkinjeNetworkMeshMapper : public mitk::VtkMapper
 {
@@ -64,10 +68,11 @@ public:
     {
     public:
         vtkSmartPointer<vtkAssembly> m_PropAssembly;
-        std::vector<vtkSmartPointer<vtkActor>> m_FaceActors;
-        std::vector<vtkSmartPointer<vtkPolyData>> m_FacePolyData;
+        vtkSmartPointer<vtkActor> m_SurfaceActor;
+        unsigned long m_RenderDataMTime;
         LocalStorage() {
             m_PropAssembly = vtkSmartPointer<vtkAssembly>::New();
+            m_RenderDataMTime = 0;
         }
         ~LocalStorage() { }
     };
@@ -83,16 +88,13 @@ public:
     double m_seedRadius = 0.5;
     double m_pickRadius = 0.5;
 
-    bool m_newMesh = true;
-
     double m_point1[3];
     double m_point2[3];
 
     vtkSmartPointer<vtkActor> m_SphereActor;
     vtkSmartPointer<vtkActor> m_LineActor;
 
-    std::vector<vtkSmartPointer<vtkActor>> GetFaceActors(mitk::BaseRenderer* renderer);
-    std::vector<vtkSmartPointer<vtkPolyData>> GetFacePolyData(mitk::BaseRenderer* renderer);
+    vtkSmartPointer<vtkActor> GetSurfaceActor(mitk::BaseRenderer* renderer);
 
 protected:
     sv4guiPurkinjeNetworkMeshMapper();
@@ -105,8 +107,25 @@ protected:
 
     vtkSmartPointer<vtkActor> createSphereActor(mitk::Point3D& point);
     vtkSmartPointer<vtkActor> createLineActor();
-    bool findClosestFace(sv4guiPurkinjeNetworkMeshContainer* mesh, vtkSmartPointer<vtkPolyData> facePolyData, 
-           mitk::Point3D& point);
+    bool updateRenderData(sv4guiPurkinjeNetworkMeshContainer* mesh);
+    void highlightFace(int faceIndex);
+    bool findClosestFace(sv4guiPurkinjeNetworkMeshContainer* mesh, int faceIndex, mitk::Point3D& point);
+    void updateSurfaceLocators(vtkPolyData* surface);
+    const std::vector<vtkIdType>& getFacePointMap(sv4guiPurkinjeNetworkMeshContainer* mesh, int faceIndex);
+
+    // Render data shared by all renderers, rebuilt when the mesh container is modified.
+    vtkSmartPointer<vtkPolyData> m_FacesSurface;
+    vtkSmartPointer<vtkLookupTable> m_FaceLookupTable;
+    int m_HighlightedFaceIndex = -1;
+    unsigned long m_RenderDataMTime = 0;
+
+    // Picking data built once per surface mesh. 
+    vtkPolyData* m_LocatorSurface = nullptr;
+    vtkMTimeType m_LocatorSurfaceMTime = 0;
+    vtkSmartPointer<vtkStaticCellLocator> m_SurfaceCellLocator;
+
+    // Maps surface point IDs to face point IDs (-1 if not on the face) for each face index.
+    std::map<int, std::vector<vtkIdType>> m_FacePointMaps;
 };
 
 #endif /* SV4GUIPURKINJENETWORKMAPPER_H */
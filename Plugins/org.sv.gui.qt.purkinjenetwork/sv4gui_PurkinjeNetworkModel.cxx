@@ -31,17 +31,42 @@
 
 #include <Python.h>
 
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <map>
+#include <sstream>
 #include "sv4gui_PurkinjeNetworkModel.h"
+#include "sv4gui_PurkinjeNetworkActivation.h"
+#include "sv4gui_PurkinjeNetworkCable.h"
+#include "sv4gui_PurkinjeNetworkColonization.h"
+#include "sv4gui_PurkinjeNetworkCoupling.h"
+#include "sv4gui_PurkinjeNetworkCoverage.h"
+#include "sv4gui_PurkinjeNetworkPartition.h"
+#include "sv4gui_PurkinjeNetworkReorder.h"
+#include "sv4gui_PurkinjeNetworkResample.h"
+#include "sv4gui_PurkinjeNetworkSurfaceActivation.h"
+#include "sv4gui_PurkinjeNetworkUtils.h"
+#include "sv4gui_PurkinjeNetworkVolumeActivation.h"
 #include <mitkLogMacros.h>
 
+#include <vtkGenericCell.h>
+#include <vtkMetaImageReader.h>
+#include <vtkQuadricDecimation.h>
+#include <vtkSMPThreadLocalObject.h>
+#include <vtkSMPTools.h>
+#include <vtkStaticCellLocator.h>
+#include <vtkTriangleFilter.h>
+#include <vtkXMLImageDataReader.h>
 #include <vtkXMLPolyDataWriter.h>
 
 //-------------
 // Constructor
 //-------------
 sv4guiPurkinjeNetworkModel::sv4guiPurkinjeNetworkModel(const std::string name, const std::array<double,3>& firstPoint,
-    const std::array<double,3>& secondPoint) : name(name), firstPoint(firstPoint), secondPoint(secondPoint)
+    const std::array<double,3>& secondPoint) : name(name), firstPoint(firstPoint), secondPoint(secondPoint), 
+    networkComplete(true)
 {
 
 }
@@ -98,19 +123,1140 @@ bool sv4guiPurkinjeNetworkModel::GenerateNetwork(const std::string outputPath)
   auto outfile = outputPath + "/" + this->name;
   MITK_INFO << msgPrefix << "Output network file " << outfile;
 
+  // Compute the distance field used to grow the network on an implicit surface.
+  if (!ComputeDistanceField(outputPath)) {
+    return false;
+  }
+
+  // Search for fractal tree parameters producing a network with the target calibration metric.
+  if (!UseSpaceColonization() && !CalibrateParameters(meshFileName, outfile)) {
+    return false;
+  }
+
+  if (!GrowNetwork(meshPolyData, meshFileName, outfile)) {
+    return false;
+  }
+  MITK_INFO << msgPrefix << "Done!";
+
+  return ProcessNetwork(outputPath);
+}
+
+//-------------
+// GrowNetwork
+//-------------
+// Grow a network on a surface using the algorithm given by the 
+// 'growthAlgorithm' parameter.
+//
+// The fractal tree is grown by executing the Python fractal tree code 
+// on the surface written to 'meshFileName'. The network files are 
+// written using the 'outfile' prefix.
+
+bool sv4guiPurkinjeNetworkModel::GrowNetwork(vtkPolyData* surface, const std::string meshFileName, 
+    const std::string outfile)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkModel::GrowNetwork] ";
+
+  if (UseSpaceColonization()) {
+    return GrowColonizationNetwork(surface, outfile);
+  }
+
   // Execute the Python command used to generate the Purkinje network. 
   auto cmd = CreateCommand(meshFileName, outfile);
   MITK_INFO << msgPrefix << "Execute cmd " << cmd;
   auto error = PyRun_SimpleString(cmd.c_str());
-  MITK_INFO << msgPrefix << "Done!";
 
   if (error != 0) {
     MITK_WARN << msgPrefix << "Error: " << error;
     return false;
   }
 
+  return true;
+}
+
+//----------------------
+// UseSpaceColonization
+//----------------------
+// Check if the 'growthAlgorithm' parameter selects space colonization.
+
+bool sv4guiPurkinjeNetworkModel::UseSpaceColonization()
+{
+  auto it = parameterValues.find(parameterNames.GrowthAlgorithm);
+  return (it != parameterValues.end()) && (it->second == "spaceColonization");
+}
+
+//---------------------------
+// GetColonizationParameters
+//---------------------------
+// Get the attractor spacing and segment length used by space colonization.
+//
+// Attractors are sampled using the 'attractorSpacing' parameter and 
+// segments are grown using the 'branchSegLength' parameter. The segment 
+// length is limited to half the attractor spacing.
+
+bool sv4guiPurkinjeNetworkModel::GetColonizationParameters(double& spacing, double& segmentLength)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkModel::GetColonizationParameters] ";
+
+  auto it = parameterValues.find(parameterNames.AttractorSpacing);
+  spacing = (it != parameterValues.end()) ? std::stod(it->second) : 0.0;
+  if (spacing <= 0.0) {
+    MITK_ERROR << msgPrefix << "The attractor spacing must be positive.";
+    return false;
+  }
+
+  segmentLength = std::stod(parameterValues[parameterNames.BranchSegLength]);
+  if (segmentLength > 0.5 * spacing) {
+    MITK_WARN << msgPrefix << "The segment length " << segmentLength << " is limited to " << 0.5 * spacing;
+    segmentLength = 0.5 * spacing;
+  }
+  MITK_INFO << msgPrefix << "Attractor spacing " << spacing << "  segment length " << segmentLength;
+  return true;
+}
+
+//-------------------------
+// GrowColonizationNetwork
+//-------------------------
+// Grow a network on a surface using space colonization.
+
+bool sv4guiPurkinjeNetworkModel::GrowColonizationNetwork(vtkPolyData* surface, const std::string outfile)
+{
+  double spacing, segmentLength;
+  if (!GetColonizationParameters(spacing, segmentLength)) {
+    return false;
+  }
+
+  sv4guiPurkinjeNetworkColonization colonization(surface);
+  colonization.SetAttractorSpacing(spacing);
+  colonization.SetSegmentLength(segmentLength);
+
+  sv4guiPurkinjeNetworkGraph network;
+  if (!colonization.Grow(firstPoint, secondPoint, network)) {
+    return false;
+  }
+
+  return network.Write(outfile) && network.WriteVtu(outfile + ".vtu");
+}
+
+//------------------
+// GetBranchSubtree
+//------------------
+// Get the subtree made of a branch and the branches below it, on the side 
+// of the branch away from the root. 'startNode' returns the branch node 
+// the subtree is attached to.
+
+bool sv4guiPurkinjeNetworkModel::GetBranchSubtree(const sv4guiPurkinjeNetworkGraph& network, 
+    const sv4guiPurkinjeNetworkGraph::Branch& branch, int& startNode, std::vector<int>& nodes, 
+    std::vector<int>& segments)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkModel::GetBranchSubtree] ";
+
+  if ((branch.nodes.size() < 2) || !network.HaveAdjacency()) {
+    MITK_ERROR << msgPrefix << "The branch is not part of the network.";
+    return false;
+  }
+
+  int numNodes = branch.nodes.size();
+  startNode = branch.nodes[0];
+  if (!network.GetSubtree(branch.nodes[1], startNode, nodes, segments)) {
+    startNode = branch.nodes[numNodes-1];
+    if (!network.GetSubtree(branch.nodes[numNodes-2], startNode, nodes, segments)) {
+      MITK_ERROR << msgPrefix << "The branch is in a loop.";
+      return false;
+    }
+  }
+
+  MITK_INFO << msgPrefix << "Start node " << startNode << "  subtree nodes " << nodes.size() 
+      << "  segments " << segments.size();
+  return true;
+}
+
+//--------------
+// RemoveBranch
+//--------------
+// Create the change that removes a branch and the subtree below it.
+//
+// The node the subtree was attached to becomes an end node if it is 
+// left with a single segment.
+
+bool sv4guiPurkinjeNetworkModel::RemoveBranch(const sv4guiPurkinjeNetworkGraph& network, 
+    const sv4guiPurkinjeNetworkGraph::Branch& branch, sv4guiPurkinjeNetworkGraph::Change& change)
+{
+  int startNode;
+  std::vector<int> removedNodes, removedSegments;
+  if (!GetBranchSubtree(network, branch, startNode, removedNodes, removedSegments)) {
+    return false;
+  }
+
+  int degree = network.GetDegree(startNode);
+  for (auto segment : removedSegments) {
+    const auto& segmentNodes = network.GetSegments()[segment];
+    degree -= (segmentNodes[0] == startNode) + (segmentNodes[1] == startNode);
+  }
+
+  std::vector<int> endNodes;
+  if ((degree == 1) && (startNode != network.GetRootNode())) {
+    endNodes.push_back(startNode);
+  }
+
+  network.CreateReplaceChange(removedNodes, removedSegments, {}, {}, endNodes, change);
+  return true;
+}
+
+//--------------
+// RegrowBranch
+//--------------
+// Create the change that removes a branch and the subtree below it and 
+// regrows the subtree from the start of the branch.
+//
+// The subtree is regrown on the surface mesh using space colonization 
+// with the current 'attractorSpacing' and 'branchSegLength' parameters, 
+// whatever the 'growthAlgorithm' parameter, so the parameters can be set 
+// locally for the regrown part of the network. 'segmentTree' must have 
+// been built for 'network'.
+
+bool sv4guiPurkinjeNetworkModel::RegrowBranch(const sv4guiPurkinjeNetworkGraph& network, 
+    const sv4guiPurkinjeNetworkSegmentTree& segmentTree, const sv4guiPurkinjeNetworkGraph::Branch& branch, 
+    sv4guiPurkinjeNetworkGraph::Change& change)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkModel::RegrowBranch] ";
+
+  if (meshPolyData == nullptr) {
+    MITK_ERROR << msgPrefix << "No surface mesh has been loaded.";
+    return false;
+  }
+
+  int startNode;
+  std::vector<int> removedNodes, removedSegments;
+  if (!GetBranchSubtree(network, branch, startNode, removedNodes, removedSegments)) {
+    return false;
+  }
+
+  double spacing, segmentLength;
+  if (!GetColonizationParameters(spacing, segmentLength)) {
+    return false;
+  }
+
+  sv4guiPurkinjeNetworkColonization colonization(meshPolyData);
+  colonization.SetAttractorSpacing(spacing);
+  colonization.SetSegmentLength(segmentLength);
+
+  std::vector<sv4guiPurkinjeNetworkGraph::Point> nodes;
+  std::vector<sv4guiPurkinjeNetworkGraph::Segment> segments;
+  std::vector<int> endNodes;
+  if (!colonization.Regrow(network, segmentTree, startNode, removedSegments, nodes, segments, endNodes)) {
+    return false;
+  }
+
+  network.CreateReplaceChange(removedNodes, removedSegments, nodes, segments, endNodes, change);
+  MITK_INFO << msgPrefix << "Changed nodes " << change.nodeIds.size() << "  segments " << change.segmentIds.size();
+  return true;
+}
+
+//-----------------
+// GeneratePreview
+//-----------------
+// Generate a coarse preview of a Purkinje network.
+//
+// The surface mesh is decimated by the 'previewReduction' parameter (the fraction 
+// of triangles removed) and the network is grown on the coarse surface using a 
+// branch segment length scaled by the ratio of the coarse and fine edge lengths. 
+// The network nodes are then projected onto the surface mesh.
+//
+// The coarse surface and network files are written using the FACENAME_preview 
+// prefix, the network is not activated, resampled or coupled.
+
+bool sv4guiPurkinjeNetworkModel::GeneratePreview(const std::string outputPath)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkModel::GeneratePreview] ";
+  MITK_INFO << msgPrefix << "Output path " << outputPath;
+  this->previewNetworkFileName = "";
+
+  if (meshPolyData == nullptr) {
+    MITK_ERROR << msgPrefix << "No surface mesh has been loaded.";
+    return false;
+  }
+
+  double reduction = 0.9;
+  auto it = parameterValues.find(parameterNames.PreviewReduction);
+  if (it != parameterValues.end()) {
+    reduction = std::stod(it->second);
+  }
+  if ((reduction < 0.0) || (reduction >= 1.0)) {
+    MITK_ERROR << msgPrefix << "The preview reduction must be in [0,1).";
+    return false;
+  }
+
+  // Decimate the surface mesh.
+  auto startTime = std::chrono::steady_clock::now();
+  auto triangulate = vtkSmartPointer<vtkTriangleFilter>::New();
+  triangulate->SetInputData(meshPolyData);
+  auto decimate = vtkSmartPointer<vtkQuadricDecimation>::New();
+  decimate->SetInputConnection(triangulate->GetOutputPort());
+  decimate->SetTargetReduction(reduction);
+  decimate->Update();
+  vtkSmartPointer<vtkPolyData> coarseMesh = decimate->GetOutput();
+
+  auto numFine = triangulate->GetOutput()->GetNumberOfCells();
+  auto numCoarse = coarseMesh->GetNumberOfCells();
+  if (numCoarse == 0) {
+    MITK_ERROR << msgPrefix << "The decimated surface mesh has no triangles.";
+    return false;
+  }
+  double scale = std::sqrt(static_cast<double>(numFine) / numCoarse);
+  MITK_INFO << msgPrefix << "Number of triangles " << numFine << " -> " << numCoarse << "  edge length scale " << scale;
+
+  auto meshFileName = outputPath + "/" + this->name + "_preview.vtp";
+  auto writer = vtkSmartPointer<vtkXMLPolyDataWriter>::New();
+  writer->SetFileName(meshFileName.c_str());
+  writer->SetInputData(coarseMesh);
+  writer->Write();
+
+  if (!ComputeDistanceField(outputPath)) {
+    return false;
+  }
+
+  // Grow the network on the coarse surface.
+  auto outfile = outputPath + "/" + this->name + "_preview";
+  auto branchSegLength = parameterValues[parameterNames.BranchSegLength];
+  parameterValues[parameterNames.BranchSegLength] = std::to_string(scale * std::stod(branchSegLength));
+  auto grown = GrowNetwork(coarseMesh, meshFileName, outfile);
+  parameterValues[parameterNames.BranchSegLength] = branchSegLength;
+  if (!grown) {
+    return false;
+  }
+
+  // Map the network back to the surface mesh.
+  sv4guiPurkinjeNetworkGraph network;
+  if (!network.Read(outfile) || !ProjectNetwork(network, meshPolyData)) {
+    return false;
+  }
+
+  this->previewNetworkFileName = outfile + ".vtu";
+  if (!network.Write(outfile) || !network.WriteVtu(this->previewNetworkFileName)) {
+    return false;
+  }
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+  MITK_INFO << msgPrefix << "Preview time " << elapsed.count() << " s";
+  return true;
+}
+
+//----------------
+// ProjectNetwork
+//----------------
+// Move each network node to the closest point on a surface.
+
+bool sv4guiPurkinjeNetworkModel::ProjectNetwork(sv4guiPurkinjeNetworkGraph& network, vtkPolyData* surface)
+{
+  auto locator = vtkSmartPointer<vtkStaticCellLocator>::New();
+  locator->SetDataSet(surface);
+  locator->BuildLocator();
+
+  auto nodes = network.GetNodes();
+  vtkSMPThreadLocalObject<vtkGenericCell> cells;
+
+  auto projectNodes = [&](vtkIdType begin, vtkIdType end) {
+    auto cell = cells.Local();
+    double closestPoint[3], dist2;
+    vtkIdType cellId;
+    int subId;
+    for (vtkIdType i = begin; i < end; i++) {
+      locator->FindClosestPoint(nodes[i].data(), closestPoint, cell, cellId, subId, dist2);
+      if (cellId != -1) {
+        std::copy(closestPoint, closestPoint+3, nodes[i].begin());
+      }
+    }
+  };
+  vtkSMPTools::For(0, nodes.size(), projectNodes);
+
+  network.SetNodes(nodes);
+  return true;
+}
+
+//-----------------
+// CompleteNetwork
+//-----------------
+// Grow the remaining branch generations of a network whose generation 
+// was stopped by the 'timeBudget' parameter.
+//
+// The network state is kept by the Python fractal_tree module so this 
+// must follow GenerateNetwork() for the same face.
+
+bool sv4guiPurkinjeNetworkModel::CompleteNetwork(const std::string outputPath)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkModel::CompleteNetwork] ";
+  MITK_INFO << msgPrefix << "Output path " << outputPath;
+
+  std::string cmd;
+  cmd += "import fractal_tree\n";
+  cmd += "fractal_tree.resume()\n";
+  MITK_INFO << msgPrefix << "Execute cmd " << cmd;
+
+  auto error = PyRun_SimpleString(cmd.c_str());
+  if (error != 0) {
+    MITK_WARN << msgPrefix << "Error: " << error;
+    return false;
+  }
+
+  return ProcessNetwork(outputPath);
+}
+
+//--------------------
+// GetNetworkComplete
+//--------------------
+// Check if the Python fractal_tree module grew all of the branch generations 
+// of the last network. Networks grown by space colonization are always complete.
+
+bool sv4guiPurkinjeNetworkModel::GetNetworkComplete()
+{
+  if (UseSpaceColonization()) {
+    return true;
+  }
+
+  auto module = PyImport_ImportModule("fractal_tree");
+  if (module == nullptr) {
+    PyErr_Clear();
+    return true;
+  }
+
+  bool complete = true;
+  auto value = PyObject_GetAttrString(module, "tree_complete");
+  if (value != nullptr) {
+    complete = PyObject_IsTrue(value);
+    Py_DECREF(value);
+  } else {
+    PyErr_Clear();
+  }
+
+  Py_DECREF(module);
+  return complete;
+}
+
+//----------------
+// ProcessNetwork
+//----------------
+// Read the network written by the Python fractal tree code and compute 
+// resampled networks, orderings, partitions, activation times, coupling 
+// and coverage from it.
+
+bool sv4guiPurkinjeNetworkModel::ProcessNetwork(const std::string outputPath)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkModel::ProcessNetwork] ";
+  auto outfile = outputPath + "/" + this->name;
+
+  this->networkComplete = GetNetworkComplete();
+  if (!this->networkComplete) {
+    MITK_INFO << msgPrefix << "The time budget expired before all branch generations were grown.";
+  }
+
   // Set the name of the file containing the network of 1D elements.
   this->networkFileName = outputPath + "/" + this->name + ".vtu";
+
+  sv4guiPurkinjeNetworkGraph network;
+  if (!network.Read(outfile)) {
+    return false;
+  }
+
+  // Compute activation times from the root node.
+  bool activated;
+  if (!ComputeActivation(network, activated)) {
+    return false;
+  }
+
+  // Resample the network to a uniform element size.
+  if (!ResampleNetwork(network, outputPath)) {
+    return false;
+  }
+
+  // Renumber and partition the network.
+  bool reordered, partitioned;
+  if (!ReorderNetwork(network, outfile, reordered) || !PartitionNetwork(network, outfile, partitioned)) {
+    return false;
+  }
+
+  if (activated || reordered || partitioned) {
+    if (!network.Write(outfile) || !network.WriteVtu(this->networkFileName)) {
+      return false;
+    }
+  }
+
+  // Couple the network end nodes to the volume mesh.
+  if (!CoupleNetwork(network, outfile)) {
+    return false;
+  }
+
+  // Measure how well the network covers the surface mesh.
+  if (!ComputeCoverage(network, outfile)) {
+    return false;
+  }
+
+  // Propagate activation from the end nodes over the surface and through the volume mesh.
+  if (activated && (!ComputeSurfaceActivation(network, outfile) || !ComputeVolumeActivation(network, outfile))) {
+    return false;
+  }
+
+  // Simulate propagation on the resampled network if there is one.
+  if (this->resampledNetworkFileName == "") {
+    return SimulateCable(network, outfile);
+  }
+
+  return true;
+}
+
+//---------------------
+// CalibrateParameters
+//---------------------
+// Search for the 'avgBranchLength', 'numBranchGenerations' and 'repulsiveParameter' 
+// values producing a network with the target value of the metric given by the 
+// 'calibrationMetric' parameter: 
+//
+//   endNodes - The number of network end nodes.
+//   coverage - The percentage of surface area within 'coverageDistance' of the network segments.
+//
+// The search is performed by the Python calibrate_network module, growing at most 
+// 'calibrationEvaluations' coarse networks on the surface mesh. The best parameters 
+// are written to 'outfile'_calibrated_parameters.txt and replace the values of 
+// those parameters used to generate the network.
+
+bool sv4guiPurkinjeNetworkModel::CalibrateParameters(const std::string infile, const std::string outfile)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkModel::CalibrateParameters] ";
+  this->calibratedParameterFileName = "";
+
+  auto it = parameterValues.find(parameterNames.CalibrationMetric);
+  if ((it == parameterValues.end()) || (it->second == "") || (it->second == "none")) {
+    return true;
+  }
+
+  std::string metric;
+  if (it->second == "endNodes") {
+    metric = "end_nodes";
+  } else if (it->second == "coverage") {
+    metric = "coverage";
+  } else {
+    MITK_ERROR << msgPrefix << "Unknown calibration metric '" << it->second << "'.";
+    return false;
+  }
+  MITK_INFO << msgPrefix << "Calibration metric " << it->second;
+
+  auto target = parameterValues[parameterNames.CalibrationTarget];
+  if ((target == "") || (std::stod(target) <= 0.0)) {
+    MITK_ERROR << msgPrefix << "The calibration target must be positive.";
+    return false;
+  }
+
+  auto coverageDistance = parameterValues[parameterNames.CoverageDistance];
+  if ((metric == "coverage") && ((coverageDistance == "") || (std::stod(coverageDistance) <= 0.0))) {
+    MITK_ERROR << msgPrefix << "Coverage calibration requires a positive coverage distance.";
+    return false;
+  }
+
+  auto maxEvaluations = parameterValues[parameterNames.CalibrationEvaluations];
+  if (maxEvaluations == "") {
+    maxEvaluations = "40";
+  }
+
+  auto fileName = outfile + "_calibrated_parameters.txt";
+  std::remove(fileName.c_str());
+
+  std::string cmd;
+  cmd += "import calibrate_network\n";
+  cmd += "calibrate_network.calibrate(";
+  cmd += "infile='" + infile + "',";
+  cmd += "outfile='" + outfile + "',";
+  cmd += "init_node='[" + parameterValues[parameterNames.FirstPoint] + "]',";
+  cmd += "second_node='[" + parameterValues[parameterNames.SecondPoint] +  "]',";
+  cmd += "avg_branch_length='" + parameterValues[parameterNames.AvgBranchLength] +  "',";
+  cmd += "branch_angle='" + parameterValues[parameterNames.BranchAngle] + "',";
+  cmd += "branch_seg_length='" + parameterValues[parameterNames.BranchSegLength] + "',";
+  cmd += "num_branch_gen='" + parameterValues[parameterNames.NumBranchGenerations] + "',";
+  cmd += "repulsive_parameter='" + parameterValues[parameterNames.RepulsiveParameter] + "',";
+  cmd += "metric='" + metric + "',";
+  cmd += "target='" + target + "',";
+  cmd += "coverage_distance='" + (coverageDistance == "" ? std::string("0") : coverageDistance) + "',";
+  cmd += "max_evaluations='" + maxEvaluations + "'";
+  cmd += ")\n";
+
+  MITK_INFO << msgPrefix << "Execute cmd " << cmd;
+  if (PyRun_SimpleString(cmd.c_str()) != 0) {
+    MITK_ERROR << msgPrefix << "The calibration failed.";
+    return false;
+  }
+
+  // Read the calibrated parameters.
+  std::ifstream paramFile(fileName);
+  if (!paramFile.is_open()) {
+    MITK_ERROR << msgPrefix << "The calibration did not produce " << fileName;
+    return false;
+  }
+
+  std::string line, name, value;
+  while (std::getline(paramFile, line)) {
+    std::stringstream ss(line);
+    ss >> name >> value;
+    if ((name == parameterNames.AvgBranchLength) || (name == parameterNames.NumBranchGenerations) || 
+        (name == parameterNames.RepulsiveParameter)) {
+      MITK_INFO << msgPrefix << "Calibrated " << name << " " << value;
+      parameterValues[name] = value;
+    }
+  }
+
+  this->calibratedParameterFileName = fileName;
+  return true;
+}
+
+//-----------------
+// ResampleNetwork
+//-----------------
+// Resample the generated network to a near-uniform element size.
+//
+// Resampling is skipped if the 'resampleElementSize' parameter is not set or is 0.
+//
+// The resampled network is renumbered and partitioned like the generated 
+// network and written using the FACENAME_resampled prefix together with 
+// FACENAME_resampled_parentseg.txt mapping each resampled segment to the 
+// generated segment it lies on.
+//
+// Activation times are not computed again: the resampled network gets the 
+// activation times of the generated network interpolated by Resample(), so 
+// sources given by node IDs of the generated network are respected.
+
+bool sv4guiPurkinjeNetworkModel::ResampleNetwork(sv4guiPurkinjeNetworkGraph& network, const std::string outputPath)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkModel::ResampleNetwork] ";
+  this->resampledNetworkFileName = "";
+
+  auto it = parameterValues.find(parameterNames.ResampleElementSize);
+  if (it == parameterValues.end()) {
+    return true;
+  }
+
+  double elementSize = std::stod(it->second);
+  if (elementSize <= 0.0) {
+    return true;
+  }
+  MITK_INFO << msgPrefix << "Element size " << elementSize;
+
+  sv4guiPurkinjeNetworkGraph resampled;
+  std::vector<int> parentSegments;
+  if (!sv4guiPurkinjeNetworkResample::Resample(network, elementSize, resampled, parentSegments)) {
+    return false;
+  }
+
+  auto outfile = outputPath + "/" + this->name + "_resampled";
+  if (!sv4guiPurkinjeNetworkResample::WriteParentSegments(outfile, parentSegments)) {
+    return false;
+  }
+
+  bool reordered, partitioned;
+  if (!ReorderNetwork(resampled, outfile, reordered) || !PartitionNetwork(resampled, outfile, partitioned)) {
+    return false;
+  }
+
+  this->resampledNetworkFileName = outfile + ".vtu";
+  if (!resampled.Write(outfile) || !resampled.WriteVtu(this->resampledNetworkFileName)) {
+    return false;
+  }
+
+  if (!CoupleNetwork(resampled, outfile)) {
+    return false;
+  }
+
+  return SimulateCable(resampled, outfile);
+}
+
+//----------------
+// ReorderNetwork
+//----------------
+// Renumber the nodes of a network using the ordering given by the 
+// 'nodeOrdering' parameter.
+//
+// The new index of each original node is written to 'filePrefix'_nodemap.txt.
+// 'reordered' is set to true if the network was renumbered.
+
+bool sv4guiPurkinjeNetworkModel::ReorderNetwork(sv4guiPurkinjeNetworkGraph& network, const std::string filePrefix, 
+    bool& reordered)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkModel::ReorderNetwork] ";
+  reordered = false;
+
+  auto it = parameterValues.find(parameterNames.NodeOrdering);
+  if (it == parameterValues.end()) {
+    return true;
+  }
+
+  sv4guiPurkinjeNetworkReorder::Method method;
+  if (!sv4guiPurkinjeNetworkReorder::GetMethod(it->second, method)) {
+    return false;
+  }
+
+  if (method == sv4guiPurkinjeNetworkReorder::Method::None) {
+    return true;
+  }
+  MITK_INFO << msgPrefix << "Node ordering " << it->second;
+
+  sv4guiPurkinjeNetworkGraph reorderedNetwork;
+  std::vector<int> nodeMap;
+  if (!sv4guiPurkinjeNetworkReorder::Reorder(network, method, reorderedNetwork, nodeMap)) {
+    return false;
+  }
+
+  network = reorderedNetwork;
+  reordered = true;
+  return sv4guiPurkinjeNetworkReorder::WriteNodeMap(filePrefix, nodeMap);
+}
+
+//-------------------
+// ComputeActivation
+//-------------------
+// Compute activation times from the root node of a network 
+// using the conduction velocity given by the 'conductionVelocity' 
+// parameter.
+//
+// If the 'activationSources' parameter names a file of 'node time' pairs 
+// then activation starts from those nodes at those times instead. This is 
+// used for retrograde activation from the end nodes and for multiple 
+// sources. Node IDs refer to the network as grown, before reordering.
+//
+// Activation times are added to the network as point data named 
+// 'ActivationTime'. 'activated' is set to true if activation times 
+// were computed.
+
+bool sv4guiPurkinjeNetworkModel::ComputeActivation(sv4guiPurkinjeNetworkGraph& network, bool& activated)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkModel::ComputeActivation] ";
+  activated = false;
+
+  auto it = parameterValues.find(parameterNames.ConductionVelocity);
+  if (it == parameterValues.end()) {
+    return true;
+  }
+
+  double velocity = std::stod(it->second);
+  if (velocity <= 0.0) {
+    return true;
+  }
+  MITK_INFO << msgPrefix << "Conduction velocity " << velocity;
+
+  std::vector<int> sourceNodes = {network.GetRootNode()};
+  std::vector<double> sourceTimes = {0.0};
+
+  it = parameterValues.find(parameterNames.ActivationSources);
+  if ((it != parameterValues.end()) && (it->second != "")) {
+    MITK_INFO << msgPrefix << "Activation sources " << it->second;
+    if (!sv4guiPurkinjeNetworkActivation::ReadSources(it->second, sourceNodes, sourceTimes)) {
+      return false;
+    }
+    if (sourceNodes.size() == 0) {
+      MITK_ERROR << msgPrefix << "No sources were read from " << it->second;
+      return false;
+    }
+  }
+
+  std::vector<double> activationTimes;
+  if (!sv4guiPurkinjeNetworkActivation::ComputeActivationTimes(network, sourceNodes, sourceTimes, 
+      velocity, activationTimes)) {
+    return false;
+  }
+
+  network.SetPointData("ActivationTime", activationTimes);
+  activated = true;
+  return true;
+}
+
+//-----------------
+// ComputeCoverage
+//-----------------
+// Compute the distance from each surface mesh vertex to the nearest network 
+// segment and the coverage statistics of the network. Vertices farther than 
+// the 'coverageDistance' parameter from the network are uncovered.
+//
+// The surface mesh with distances as point data named 'NetworkDistance' is 
+// written to 'filePrefix'_coverage.vtp and the statistics to 'filePrefix'_coverage.txt.
+
+bool sv4guiPurkinjeNetworkModel::ComputeCoverage(const sv4guiPurkinjeNetworkGraph& network, 
+    const std::string filePrefix)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkModel::ComputeCoverage] ";
+  this->coverageFileName = "";
+  this->coverageReport = "";
+
+  auto it = parameterValues.find(parameterNames.CoverageDistance);
+  if (it == parameterValues.end()) {
+    return true;
+  }
+
+  double coverageDistance = std::stod(it->second);
+  if (coverageDistance <= 0.0) {
+    return true;
+  }
+  MITK_INFO << msgPrefix << "Coverage distance " << coverageDistance;
+
+  if (meshPolyData == nullptr) {
+    MITK_ERROR << msgPrefix << "No surface mesh has been loaded.";
+    return false;
+  }
+
+  sv4guiPurkinjeNetworkSegmentTree segmentTree;
+  segmentTree.Build(network);
+
+  sv4guiPurkinjeNetworkCoverage coverage(meshPolyData);
+  std::vector<double> distances;
+  sv4guiPurkinjeNetworkCoverage::Statistics statistics;
+  if (!coverage.ComputeDistances(segmentTree, distances) || 
+      !coverage.ComputeStatistics(distances, coverageDistance, statistics)) {
+    return false;
+  }
+
+  auto report = coverage.GetReport(statistics, coverageDistance);
+  MITK_INFO << msgPrefix << "Coverage " << report;
+
+  std::ofstream reportFile(filePrefix + "_coverage.txt");
+  if (!reportFile.is_open()) {
+    MITK_ERROR << msgPrefix << "Unable to write " << filePrefix << "_coverage.txt";
+    return false;
+  }
+  reportFile << report;
+  reportFile.close();
+
+  auto fileName = filePrefix + "_coverage.vtp";
+  if (!coverage.Write(fileName, distances)) {
+    return false;
+  }
+
+  this->coverageFileName = fileName;
+  this->coverageReport = report;
+  return true;
+}
+
+//--------------------------
+// ComputeSurfaceActivation
+//--------------------------
+// Compute activation times on the surface mesh from the activation times 
+// of the network end nodes using the conduction velocity given by the 
+// 'myocardialVelocity' parameter.
+//
+// The surface mesh with activation times as point data named 'ActivationTime' 
+// is written to 'filePrefix'_surface_activation.vtp.
+
+bool sv4guiPurkinjeNetworkModel::ComputeSurfaceActivation(const sv4guiPurkinjeNetworkGraph& network, 
+    const std::string filePrefix)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkModel::ComputeSurfaceActivation] ";
+  this->surfaceActivationFileName = "";
+
+  auto it = parameterValues.find(parameterNames.MyocardialVelocity);
+  if (it == parameterValues.end()) {
+    return true;
+  }
+
+  double velocity = std::stod(it->second);
+  if (velocity <= 0.0) {
+    return true;
+  }
+  MITK_INFO << msgPrefix << "Myocardial velocity " << velocity;
+
+  if (meshPolyData == nullptr) {
+    MITK_ERROR << msgPrefix << "No surface mesh has been loaded.";
+    return false;
+  }
+
+  sv4guiPurkinjeNetworkCoupling coupling(meshPolyData);
+  std::vector<vtkIdType> sourceVertices;
+  std::vector<double> sourceTimes;
+  if (!coupling.MapEndNodeTimes(network, velocity, sourceVertices, sourceTimes)) {
+    return false;
+  }
+
+  sv4guiPurkinjeNetworkSurfaceActivation surfaceActivation(meshPolyData);
+  std::vector<double> activationTimes;
+  if (!surfaceActivation.ComputeActivationTimes(sourceVertices, sourceTimes, velocity, activationTimes)) {
+    return false;
+  }
+
+  auto fileName = filePrefix + "_surface_activation.vtp";
+  if (!surfaceActivation.Write(fileName, activationTimes)) {
+    return false;
+  }
+
+  this->surfaceActivationFileName = fileName;
+  return true;
+}
+
+//-------------------------
+// ComputeVolumeActivation
+//-------------------------
+// Compute activation times in the volume mesh from the activation times 
+// of the network end nodes using the method given by the 'volumeActivation' 
+// parameter.
+//
+// The conduction velocity is given by the 'myocardialVelocity' parameter, the 
+// anisotropic method uses it along the mesh 'FIB_DIR' fiber directions and the 
+// 'crossFiberVelocity' parameter across them.
+//
+// The volume mesh with activation times as point data named 'ActivationTime' 
+// is written to 'filePrefix'_volume_activation.vtu.
+
+bool sv4guiPurkinjeNetworkModel::ComputeVolumeActivation(const sv4guiPurkinjeNetworkGraph& network, 
+    const std::string filePrefix)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkModel::ComputeVolumeActivation] ";
+  this->volumeActivationFileName = "";
+
+  auto it = parameterValues.find(parameterNames.VolumeActivation);
+  if (it == parameterValues.end()) {
+    return true;
+  }
+
+  sv4guiPurkinjeNetworkVolumeActivation::Method method;
+  if (!sv4guiPurkinjeNetworkVolumeActivation::GetMethod(it->second, method)) {
+    return false;
+  }
+
+  if (method == sv4guiPurkinjeNetworkVolumeActivation::Method::None) {
+    return true;
+  }
+  MITK_INFO << msgPrefix << "Volume activation " << it->second;
+
+  double velocity = 0.0;
+  it = parameterValues.find(parameterNames.MyocardialVelocity);
+  if (it != parameterValues.end()) {
+    velocity = std::stod(it->second);
+  }
+
+  if (velocity <= 0.0) {
+    MITK_ERROR << msgPrefix << "The myocardial velocity must be positive.";
+    return false;
+  }
+
+  if (volumeMesh == nullptr) {
+    MITK_ERROR << msgPrefix << "No volume mesh has been loaded.";
+    return false;
+  }
+
+  sv4guiPurkinjeNetworkVolumeActivation volumeActivation(volumeMesh);
+
+  if (method == sv4guiPurkinjeNetworkVolumeActivation::Method::Anisotropic) {
+    double crossFiberVelocity = 0.0;
+    it = parameterValues.find(parameterNames.CrossFiberVelocity);
+    if (it != parameterValues.end()) {
+      crossFiberVelocity = std::stod(it->second);
+    }
+    if (!volumeActivation.SetVelocity(velocity, crossFiberVelocity)) {
+      return false;
+    }
+  } else if (!volumeActivation.SetVelocity(velocity)) {
+    return false;
+  }
+
+  if (pmjCoupling == nullptr) {
+    pmjCoupling.reset(new sv4guiPurkinjeNetworkCoupling(volumeMesh));
+  }
+
+  std::vector<vtkIdType> sourceNodes;
+  std::vector<double> sourceTimes, activationTimes;
+  if (!pmjCoupling->MapEndNodeTimes(network, velocity, sourceNodes, sourceTimes) || 
+      !volumeActivation.ComputeActivationTimes(sourceNodes, sourceTimes, activationTimes)) {
+    return false;
+  }
+
+  auto fileName = filePrefix + "_volume_activation.vtu";
+  if (!volumeActivation.Write(fileName, activationTimes)) {
+    return false;
+  }
+
+  this->volumeActivationFileName = fileName;
+  return true;
+}
+
+//---------------
+// CoupleNetwork
+//---------------
+// Map the end nodes of a network to the volume mesh using the method given 
+// by the 'pmjCoupling' parameter.
+//
+// The coupling matrix is written to 'filePrefix'_pmj.bin. The volume mesh 
+// spatial indexes are built once and reused for all networks.
+
+bool sv4guiPurkinjeNetworkModel::CoupleNetwork(sv4guiPurkinjeNetworkGraph& network, const std::string filePrefix)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkModel::CoupleNetwork] ";
+
+  auto it = parameterValues.find(parameterNames.PmjCoupling);
+  if (it == parameterValues.end()) {
+    return true;
+  }
+
+  sv4guiPurkinjeNetworkCoupling::Method method;
+  if (!sv4guiPurkinjeNetworkCoupling::GetMethod(it->second, method)) {
+    return false;
+  }
+
+  if (method == sv4guiPurkinjeNetworkCoupling::Method::None) {
+    return true;
+  }
+  MITK_INFO << msgPrefix << "PMJ coupling " << it->second;
+
+  if (volumeMesh == nullptr) {
+    MITK_ERROR << msgPrefix << "No volume mesh has been loaded.";
+    return false;
+  }
+
+  if (pmjCoupling == nullptr) {
+    pmjCoupling.reset(new sv4guiPurkinjeNetworkCoupling(volumeMesh));
+  }
+
+  sv4guiPurkinjeNetworkCoupling::Matrix matrix;
+  if (!pmjCoupling->MapEndNodes(network, method, matrix)) {
+    return false;
+  }
+
+  return sv4guiPurkinjeNetworkCoupling::WriteMatrix(filePrefix + "_pmj.bin", matrix);
+}
+
+//---------------
+// SimulateCable
+//---------------
+// Simulate electrical propagation from the root node of a network for the 
+// time given by the 'cableSimulationTime' parameter.
+//
+// Membrane potential and activation time snapshots are written to the 
+// 'filePrefix'_cable_NNNN.vtu files.
+
+bool sv4guiPurkinjeNetworkModel::SimulateCable(sv4guiPurkinjeNetworkGraph& network, const std::string filePrefix)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkModel::SimulateCable] ";
+
+  auto it = parameterValues.find(parameterNames.CableSimulationTime);
+  if (it == parameterValues.end()) {
+    return true;
+  }
+
+  double simulationTime = std::stod(it->second);
+  if (simulationTime <= 0.0) {
+    return true;
+  }
+  MITK_INFO << msgPrefix << "Simulation time " << simulationTime;
+
+  sv4guiPurkinjeNetworkCable::Parameters params;
+  params.endTime = simulationTime;
+
+  sv4guiPurkinjeNetworkCable cable(network);
+  if (!cable.Initialize(params, {network.GetRootNode()})) {
+    return false;
+  }
+
+  return cable.Solve(filePrefix + "_cable");
+}
+
+//------------------
+// PartitionNetwork
+//------------------
+// Partition a network into the number of parts given by the 'numPartitions' 
+// parameter.
+//
+// The part of each node and segment is added to the network as point and cell 
+// data named 'Partition'. The nodes, segments and halo nodes of each part are 
+// written to the 'filePrefix'_partN_*.txt files. 'partitioned' is set to true 
+// if the network was partitioned.
+
+bool sv4guiPurkinjeNetworkModel::PartitionNetwork(sv4guiPurkinjeNetworkGraph& network, const std::string filePrefix, 
+    bool& partitioned)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkModel::PartitionNetwork] ";
+  partitioned = false;
+
+  auto it = parameterValues.find(parameterNames.NumPartitions);
+  if (it == parameterValues.end()) {
+    return true;
+  }
+
+  int numParts = std::stoi(it->second);
+  if (numParts <= 1) {
+    return true;
+  }
+  MITK_INFO << msgPrefix << "Number of partitions " << numParts;
+
+  // Partition() clamps the number of parts to the number of segments and 
+  // returns the number of parts it created.
+  std::vector<int> segmentParts, nodeParts;
+  if (!sv4guiPurkinjeNetworkPartition::Partition(network, numParts, segmentParts, nodeParts)) {
+    return false;
+  }
+
+  std::vector<sv4guiPurkinjeNetworkPartition::Part> parts;
+  sv4guiPurkinjeNetworkPartition::GetParts(network, numParts, segmentParts, nodeParts, parts);
+
+  network.SetPointData("Partition", std::vector<double>(nodeParts.begin(), nodeParts.end()));
+  network.SetCellData("Partition", std::vector<double>(segmentParts.begin(), segmentParts.end()));
+  partitioned = true;
+
+  return sv4guiPurkinjeNetworkPartition::WriteParts(filePrefix, parts);
+}
+
+//----------------------
+// ComputeDistanceField
+//----------------------
+// Compute the signed distance field of the project image used to grow
+// a network when the 'surfaceMapping' parameter is 'implicit'.
+//
+// The region with image values at or above the 'imageIsovalue' parameter 
+// is the inside of the surface. The distance field is written to 
+// 'outputPath'/NAME_sdf.mha.
+
+bool sv4guiPurkinjeNetworkModel::ComputeDistanceField(const std::string outputPath)
+{
+  std::string msgPrefix = "[sv4guiPurkinjeNetworkModel::ComputeDistanceField] ";
+  this->distanceFieldFileName = "";
+
+  auto it = parameterValues.find(parameterNames.SurfaceMapping);
+  if ((it == parameterValues.end()) || (it->second != "implicit")) {
+    return true;
+  }
+
+  if (imageFileName == "") {
+    MITK_ERROR << msgPrefix << "No image has been found for implicit surface growth.";
+    return false;
+  }
+
+  double isovalue = 0.5;
+  it = parameterValues.find(parameterNames.ImageIsovalue);
+  if (it != parameterValues.end()) {
+    isovalue = std::stod(it->second);
+  }
+  MITK_INFO << msgPrefix << "Image " << imageFileName << "  isovalue " << isovalue;
+
+  auto startTime = std::chrono::steady_clock::now();
+  vtkSmartPointer<vtkImageData> image;
+  auto extension = imageFileName.substr(imageFileName.find_last_of(".") + 1);
+  if (extension == "vti") {
+    auto reader = vtkSmartPointer<vtkXMLImageDataReader>::New();
+    reader->SetFileName(imageFileName.c_str());
+    reader->Update();
+    image = reader->GetOutput();
+  } else if (extension == "mha") {
+    auto reader = vtkSmartPointer<vtkMetaImageReader>::New();
+    reader->SetFileName(imageFileName.c_str());
+    reader->Update();
+    image = reader->GetOutput();
+  } else {
+    MITK_ERROR << msgPrefix << "Unsupported image file format " << imageFileName;
+    return false;
+  }
+
+  if ((image == nullptr) || (image->GetNumberOfPoints() == 0)) {
+    MITK_ERROR << msgPrefix << "Unable to read the image " << imageFileName;
+    return false;
+  }
+
+  auto itkImage = sv4guiPurkinjeNetworkUtils::vtkImageToItkImage(image);
+  auto distance = sv4guiPurkinjeNetworkUtils::signedDistance(itkImage, isovalue);
+  auto fileName = outputPath + "/" + this->name + "_sdf.mha";
+  sv4guiPurkinjeNetworkUtils::writeMHA(distance, fileName);
+  this->distanceFieldFileName = fileName;
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+  MITK_INFO << msgPrefix << "Distance field " << fileName << "  time " << elapsed.count() << " s";
   return true;
 }
 
@@ -138,6 +1284,8 @@ std::string sv4guiPurkinjeNetworkModel::CreateCommand(const std::string infile,
   auto num_branch_gen = parameterValues[parameterNames.NumBranchGenerations];
   auto repulsive_parameter = parameterValues[parameterNames.RepulsiveParameter];
   auto second_node = parameterValues[parameterNames.SecondPoint];
+  auto time_budget = parameterValues[parameterNames.TimeBudget];
+  auto surface_mapping = parameterValues[parameterNames.SurfaceMapping];
 
   // Create the command to generate the network.
   //
@@ -155,6 +1303,15 @@ std::string sv4guiPurkinjeNetworkModel::CreateCommand(const std::string infile,
   cmd += "branch_seg_length='" + branch_seg_length + "',";
   cmd += "num_branch_gen='" + num_branch_gen + "',";
   cmd += "repulsive_parameter='" + repulsive_parameter + "'";
+  if (time_budget != "") {
+    cmd += ",time_budget='" + time_budget + "'";
+  }
+  if (surface_mapping != "") {
+    cmd += ",surface_mapping='" + surface_mapping + "'";
+  }
+  if (distanceFieldFileName != "") {
+    cmd += ",sdf_file='" + distanceFieldFileName + "'";
+  }
   cmd += ")\n"; 
 
   return cmd;
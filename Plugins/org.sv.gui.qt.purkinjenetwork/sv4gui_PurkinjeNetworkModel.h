@@ -35,36 +35,83 @@
 //   1) Surface mesh on which the network is generated
 //   2) Parameters used to generate the mesh
 //   3) 1D element mesh representing the network
+//   4) Activation times of the network, surface mesh and volume mesh
 
 #ifndef SV4GUI_PURKINJENETWORK_MODEL_H
 #define SV4GUI_PURKINJENETWORK_MODEL_H
 
 #include <iostream>
 #include <array>
+#include <memory>
 #include <set>
 
+#include "sv4gui_PurkinjeNetworkCoupling.h"
+#include "sv4gui_PurkinjeNetworkGraph.h"
+#include "sv4gui_PurkinjeNetworkSegmentTree.h"
+
 #include <vtkPolyData.h>
 #include <vtkSmartPointer.h>
+#include <vtkUnstructuredGrid.h>
 
 class sv4guiPurkinjeNetworkModelParamNames
 { 
   public: 
     sv4guiPurkinjeNetworkModelParamNames() {
+      allNames.insert(ActivationSources);
+      allNames.insert(AttractorSpacing);
       allNames.insert(AvgBranchLength);
       allNames.insert(BranchAngle);
       allNames.insert(BranchSegLength);
+      allNames.insert(CableSimulationTime);
+      allNames.insert(CalibrationEvaluations);
+      allNames.insert(CalibrationMetric);
+      allNames.insert(CalibrationTarget);
+      allNames.insert(ConductionVelocity);
+      allNames.insert(CoverageDistance);
+      allNames.insert(CrossFiberVelocity);
       allNames.insert(FirstPoint);
+      allNames.insert(GrowthAlgorithm);
+      allNames.insert(ImageIsovalue);
+      allNames.insert(MyocardialVelocity);
+      allNames.insert(NodeOrdering);
       allNames.insert(NumBranchGenerations);
+      allNames.insert(NumPartitions);
+      allNames.insert(PmjCoupling);
+      allNames.insert(PreviewReduction);
       allNames.insert(RepulsiveParameter);
+      allNames.insert(ResampleElementSize);
       allNames.insert(SecondPoint);
+      allNames.insert(SurfaceMapping);
+      allNames.insert(TimeBudget);
+      allNames.insert(VolumeActivation);
     }
+    const std::string ActivationSources = "activationSources";
+    const std::string AttractorSpacing = "attractorSpacing";
     const std::string AvgBranchLength = "avgBranchLength";
     const std::string BranchAngle = "branchAngle";
     const std::string BranchSegLength = "branchSegLength";
+    const std::string CableSimulationTime = "cableSimulationTime";
+    const std::string CalibrationEvaluations = "calibrationEvaluations";
+    const std::string CalibrationMetric = "calibrationMetric";
+    const std::string CalibrationTarget = "calibrationTarget";
+    const std::string ConductionVelocity = "conductionVelocity";
+    const std::string CoverageDistance = "coverageDistance";
+    const std::string CrossFiberVelocity = "crossFiberVelocity";
     const std::string FirstPoint = "firstPoint";
+    const std::string GrowthAlgorithm = "growthAlgorithm";
+    const std::string ImageIsovalue = "imageIsovalue";
+    const std::string MyocardialVelocity = "myocardialVelocity";
+    const std::string NodeOrdering = "nodeOrdering";
     const std::string NumBranchGenerations = "numBranchGenerations";
+    const std::string NumPartitions = "numPartitions";
+    const std::string PmjCoupling = "pmjCoupling";
+    const std::string PreviewReduction = "previewReduction";
     const std::string RepulsiveParameter = "repulsiveParameter";
+    const std::string ResampleElementSize = "resampleElementSize";
     const std::string SecondPoint = "secondPoint";
+    const std::string SurfaceMapping = "surfaceMapping";
+    const std::string TimeBudget = "timeBudget";
+    const std::string VolumeActivation = "volumeActivation";
     std::set<std::string> allNames;
 };
 
@@ -76,6 +123,32 @@ class sv4guiPurkinjeNetworkModel
     sv4guiPurkinjeNetworkModel() = delete; 
     ~sv4guiPurkinjeNetworkModel(); 
     bool GenerateNetwork(const std::string outputPath);
+    bool CompleteNetwork(const std::string outputPath);
+    bool GeneratePreview(const std::string outputPath);
+    bool GrowNetwork(vtkPolyData* surface, const std::string meshFileName, const std::string outfile);
+    bool GrowColonizationNetwork(vtkPolyData* surface, const std::string outfile);
+    bool GetColonizationParameters(double& spacing, double& segmentLength);
+    bool GetBranchSubtree(const sv4guiPurkinjeNetworkGraph& network, const sv4guiPurkinjeNetworkGraph::Branch& branch,
+        int& startNode, std::vector<int>& nodes, std::vector<int>& segments);
+    bool RemoveBranch(const sv4guiPurkinjeNetworkGraph& network, const sv4guiPurkinjeNetworkGraph::Branch& branch,
+        sv4guiPurkinjeNetworkGraph::Change& change);
+    bool RegrowBranch(const sv4guiPurkinjeNetworkGraph& network, const sv4guiPurkinjeNetworkSegmentTree& segmentTree,
+        const sv4guiPurkinjeNetworkGraph::Branch& branch, sv4guiPurkinjeNetworkGraph::Change& change);
+    bool UseSpaceColonization();
+    bool ProjectNetwork(sv4guiPurkinjeNetworkGraph& network, vtkPolyData* surface);
+    bool ProcessNetwork(const std::string outputPath);
+    bool GetNetworkComplete();
+    bool CalibrateParameters(const std::string infile, const std::string outfile);
+    bool CoupleNetwork(sv4guiPurkinjeNetworkGraph& network, const std::string filePrefix);
+    bool ComputeActivation(sv4guiPurkinjeNetworkGraph& network, bool& activated);
+    bool ComputeDistanceField(const std::string outputPath);
+    bool ComputeCoverage(const sv4guiPurkinjeNetworkGraph& network, const std::string filePrefix);
+    bool ComputeSurfaceActivation(const sv4guiPurkinjeNetworkGraph& network, const std::string filePrefix);
+    bool ComputeVolumeActivation(const sv4guiPurkinjeNetworkGraph& network, const std::string filePrefix);
+    bool PartitionNetwork(sv4guiPurkinjeNetworkGraph& network, const std::string filePrefix, bool& partitioned);
+    bool ReorderNetwork(sv4guiPurkinjeNetworkGraph& network, const std::string filePrefix, bool& reordered);
+    bool ResampleNetwork(sv4guiPurkinjeNetworkGraph& network, const std::string outputPath);
+    bool SimulateCable(sv4guiPurkinjeNetworkGraph& network, const std::string filePrefix);
     bool WriteMesh(const std::string fileName);
     std::string CreateCommand(const std::string infile, const std::string outfile);
     void SetParameters(std::map<std::string, std::string>& params);
@@ -83,6 +156,16 @@ class sv4guiPurkinjeNetworkModel
 
     std::string name; 
     std::string networkFileName; 
+    std::string resampledNetworkFileName; 
+    std::string surfaceActivationFileName; 
+    std::string volumeActivationFileName; 
+    std::string coverageFileName; 
+    std::string coverageReport; 
+    std::string calibratedParameterFileName; 
+    std::string previewNetworkFileName; 
+    std::string imageFileName; 
+    std::string distanceFieldFileName; 
+    bool networkComplete; 
     std::array<double,3> firstPoint;
     std::array<double,3> secondPoint;
     /*
@@ -93,6 +176,8 @@ class sv4guiPurkinjeNetworkModel
     float branchSegLength;
     */
     vtkSmartPointer<vtkPolyData> meshPolyData;
+    vtkSmartPointer<vtkUnstructuredGrid> volumeMesh;
+    std::unique_ptr<sv4guiPurkinjeNetworkCoupling> pmjCoupling;
     sv4guiPurkinjeNetworkModelParamNames parameterNames;
     std::map<std::string, std::string> parameterValues;
 };